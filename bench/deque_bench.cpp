@@ -0,0 +1,117 @@
+#include "scheduler/work_stealing_queue.hpp"
+#include "scheduler/mutex_work_stealing_queue.hpp"
+
+#include <iostream>
+#include <iomanip>
+#include <chrono>
+#include <thread>
+#include <vector>
+#include <atomic>
+#include <string>
+#include <cstdint>
+#include <cstdlib>
+
+using namespace para;
+using namespace std::chrono;
+
+/**
+ * Deque micro-benchmark
+ *
+ * Compares the lock-free WorkStealingQueue against the original
+ * MutexWorkStealingQueue on the scheduler's access pattern:
+ * one owner pushing/popping at the back while N thieves steal from the front.
+ *
+ * Usage: deque_bench [opsPerRun] [maxThieves]
+ */
+
+struct DequeResult {
+    double nsPerOp;
+    size_t ownerPops;
+    size_t steals;
+};
+
+template<typename Queue>
+DequeResult runDequeBenchmark(size_t numOps, size_t numThieves) {
+    Queue queue;
+    std::atomic<bool> done{false};
+    std::atomic<size_t> steals{0};
+
+    std::vector<std::thread> thieves;
+    for (size_t i = 0; i < numThieves; ++i) {
+        thieves.emplace_back([&]() {
+            size_t local = 0;
+            while (!done.load(std::memory_order_relaxed)) {
+                if (queue.tryPopFront()) {
+                    ++local;
+                } else {
+                    std::this_thread::yield();
+                }
+            }
+            steals.fetch_add(local, std::memory_order_relaxed);
+        });
+    }
+
+    // Owner: push a small burst then pop it back, like a task spawning children
+    constexpr uintptr_t BURST = 8;
+    size_t ownerPops = 0;
+
+    auto start = high_resolution_clock::now();
+    for (size_t i = 0; i < numOps; i += BURST) {
+        for (uintptr_t j = 0; j < BURST; ++j) {
+            queue.pushBack(j + 1);
+        }
+        for (uintptr_t j = 0; j < BURST; ++j) {
+            if (queue.tryPopBack()) {
+                ++ownerPops;
+            }
+        }
+    }
+    auto end = high_resolution_clock::now();
+
+    done.store(true, std::memory_order_relaxed);
+    for (auto& t : thieves) {
+        t.join();
+    }
+
+    // Drain leftovers so every pushed item is accounted for
+    while (queue.tryPopBack()) {
+        ++ownerPops;
+    }
+
+    DequeResult result;
+    result.nsPerOp = duration_cast<nanoseconds>(end - start).count() / static_cast<double>(numOps * 2);
+    result.ownerPops = ownerPops;
+    result.steals = steals.load();
+    return result;
+}
+
+void printSeparator() {
+    std::cout << std::string(66, '=') << std::endl;
+}
+
+int main(int argc, char** argv) {
+    size_t numOps = argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 4000000;
+    size_t maxThieves = argc > 2 ? std::strtoull(argv[2], nullptr, 10) : 3;
+
+    std::cout << std::fixed << std::setprecision(2);
+
+    printSeparator();
+    std::cout << "  DEQUE BENCHMARK - Chase-Lev vs Mutex (" << numOps << " push+pop)" << std::endl;
+    printSeparator();
+
+    std::cout << "\n  Thieves | Queue      | ns/op | Owner Pops | Steals" << std::endl;
+    std::cout << "  --------|------------|-------|------------|-----------" << std::endl;
+
+    for (size_t thieves = 0; thieves <= maxThieves; ++thieves) {
+        DequeResult lockFree = runDequeBenchmark<WorkStealingQueue<uintptr_t>>(numOps, thieves);
+        DequeResult locked = runDequeBenchmark<MutexWorkStealingQueue<uintptr_t>>(numOps, thieves);
+
+        std::cout << "  " << std::setw(7) << thieves << " | Chase-Lev  | " << std::setw(5) << lockFree.nsPerOp
+                  << " | " << std::setw(10) << lockFree.ownerPops << " | " << lockFree.steals << std::endl;
+        std::cout << "  " << std::setw(7) << thieves << " | Mutex      | " << std::setw(5) << locked.nsPerOp
+                  << " | " << std::setw(10) << locked.ownerPops << " | " << locked.steals << std::endl;
+    }
+
+    std::cout << std::endl;
+    return 0;
+}
@@ -0,0 +1,644 @@
+#include "benchmark/benchmark.hpp"
+#include "benchmark/traffic.hpp"
+#include "common/data_structures.hpp"
+
+#include <iostream>
+#include <iomanip>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <cmath>
+#include <cstdlib>
+#include <algorithm>
+#include <atomic>
+#include <memory>
+#include <stdexcept>
+
+using namespace para;
+
+/**
+ * Pipeline benchmark harness
+ *
+ * Scriptable version of the demo in main.cpp: the workload shape comes
+ * from the command line, each (mode, threads) case runs warmup rounds
+ * then N timed repetitions, and the summary (mean / stddev / min of the
+ * run time) goes to stdout and optionally to CSV (appended, so one file
+ * can track a series of commits) and JSON.
+ *
+ * The traffic is generated once, in parallel, before any case runs (and
+ * timed separately); every case replays it. The trace mode instead
+ * replays a recorded input trace (--replay-trace), e.g. one captured in
+ * production or by --record-trace, into an event-scheduled server. The
+ * udp mode sends live ClientManager traffic over loopback to a UdpIngest
+ * (Linux only) and also reports datagram rate, loss and receive latency.
+ *
+ * Usage: pipeline_bench [options]
+ *   --matches N            matches (default 20)
+ *   --clients N            clients (default 40, two per match)
+ *   --inputs N             inputs per client (default 10000)
+ *   --batch N              inputs per client batch, at most INPUT_DEADLINE_TICKS (default 50)
+ *   --threads A,B,...      pool sizes for the parallel modes (default 2,4,8)
+ *   --modes M,...          sequential, pipeline, direct, sharded, trace, udp (default all but trace, udp)
+ *   --shards N             shards for the sharded mode, 0 = one per NUMA node (default 0)
+ *   --rollback-interval N  ticks between demo rollbacks, 0 = none (default 5)
+ *   --late-ratio F         fraction of inputs sent past their deadline (default 0)
+ *   --warmup N             untimed runs per case (default 1)
+ *   --reps N               timed runs per case (default 5)
+ *   --csv PATH             append one row per case
+ *   --json PATH            write all cases as one JSON document
+ *   --label TEXT           tag stored with each row (e.g. a commit hash)
+ *   --traffic PATH         stream the generated traffic into a memory-mapped file
+ *   --record-trace PATH    record one pipeline run (first --threads entry) as a trace
+ *   --replay-trace PATH    trace for the trace mode (adds the mode if not listed)
+ *   --replay-speed F       trace pacing: 1 = recorded speed, F times it, 0 = flat out (default 0)
+ *   --adaptive-batch 0|1   adaptive client sends and drain quanta (default 0)
+ *   --target-latency-us N  adaptive latency budget per drain / client wait (default 250)
+ *   --target-depth N       match queue depth clients back off above (default 1024)
+ *   --max-batch N          largest adaptive send / drain quantum (default 4096)
+ *   --snapshots P          match snapshot policy: full, delta or paged (default full)
+ *   --sync-check 0|1       compare every case's state hashes with a sequential run (default 0)
+ *   --io-threads N         udp mode: sending and receiving threads (default 1)
+ *   --udp-rate F           udp mode: total datagrams per second, 0 = unpaced (default 0)
+ *
+ * With --sync-check, an untimed sequential run first records every tick's
+ * state hash, standing in for the clients. Every case then checks its
+ * matches against it at each final SYNC_TICK and bisects a mismatch to
+ * the first tick that differs. Trace replays are not checked.
+ */
+
+struct HarnessOptions {
+    BenchmarkConfig config;
+    std::vector<size_t> threads = {2, 4, 8};
+    std::vector<std::string> modes = {"sequential", "pipeline", "direct", "sharded"};
+    int warmup = 1;
+    int reps = 5;
+    std::string csvPath;
+    std::string jsonPath;
+    std::string label;
+    std::string trafficPath;
+    std::string recordTracePath;
+    std::string replayTracePath;
+    double replaySpeed = InputTraceReplayer::AS_FAST_AS_POSSIBLE;
+    bool syncCheck = false;
+    int ioThreads = 1;
+    double udpRate = 0.0;
+};
+
+/**
+ * --sync-check reference: per match, the hash of every tick of the
+ * sequential run. Each match's entries are only touched by the thread
+ * processing that match, so the hooks take no lock
+ */
+class SyncReference {
+public:
+    explicit SyncReference(int numMatches)
+        : hashes_(numMatches), firstDivergence_(numMatches, -1) {}
+
+    // Hook for the reference run: keep the hashes of each interval
+    SyncHook recorder() {
+        return [this](const SyncPoint& point) {
+            std::vector<uint64_t>& hashes = hashes_[point.matchId];
+            if (hashes.size() <= static_cast<size_t>(point.tick)) {
+                hashes.resize(point.tick + 1, 0);
+            }
+            for (int tick = std::max(0, point.tick - SYNC_TICK_INTERVAL); tick <= point.tick; ++tick) {
+                if (point.history->contains(tick)) {
+                    hashes[tick] = point.history->at(tick);
+                }
+            }
+        };
+    }
+
+    // Hook for the checked runs: compare, and bisect a match's first mismatch
+    SyncHook checker() {
+        return [this](const SyncPoint& point) {
+            const std::vector<uint64_t>& expected = hashes_[point.matchId];
+            int& first = firstDivergence_[point.matchId];
+            if (static_cast<size_t>(point.tick) >= expected.size()) return;
+            checks_.fetch_add(1, std::memory_order_relaxed);
+
+            // Once diverged the chained hash keeps differing: report it once
+            if (first >= 0 || point.hash == expected[point.tick]) return;
+            first = point.history->firstDivergence(point.tick - SYNC_TICK_INTERVAL, point.tick,
+                                                   [&expected](int tick) { return expected[tick]; });
+            if (first < 0) first = point.tick;
+            desynced_.fetch_add(1, std::memory_order_relaxed);
+        };
+    }
+
+    // Before each checked run
+    void reset() {
+        checks_.store(0, std::memory_order_relaxed);
+        desynced_.store(0, std::memory_order_relaxed);
+        std::fill(firstDivergence_.begin(), firstDivergence_.end(), -1);
+    }
+
+    size_t checks() const { return checks_.load(std::memory_order_relaxed); }
+    int desyncedMatches() const { return desynced_.load(std::memory_order_relaxed); }
+
+    // Earliest first diverging tick over all matches (-1: in sync)
+    int firstDivergingTick() const {
+        int earliest = -1;
+        for (int tick : firstDivergence_) {
+            if (tick >= 0 && (earliest < 0 || tick < earliest)) earliest = tick;
+        }
+        return earliest;
+    }
+
+private:
+    std::vector<std::vector<uint64_t>> hashes_;
+    std::vector<int> firstDivergence_;
+    std::atomic<size_t> checks_{0};
+    std::atomic<int> desynced_{0};
+};
+
+// What the cases replay: generated traffic, a recorded trace, or both
+struct Workload {
+    const PregeneratedTraffic* traffic = nullptr;
+    const InputTraceReplayer* trace = nullptr;
+    SyncReference* sync = nullptr;   // --sync-check: reference to check against
+};
+
+struct CaseSummary {
+    std::string mode;
+    size_t threads;
+    double meanMs;
+    double stddevMs;
+    double minMs;
+    double inputsPerSec;  // At the mean time
+    size_t processedInputs;
+    int rollbacks;
+    int lateInputs;
+    int expiredInputs;         // Too late for a rollback
+    double producerBatchMean;  // Adaptive batching, from the last rep
+    double drainQuantumMean;
+    size_t syncChecks;         // --sync-check, from the last rep
+    int desyncedMatches;
+    int firstDesyncTick;       // -1: in sync
+    double udpDatagramsPerSec; // udp mode, from the last rep
+    uint64_t udpLostDatagrams;
+    size_t udpDroppedInputs;
+    double udpLatencyP50Us;
+    double udpLatencyP99Us;
+    double udpPerReceiveCall;  // Datagrams per recvmmsg call
+};
+
+void printUsage() {
+    std::cout << "Usage: pipeline_bench [--matches N] [--clients N] [--inputs N] [--batch N]\n"
+              << "                      [--threads A,B,...] [--modes sequential,pipeline,direct,sharded,trace,udp]\n"
+              << "                      [--rollback-interval N] [--late-ratio F] [--shards N]\n"
+              << "                      [--warmup N] [--reps N] [--csv PATH] [--json PATH] [--label TEXT]\n"
+              << "                      [--traffic PATH] [--record-trace PATH]\n"
+              << "                      [--replay-trace PATH] [--replay-speed F]\n"
+              << "                      [--adaptive-batch 0|1] [--target-latency-us N] [--target-depth N]\n"
+              << "                      [--max-batch N] [--snapshots full|delta|paged] [--sync-check 0|1]\n"
+              << "                      [--io-threads N] [--udp-rate F]"
+              << std::endl;
+}
+
+std::vector<std::string> splitList(const std::string& text) {
+    std::vector<std::string> items;
+    std::stringstream stream(text);
+    std::string item;
+    while (std::getline(stream, item, ',')) {
+        if (!item.empty()) items.push_back(item);
+    }
+    return items;
+}
+
+bool parseInt(const std::string& text, int& value) {
+    char* end = nullptr;
+    long parsed = std::strtol(text.c_str(), &end, 10);
+    if (end == text.c_str() || *end != '\0') return false;
+    value = static_cast<int>(parsed);
+    return true;
+}
+
+bool parseDouble(const std::string& text, double& value) {
+    char* end = nullptr;
+    value = std::strtod(text.c_str(), &end);
+    return end != text.c_str() && *end == '\0';
+}
+
+bool parseOptions(int argc, char** argv, HarnessOptions& options) {
+    for (int i = 1; i < argc; ++i) {
+        std::string flag = argv[i];
+        if (flag == "--help" || flag == "-h") return false;
+        if (i + 1 >= argc) {
+            std::cerr << "Missing value for " << flag << std::endl;
+            return false;
+        }
+        std::string value = argv[++i];
+
+        bool ok = true;
+        if (flag == "--matches") ok = parseInt(value, options.config.numMatches);
+        else if (flag == "--clients") ok = parseInt(value, options.config.numClients);
+        else if (flag == "--inputs") ok = parseInt(value, options.config.inputsPerClient);
+        else if (flag == "--batch") ok = parseInt(value, options.config.batchSize);
+        else if (flag == "--rollback-interval") ok = parseInt(value, options.config.rollbackInterval);
+        else if (flag == "--shards") ok = parseInt(value, options.config.numShards);
+        else if (flag == "--warmup") ok = parseInt(value, options.warmup);
+        else if (flag == "--reps") ok = parseInt(value, options.reps);
+        else if (flag == "--late-ratio") ok = parseDouble(value, options.config.lateRatio);
+        else if (flag == "--replay-speed") ok = parseDouble(value, options.replaySpeed);
+        else if (flag == "--io-threads") ok = parseInt(value, options.ioThreads);
+        else if (flag == "--udp-rate") ok = parseDouble(value, options.udpRate);
+        else if (flag == "--adaptive-batch") {
+            int enabled = 0;
+            ok = parseInt(value, enabled) && (enabled == 0 || enabled == 1);
+            options.config.adaptiveBatching = enabled == 1;
+        } else if (flag == "--sync-check") {
+            int enabled = 0;
+            ok = parseInt(value, enabled) && (enabled == 0 || enabled == 1);
+            options.syncCheck = enabled == 1;
+        } else if (flag == "--target-latency-us" || flag == "--target-depth" || flag == "--max-batch") {
+            int amount = 0;
+            ok = parseInt(value, amount) && amount > 0;
+            BatchTargets& targets = options.config.batchTargets;
+            if (flag == "--target-latency-us") targets.latencyNs = static_cast<uint64_t>(amount) * 1000;
+            else if (flag == "--target-depth") targets.queueDepth = static_cast<size_t>(amount);
+            else targets.maxSize = static_cast<size_t>(amount);
+        }
+        else if (flag == "--threads") {
+            options.threads.clear();
+            for (const std::string& item : splitList(value)) {
+                int count = 0;
+                if (!parseInt(item, count) || count <= 0) {
+                    ok = false;
+                    break;
+                }
+                options.threads.push_back(static_cast<size_t>(count));
+            }
+        } else if (flag == "--modes") {
+            options.modes = splitList(value);
+            for (const std::string& mode : options.modes) {
+                if (mode != "sequential" && mode != "pipeline" && mode != "direct" && mode != "sharded" &&
+                    mode != "trace" && mode != "udp") ok = false;
+            }
+        } else if (flag == "--csv") options.csvPath = value;
+        else if (flag == "--json") options.jsonPath = value;
+        else if (flag == "--label") options.label = value;
+        else if (flag == "--traffic") options.trafficPath = value;
+        else if (flag == "--record-trace") options.recordTracePath = value;
+        else if (flag == "--replay-trace") options.replayTracePath = value;
+        else if (flag == "--snapshots") {
+            if (value == "full") options.config.snapshotPolicy = SnapshotPolicy::FULL;
+            else if (value == "delta") options.config.snapshotPolicy = SnapshotPolicy::DELTA;
+            else if (value == "paged") options.config.snapshotPolicy = SnapshotPolicy::PAGED;
+            else ok = false;
+        } else {
+            std::cerr << "Unknown option " << flag << std::endl;
+            return false;
+        }
+
+        if (!ok) {
+            std::cerr << "Bad value for " << flag << ": " << value << std::endl;
+            return false;
+        }
+    }
+    if (!options.replayTracePath.empty() &&
+        std::find(options.modes.begin(), options.modes.end(), "trace") == options.modes.end()) {
+        options.modes.push_back("trace");
+    }
+    return true;
+}
+
+bool needsTraffic(const HarnessOptions& options) {
+    for (const std::string& mode : options.modes) {
+        if (mode != "trace" && mode != "udp") return true;
+        if (mode == "udp" && options.syncCheck) return true;  // For the reference run
+    }
+    return !options.recordTracePath.empty();
+}
+
+bool validate(const HarnessOptions& options) {
+    const BenchmarkConfig& config = options.config;
+    if (config.numMatches <= 0 || config.numMatches > PackedInput::MAX_MATCHES) {
+        std::cerr << "--matches must be in 1.." << PackedInput::MAX_MATCHES << std::endl;
+        return false;
+    }
+    if (config.numClients <= 0 || config.inputsPerClient <= 0 || config.batchSize <= 0) {
+        std::cerr << "--clients, --inputs and --batch must be positive" << std::endl;
+        return false;
+    }
+    if (config.rollbackInterval < 0 || config.lateRatio < 0.0 || config.lateRatio > 1.0) {
+        std::cerr << "--rollback-interval must be >= 0 and --late-ratio in [0, 1]" << std::endl;
+        return false;
+    }
+    if (config.batchSize > INPUT_DEADLINE_TICKS) {
+        // One longer batch runs its player past the deadline by itself: the
+        // partner's inputs would turn late (or expire) without being late
+        std::cerr << "--batch must be <= " << INPUT_DEADLINE_TICKS << std::endl;
+        return false;
+    }
+    if (config.numShards < 0) {
+        std::cerr << "--shards must be >= 0" << std::endl;
+        return false;
+    }
+    if (options.threads.empty()) {
+        std::cerr << "--threads needs at least one pool size" << std::endl;
+        return false;
+    }
+    if (options.reps <= 0 || options.warmup < 0) {
+        std::cerr << "--reps must be positive and --warmup >= 0" << std::endl;
+        return false;
+    }
+    bool trace = std::find(options.modes.begin(), options.modes.end(), "trace") != options.modes.end();
+    if (trace && options.replayTracePath.empty()) {
+        std::cerr << "trace mode needs --replay-trace" << std::endl;
+        return false;
+    }
+    if (options.replaySpeed < 0.0) {
+        std::cerr << "--replay-speed must be >= 0" << std::endl;
+        return false;
+    }
+    bool udp = std::find(options.modes.begin(), options.modes.end(), "udp") != options.modes.end();
+    if (udp && !UdpIngest::isSupported()) {
+        std::cerr << "udp mode needs Linux (epoll, recvmmsg)" << std::endl;
+        return false;
+    }
+    if (options.ioThreads <= 0 || options.udpRate < 0.0) {
+        std::cerr << "--io-threads must be positive and --udp-rate >= 0" << std::endl;
+        return false;
+    }
+    bool direct = std::find(options.modes.begin(), options.modes.end(), "direct") != options.modes.end();
+    if (direct && config.numClients > config.numMatches * PLAYERS_PER_MATCH) {
+        std::cerr << "direct mode needs at most one client per player (--clients <= 2 * --matches)" << std::endl;
+        return false;
+    }
+    return true;
+}
+
+BenchmarkResult runOnce(const HarnessOptions& options, const Workload& workload,
+                        const std::string& mode, size_t threads, UdpLoadStats* udpStats = nullptr) {
+    if (mode == "trace") {
+        BenchmarkConfig unchecked = options.config;
+        unchecked.syncHook = SyncHook();
+        return runTraceReplayBenchmark(unchecked, *workload.trace, threads, options.replaySpeed);
+    }
+    if (workload.sync) {
+        workload.sync->reset();
+    }
+    if (mode == "sequential") {
+        return runSequentialBenchmark(options.config, *workload.traffic);
+    }
+    if (mode == "udp") {
+        return runUdpLoopbackBenchmark(options.config, threads, options.ioThreads, options.udpRate, udpStats);
+    }
+    if (mode == "sharded") {
+        return runShardedBenchmark(options.config, *workload.traffic, threads);
+    }
+    return runConcurrentBenchmark(options.config, *workload.traffic, threads, mode == "direct");
+}
+
+CaseSummary runCase(const HarnessOptions& options, const Workload& workload,
+                    const std::string& mode, size_t threads) {
+    for (int i = 0; i < options.warmup; ++i) {
+        runOnce(options, workload, mode, threads);
+    }
+
+    std::vector<double> times;
+    BenchmarkResult last = {};
+    UdpLoadStats udp = {};
+    for (int i = 0; i < options.reps; ++i) {
+        last = runOnce(options, workload, mode, threads, &udp);
+        times.push_back(last.timeMs);
+    }
+
+    double mean = 0.0;
+    for (double t : times) mean += t;
+    mean /= times.size();
+
+    double variance = 0.0;
+    for (double t : times) variance += (t - mean) * (t - mean);
+    double stddev = times.size() > 1 ? std::sqrt(variance / (times.size() - 1)) : 0.0;
+
+    CaseSummary summary;
+    summary.mode = mode;
+    summary.threads = threads;
+    summary.meanMs = mean;
+    summary.stddevMs = stddev;
+    summary.minMs = *std::min_element(times.begin(), times.end());
+    summary.inputsPerSec = mean > 0.0 ? last.processedInputs / mean * 1000.0 : 0.0;
+    summary.processedInputs = last.processedInputs;
+    summary.rollbacks = last.rollbackCount;
+    summary.lateInputs = last.lateInputs;
+    summary.expiredInputs = last.expiredInputs;
+    summary.producerBatchMean = last.producerBatches.mean();
+    summary.drainQuantumMean = last.drainQuanta.mean();
+    bool checked = workload.sync && mode != "trace";
+    summary.syncChecks = checked ? workload.sync->checks() : 0;
+    summary.desyncedMatches = checked ? workload.sync->desyncedMatches() : 0;
+    summary.firstDesyncTick = checked ? workload.sync->firstDivergingTick() : -1;
+    summary.udpDatagramsPerSec = udp.sent.elapsedMs > 0.0 ? udp.received.datagrams / udp.sent.elapsedMs * 1000.0 : 0.0;
+    summary.udpLostDatagrams = udp.sent.datagrams - udp.received.datagrams;
+    summary.udpDroppedInputs = udp.droppedInputs;
+    summary.udpLatencyP50Us = udp.received.latencyNs.percentile(0.50) / 1000.0;
+    summary.udpLatencyP99Us = udp.received.latencyNs.percentile(0.99) / 1000.0;
+    summary.udpPerReceiveCall = udp.received.receiveCalls
+        ? static_cast<double>(udp.received.datagrams) / udp.received.receiveCalls : 0.0;
+    return summary;
+}
+
+void writeCsv(const HarnessOptions& options, double generationMs, const std::vector<CaseSummary>& cases) {
+    bool fresh = true;
+    {
+        std::ifstream existing(options.csvPath);
+        fresh = !existing.good() || existing.peek() == std::ifstream::traits_type::eof();
+    }
+
+    std::ofstream out(options.csvPath, std::ios::app);
+    if (!out) {
+        std::cerr << "Cannot write " << options.csvPath << std::endl;
+        return;
+    }
+    out << std::fixed << std::setprecision(4);
+    if (fresh) {
+        out << "label,mode,threads,matches,clients,inputs_per_client,batch,rollback_interval,late_ratio,"
+               "reps,mean_ms,stddev_ms,min_ms,inputs_per_sec,processed,rollbacks,late_inputs,generation_ms\n";
+    }
+
+    const BenchmarkConfig& config = options.config;
+    for (const CaseSummary& c : cases) {
+        out << options.label << "," << c.mode << "," << c.threads << ","
+            << config.numMatches << "," << config.numClients << "," << config.inputsPerClient << ","
+            << config.batchSize << "," << config.rollbackInterval << "," << config.lateRatio << ","
+            << options.reps << "," << c.meanMs << "," << c.stddevMs << "," << c.minMs << ","
+            << c.inputsPerSec << "," << c.processedInputs << "," << c.rollbacks << "," << c.lateInputs << ","
+            << generationMs << "\n";
+    }
+}
+
+void writeJson(const HarnessOptions& options, double generationMs, const std::vector<CaseSummary>& cases) {
+    std::ofstream out(options.jsonPath);
+    if (!out) {
+        std::cerr << "Cannot write " << options.jsonPath << std::endl;
+        return;
+    }
+
+    const BenchmarkConfig& config = options.config;
+    out << std::fixed << std::setprecision(4);
+    out << "{\n  \"label\": \"" << options.label << "\",\n"
+        << "  \"config\": {\"matches\": " << config.numMatches << ", \"clients\": " << config.numClients
+        << ", \"inputs_per_client\": " << config.inputsPerClient << ", \"batch\": " << config.batchSize
+        << ", \"rollback_interval\": " << config.rollbackInterval << ", \"late_ratio\": " << config.lateRatio
+        << ", \"shards\": " << config.numShards
+        << ", \"adaptive_batch\": " << (config.adaptiveBatching ? "true" : "false")
+        << ", \"target_latency_us\": " << config.batchTargets.latencyNs / 1000
+        << ", \"target_depth\": " << config.batchTargets.queueDepth
+        << ", \"max_batch\": " << config.batchTargets.maxSize
+        << ", \"snapshots\": \"" << snapshotPolicyName(config.snapshotPolicy) << "\""
+        << ", \"sync_check\": " << (options.syncCheck ? "true" : "false")
+        << ", \"warmup\": " << options.warmup << ", \"reps\": " << options.reps << "},\n"
+        << "  \"generation_ms\": " << generationMs << ",\n"
+        << "  \"results\": [\n";
+    for (size_t i = 0; i < cases.size(); ++i) {
+        const CaseSummary& c = cases[i];
+        out << "    {\"mode\": \"" << c.mode << "\", \"threads\": " << c.threads
+            << ", \"mean_ms\": " << c.meanMs << ", \"stddev_ms\": " << c.stddevMs
+            << ", \"min_ms\": " << c.minMs << ", \"inputs_per_sec\": " << c.inputsPerSec
+            << ", \"processed\": " << c.processedInputs << ", \"rollbacks\": " << c.rollbacks
+            << ", \"late_inputs\": " << c.lateInputs << ", \"expired_inputs\": " << c.expiredInputs
+            << ", \"producer_batch_mean\": " << c.producerBatchMean
+            << ", \"drain_quantum_mean\": " << c.drainQuantumMean
+            << ", \"sync_checks\": " << c.syncChecks << ", \"desynced_matches\": " << c.desyncedMatches
+            << ", \"first_desync_tick\": " << c.firstDesyncTick
+            << ", \"udp_datagrams_per_sec\": " << c.udpDatagramsPerSec << ", \"udp_lost_datagrams\": " << c.udpLostDatagrams
+            << ", \"udp_dropped_inputs\": " << c.udpDroppedInputs << ", \"udp_latency_p50_us\": " << c.udpLatencyP50Us
+            << ", \"udp_latency_p99_us\": " << c.udpLatencyP99Us << "}" << (i + 1 < cases.size() ? "," : "") << "\n";
+    }
+    out << "  ]\n}\n";
+}
+
+int main(int argc, char** argv) {
+    HarnessOptions options;
+    if (!parseOptions(argc, argv, options) || !validate(options)) {
+        printUsage();
+        return 2;
+    }
+
+    const BenchmarkConfig& config = options.config;
+    std::cout << std::fixed << std::setprecision(2);
+    bool traceOnly = std::all_of(options.modes.begin(), options.modes.end(),
+                                 [](const std::string& mode) { return mode == "trace"; });
+    if (traceOnly) {
+        // The trace fixes matches and inputs (printed once it is loaded)
+        std::cout << "  Replay: rollback every " << config.rollbackInterval
+                  << ", " << snapshotPolicyName(config.snapshotPolicy) << " snapshots";
+    } else {
+        std::cout << "  " << config.numMatches << " matches, " << config.numClients << " clients x "
+                  << config.inputsPerClient << " inputs, batch " << config.batchSize
+                  << ", rollback every " << config.rollbackInterval << ", late ratio " << config.lateRatio
+                  << ", " << snapshotPolicyName(config.snapshotPolicy) << " snapshots";
+    }
+    std::cout << " (" << options.warmup << " warmup + " << options.reps << " reps)" << std::endl;
+    if (config.adaptiveBatching) {
+        std::cout << "  Adaptive batching: latency target " << config.batchTargets.latencyNs / 1000
+                  << " us, depth target " << config.batchTargets.queueDepth << ", max "
+                  << config.batchTargets.maxSize << std::endl;
+    }
+
+    Workload workload;
+    std::unique_ptr<PregeneratedTraffic> traffic;
+    double generationMs = 0.0;
+    if (needsTraffic(options)) {
+        std::cout << "  Generating traffic..." << std::flush;
+        size_t generatorThreads = std::max<size_t>(std::thread::hardware_concurrency(), 1);
+        try {
+            ThreadPool generatorPool(generatorThreads);
+            traffic = std::make_unique<PregeneratedTraffic>(
+                PregeneratedTraffic::generate(config, generatorPool, options.trafficPath));
+        } catch (const std::exception& e) {
+            std::cerr << "\n" << e.what() << std::endl;
+            return 1;
+        }
+        generationMs = traffic->generationMs();
+        workload.traffic = traffic.get();
+        std::cout << " " << generationMs << " ms (" << traffic->totalInputs() << " inputs, "
+                  << generatorThreads << " threads" << (traffic->isMapped() ? ", mapped to " + options.trafficPath : "")
+                  << ")" << std::endl;
+    }
+
+    std::unique_ptr<InputTraceReplayer> trace;
+    if (!options.replayTracePath.empty()) {
+        try {
+            trace = std::make_unique<InputTraceReplayer>(options.replayTracePath);
+        } catch (const std::exception& e) {
+            std::cerr << e.what() << std::endl;
+            return 1;
+        }
+        workload.trace = trace.get();
+        std::cout << "  Trace: " << trace->size() << " inputs, " << trace->numMatches() << " matches, "
+                  << trace->durationMs() << " ms recorded, replay speed ";
+        if (options.replaySpeed > 0.0) std::cout << options.replaySpeed << "x" << std::endl;
+        else std::cout << "max" << std::endl;
+    }
+
+    std::unique_ptr<SyncReference> sync;
+    if (options.syncCheck && traffic) {
+        sync = std::make_unique<SyncReference>(config.numMatches);
+        BenchmarkConfig recording = config;
+        recording.syncHook = sync->recorder();
+        runSequentialBenchmark(recording, *traffic);
+        options.config.syncHook = sync->checker();
+        workload.sync = sync.get();
+        std::cout << "  Sync check: reference hashes from a sequential run, checked every "
+                  << SYNC_TICK_INTERVAL << " ticks" << std::endl;
+    }
+
+    std::cout << "\n  Mode        | Threads | Mean (ms) | Stddev | Min (ms) | Inputs/sec  | Late / Expired" << std::endl;
+    std::cout << "  ------------|---------|-----------|--------|----------|-------------|---------------" << std::endl;
+
+    std::vector<CaseSummary> cases;
+    for (const std::string& mode : options.modes) {
+        std::vector<size_t> threadCounts = mode == "sequential" ? std::vector<size_t>{1} : options.threads;
+        for (size_t threads : threadCounts) {
+            CaseSummary c = runCase(options, workload, mode, threads);
+            cases.push_back(c);
+
+            std::cout << "  " << std::setw(11) << std::left << c.mode << std::right
+                      << " | " << std::setw(7) << c.threads << " | " << std::setw(9) << c.meanMs
+                      << " | " << std::setw(6) << c.stddevMs << " | " << std::setw(8) << c.minMs
+                      << " | " << std::setw(11) << std::setprecision(0) << c.inputsPerSec
+                      << std::setprecision(2) << " | " << c.lateInputs << " / " << c.expiredInputs << std::endl;
+            if (config.adaptiveBatching) {
+                std::cout << "                adaptive: drain quantum " << c.drainQuantumMean;
+                if (c.producerBatchMean > 0.0) std::cout << ", client sends " << c.producerBatchMean << " inputs";
+                std::cout << " (means)" << std::endl;
+            }
+            if (c.mode == "udp") {
+                std::cout << "                udp: " << std::setprecision(0) << c.udpDatagramsPerSec << " datagrams/s, "
+                          << c.udpLostDatagrams << " lost (" << c.udpDroppedInputs << " inputs), latency p50 "
+                          << std::setprecision(1) << c.udpLatencyP50Us << " us / p99 " << c.udpLatencyP99Us << " us, "
+                          << c.udpPerReceiveCall << " per recvmmsg" << std::setprecision(2) << std::endl;
+            }
+            if (workload.sync && c.mode != "trace") {
+                std::cout << "                sync: " << c.syncChecks << " checks, ";
+                if (c.desyncedMatches == 0) std::cout << "in sync" << std::endl;
+                else std::cout << c.desyncedMatches << " matches diverged, first at tick " << c.firstDesyncTick << std::endl;
+            }
+        }
+    }
+
+    if (!options.csvPath.empty()) {
+        writeCsv(options, generationMs, cases);
+    }
+    if (!options.jsonPath.empty()) {
+        writeJson(options, generationMs, cases);
+    }
+
+    if (!options.recordTracePath.empty()) {
+        InputTraceRecorder recorder(config.numMatches, traffic->totalInputs());
+        runConcurrentBenchmark(config, *traffic, options.threads.front(), false, &recorder);
+        try {
+            recorder.save(options.recordTracePath);
+        } catch (const std::exception& e) {
+            std::cerr << e.what() << std::endl;
+            return 1;
+        }
+        std::cout << "\n  Recorded " << recorder.size() << " inputs (pipeline, " << options.threads.front()
+                  << " threads) to " << options.recordTracePath << std::endl;
+    }
+    return 0;
+}
@@ -0,0 +1,470 @@
+#include "scheduler/thread_pool.hpp"
+#include "scheduler/work_stealing_queue.hpp"
+#include "common/metrics.hpp"
+
+#include <iostream>
+#include <iomanip>
+#include <chrono>
+#include <thread>
+#include <vector>
+#include <atomic>
+#include <algorithm>
+#include <string>
+#include <cstdint>
+#include <cstdlib>
+
+using namespace para;
+using namespace std::chrono;
+
+/**
+ * Scheduler stress benchmark
+ *
+ * Times the scheduler by itself, one access pattern at a time, for 1..N
+ * threads, so a regression can be pinned on the deque, the submit path,
+ * the wakeup path or fork-join:
+ * - deque:     one owner pushes every item, threads - 1 thieves steal
+ *              (WorkStealingQueue alone, no pool)
+ * - empty:     empty tasks submitted from outside the pool
+ * - resubmit:  one chain per worker of tasks that submit their successor
+ * - forkjoin:  binary TaskGroup tree, one child spawned, one run inline
+ * - skew:      1 or 2 x threads outside producers feeding small tasks
+ * - imbalance: every small task submitTo() worker 0, the rest must steal
+ * - wake:      submit-to-start latency of one task once the pool is parked
+ *
+ * Reports ns per task (per item for deque), steals, parks and wakeups.
+ * Every task bumps a per-worker counter, and a run that does not execute
+ * each task exactly once is reported and fails the program.
+ *
+ * Usage: scheduler_bench [maxThreads] [tasksPerRun] [scenario|all]
+ */
+
+// Mix rounds per task in the skew and imbalance scenarios (~100 ns)
+constexpr int TASK_WORK = 64;
+
+// Pause before each wake sample, long enough for every worker to park
+constexpr auto WAKE_IDLE_GAP = milliseconds(2);
+
+constexpr size_t WAKE_SAMPLES = 200;
+
+struct SchedulerResult {
+    double nsPerOp = 0;
+    size_t ops = 0;       // Tasks (deque: items) that ran
+    size_t steals = 0;
+    size_t parks = 0;
+    size_t wakes = 0;
+    bool complete = true; // Every task ran exactly once
+};
+
+struct WakeResult {
+    metrics::HistogramSnapshot latencyNs;
+    size_t parks = 0;
+    size_t wakes = 0;
+};
+
+uint32_t mix(uint32_t h) {
+    h ^= h >> 16;
+    h *= 0x85ebca6bu;
+    h ^= h >> 13;
+    h *= 0xc2b2ae35u;
+    h ^= h >> 16;
+    return h;
+}
+
+// A small fixed amount of work the compiler cannot drop
+void spinWork(uint32_t seed) {
+    volatile uint32_t h = seed;
+    for (int i = 0; i < TASK_WORK; ++i) {
+        h = mix(h + static_cast<uint32_t>(i));
+    }
+}
+
+/**
+ * Tasks that ran, one counter per worker on its own cache line, so
+ * counting adds no shared write to the tasks being timed
+ */
+class TaskCounters {
+public:
+    explicit TaskCounters(size_t workers) : slots_(workers) {}
+
+    void bump(const ThreadPool& pool) {
+        int worker = pool.currentWorkerIndex();
+        if (worker < 0) {
+            // A thread outside the pool helping in TaskGroup::wait()
+            outside_.fetch_add(1, std::memory_order_relaxed);
+            return;
+        }
+        std::atomic<size_t>& count = slots_[static_cast<size_t>(worker)].count;
+        count.store(count.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+    }
+
+    size_t total() const {
+        size_t sum = outside_.load(std::memory_order_relaxed);
+        for (const Slot& slot : slots_) {
+            sum += slot.count.load(std::memory_order_relaxed);
+        }
+        return sum;
+    }
+
+private:
+    struct alignas(64) Slot {
+        std::atomic<size_t> count{0};
+    };
+
+    std::vector<Slot> slots_;
+    alignas(64) std::atomic<size_t> outside_{0};
+};
+
+SchedulerResult summarize(const ThreadPool& pool, const TaskCounters& counters, size_t expected,
+                          high_resolution_clock::time_point start, high_resolution_clock::time_point end) {
+    SchedulerResult result;
+    result.ops = counters.total();
+    result.complete = result.ops == expected;
+    result.nsPerOp = duration_cast<nanoseconds>(end - start).count() / static_cast<double>(expected);
+    result.steals = pool.getStealCount();
+    result.parks = pool.getParkCount();
+    result.wakes = pool.getWakeCount();
+    return result;
+}
+
+// ============================================
+// Scenarios
+// ============================================
+SchedulerResult runDeque(size_t threads, size_t items) {
+    WorkStealingQueue<uintptr_t> queue;
+    std::atomic<bool> done{false};
+    std::atomic<size_t> steals{0};
+
+    std::vector<std::thread> thieves;
+    for (size_t i = 1; i < threads; ++i) {
+        thieves.emplace_back([&]() {
+            size_t local = 0;
+            while (!done.load(std::memory_order_acquire)) {
+                if (queue.tryPopFront()) {
+                    ++local;
+                }
+            }
+            steals.fetch_add(local, std::memory_order_relaxed);
+        });
+    }
+
+    // The owner only pushes, then takes back what the thieves left
+    size_t ownerPops = 0;
+    auto start = high_resolution_clock::now();
+    for (uintptr_t i = 0; i < items; ++i) {
+        queue.pushBack(i + 1);
+    }
+    while (queue.tryPopBack()) {
+        ++ownerPops;
+    }
+    auto end = high_resolution_clock::now();
+
+    // Empty with every push done: each item has been claimed
+    done.store(true, std::memory_order_release);
+    for (auto& t : thieves) {
+        t.join();
+    }
+
+    SchedulerResult result;
+    result.steals = steals.load();
+    result.ops = ownerPops + result.steals;
+    result.complete = result.ops == items;
+    result.nsPerOp = duration_cast<nanoseconds>(end - start).count() / static_cast<double>(items);
+    return result;
+}
+
+SchedulerResult runEmpty(size_t threads, size_t tasks) {
+    ThreadPool pool(threads);
+    TaskCounters counters(threads);
+
+    auto start = high_resolution_clock::now();
+    for (size_t i = 0; i < tasks; ++i) {
+        pool.submit([&pool, &counters]() {
+            counters.bump(pool);
+        });
+    }
+    pool.waitAll();
+    auto end = high_resolution_clock::now();
+
+    return summarize(pool, counters, tasks, start, end);
+}
+
+void resubmitChain(ThreadPool& pool, TaskCounters& counters, size_t left) {
+    counters.bump(pool);
+    if (left > 1) {
+        pool.submit([&pool, &counters, left]() {
+            resubmitChain(pool, counters, left - 1);
+        });
+    }
+}
+
+SchedulerResult runResubmit(size_t threads, size_t tasks) {
+    ThreadPool pool(threads);
+    TaskCounters counters(threads);
+    size_t length = tasks / threads;
+
+    auto start = high_resolution_clock::now();
+    for (size_t chain = 0; chain < threads; ++chain) {
+        pool.submit([&pool, &counters, length]() {
+            resubmitChain(pool, counters, length);
+        });
+    }
+    pool.waitAll();
+    auto end = high_resolution_clock::now();
+
+    return summarize(pool, counters, length * threads, start, end);
+}
+
+void forkJoinNode(ThreadPool& pool, TaskCounters& counters, int depth) {
+    counters.bump(pool);
+    if (depth == 0) return;
+
+    TaskGroup group(pool);
+    group.run([&pool, &counters, depth]() {
+        forkJoinNode(pool, counters, depth - 1);
+    });
+    forkJoinNode(pool, counters, depth - 1);
+    group.wait();
+}
+
+SchedulerResult runForkJoin(size_t threads, size_t tasks) {
+    // Deepest full tree with no more than tasks nodes
+    int depth = 0;
+    while ((size_t{4} << depth) - 1 <= tasks) {
+        ++depth;
+    }
+    size_t nodes = (size_t{2} << depth) - 1;
+
+    ThreadPool pool(threads);
+    TaskCounters counters(threads);
+
+    auto start = high_resolution_clock::now();
+    pool.submit([&pool, &counters, depth]() {
+        forkJoinNode(pool, counters, depth);
+    });
+    pool.waitAll();
+    auto end = high_resolution_clock::now();
+
+    return summarize(pool, counters, nodes, start, end);
+}
+
+SchedulerResult runSkew(size_t threads, size_t producers, size_t tasks) {
+    ThreadPool pool(threads);
+    TaskCounters counters(threads);
+    size_t perProducer = tasks / producers;
+
+    auto start = high_resolution_clock::now();
+    std::vector<std::thread> feeders;
+    for (size_t p = 0; p < producers; ++p) {
+        feeders.emplace_back([&pool, &counters, perProducer, p]() {
+            for (size_t i = 0; i < perProducer; ++i) {
+                uint32_t seed = static_cast<uint32_t>(p * perProducer + i);
+                pool.submit([&pool, &counters, seed]() {
+                    spinWork(seed);
+                    counters.bump(pool);
+                });
+            }
+        });
+    }
+    for (auto& t : feeders) {
+        t.join();
+    }
+    pool.waitAll();
+    auto end = high_resolution_clock::now();
+
+    return summarize(pool, counters, perProducer * producers, start, end);
+}
+
+SchedulerResult runImbalance(size_t threads, size_t tasks) {
+    ThreadPool pool(threads);
+    TaskCounters counters(threads);
+
+    auto start = high_resolution_clock::now();
+    for (size_t i = 0; i < tasks; ++i) {
+        uint32_t seed = static_cast<uint32_t>(i);
+        pool.submitTo(0, [&pool, &counters, seed]() {
+            spinWork(seed);
+            counters.bump(pool);
+        });
+    }
+    pool.waitAll();
+    auto end = high_resolution_clock::now();
+
+    return summarize(pool, counters, tasks, start, end);
+}
+
+WakeResult runWake(size_t threads, size_t samples) {
+    ThreadPool pool(threads);
+    metrics::LatencyHistogram latencyNs;
+    std::atomic<int64_t> startedNs{0};
+
+    for (size_t s = 0; s < samples; ++s) {
+        std::this_thread::sleep_for(WAKE_IDLE_GAP);
+
+        int64_t submittedNs = duration_cast<nanoseconds>(steady_clock::now().time_since_epoch()).count();
+        pool.submit([&startedNs]() {
+            startedNs.store(duration_cast<nanoseconds>(steady_clock::now().time_since_epoch()).count(),
+                            std::memory_order_relaxed);
+        });
+        pool.waitAll();
+
+        int64_t waited = startedNs.load(std::memory_order_relaxed) - submittedNs;
+        latencyNs.record(waited > 0 ? static_cast<uint64_t>(waited) : 0);
+    }
+
+    WakeResult result;
+    result.latencyNs.merge(latencyNs);
+    result.parks = pool.getParkCount();
+    result.wakes = pool.getWakeCount();
+    return result;
+}
+
+// ============================================
+// Report
+// ============================================
+void printSeparator() {
+    std::cout << std::string(70, '=') << std::endl;
+}
+
+void printTitle(const std::string& title) {
+    std::cout << "\n  " << title << std::endl;
+}
+
+void printPoolHeader(const std::string& first) {
+    std::cout << "  " << first << " |  ns/op |      Tasks |     Steals |   Parks |   Wakes" << std::endl;
+    std::cout << "  " << std::string(first.size(), '-') << "-|--------|------------|------------|---------|--------"
+              << std::endl;
+}
+
+// Returns false (after saying so) for an incomplete run
+bool printPoolRow(const std::string& first, const SchedulerResult& r) {
+    std::cout << "  " << first << " | " << std::setw(6) << r.nsPerOp << " | " << std::setw(10) << r.ops
+              << " | " << std::setw(10) << r.steals << " | " << std::setw(7) << r.parks << " | " << r.wakes;
+    if (!r.complete) {
+        std::cout << "  INCOMPLETE";
+    }
+    std::cout << std::endl;
+    return r.complete;
+}
+
+std::string threadsCell(size_t threads) {
+    std::string cell = std::to_string(threads);
+    return std::string(7 - std::min<size_t>(cell.size(), 7), ' ') + cell;
+}
+
+int main(int argc, char** argv) {
+    size_t hardware = std::thread::hardware_concurrency();
+    size_t maxThreads = argc > 1 ? std::strtoull(argv[1], nullptr, 10) : std::max<size_t>(hardware, 2);
+    size_t tasks = argc > 2 ? std::strtoull(argv[2], nullptr, 10) : 1000000;
+    std::string only = argc > 3 ? argv[3] : "all";
+
+    const std::vector<std::string> scenarios = {"deque", "empty", "resubmit", "forkjoin", "skew", "imbalance", "wake"};
+    bool known = only == "all";
+    for (const auto& name : scenarios) {
+        known = known || only == name;
+    }
+    if (maxThreads == 0 || tasks == 0 || !known) {
+        std::cerr << "Usage: scheduler_bench [maxThreads] [tasksPerRun] [all|deque|empty|resubmit|forkjoin|skew|imbalance|wake]"
+                  << std::endl;
+        return 2;
+    }
+    auto selected = [&only](const char* name) {
+        return only == "all" || only == name;
+    };
+
+    // 1, 2, 4, ... and maxThreads itself
+    std::vector<size_t> threadCounts;
+    for (size_t t = 1; t < maxThreads; t *= 2) {
+        threadCounts.push_back(t);
+    }
+    threadCounts.push_back(maxThreads);
+
+    std::cout << std::fixed << std::setprecision(2);
+
+    printSeparator();
+    std::cout << "  SCHEDULER BENCHMARK - " << tasks << " tasks per run, 1.." << maxThreads << " threads ("
+              << hardware << " hardware)" << std::endl;
+    printSeparator();
+
+    bool ok = true;
+
+    if (selected("deque")) {
+        printTitle("deque: owner pushes every item, threads - 1 thieves steal (ns per item)");
+        std::cout << "  Threads |  ns/op | Owner Pops |     Steals" << std::endl;
+        std::cout << "  --------|--------|------------|-----------" << std::endl;
+        for (size_t threads : threadCounts) {
+            SchedulerResult r = runDeque(threads, tasks);
+            std::cout << "  " << threadsCell(threads) << " | " << std::setw(6) << r.nsPerOp << " | "
+                      << std::setw(10) << r.ops - r.steals << " | " << r.steals;
+            if (!r.complete) {
+                std::cout << "  INCOMPLETE";
+            }
+            std::cout << std::endl;
+            ok = ok && r.complete;
+        }
+    }
+
+    if (selected("empty")) {
+        printTitle("empty: empty tasks submitted from outside the pool");
+        printPoolHeader("Threads");
+        for (size_t threads : threadCounts) {
+            ok = printPoolRow(threadsCell(threads), runEmpty(threads, tasks)) && ok;
+        }
+    }
+
+    if (selected("resubmit")) {
+        printTitle("resubmit: one chain per worker, each task submits the next");
+        printPoolHeader("Threads");
+        for (size_t threads : threadCounts) {
+            ok = printPoolRow(threadsCell(threads), runResubmit(threads, tasks)) && ok;
+        }
+    }
+
+    if (selected("forkjoin")) {
+        printTitle("forkjoin: binary TaskGroup tree (ns per node)");
+        printPoolHeader("Threads");
+        for (size_t threads : threadCounts) {
+            ok = printPoolRow(threadsCell(threads), runForkJoin(threads, tasks)) && ok;
+        }
+    }
+
+    if (selected("skew")) {
+        printTitle("skew: outside producers feeding " + std::to_string(TASK_WORK) + "-round tasks");
+        printPoolHeader("Threads x Producers");
+        for (size_t threads : threadCounts) {
+            for (size_t producers : {size_t{1}, 2 * threads}) {
+                std::string cell = threadsCell(threads) + " x " + std::to_string(producers);
+                cell.resize(19, ' ');
+                ok = printPoolRow(cell, runSkew(threads, producers, tasks / 4)) && ok;
+            }
+        }
+    }
+
+    if (selected("imbalance")) {
+        printTitle("imbalance: every task submitTo(0, ...), the other workers steal");
+        printPoolHeader("Threads");
+        for (size_t threads : threadCounts) {
+            ok = printPoolRow(threadsCell(threads), runImbalance(threads, tasks / 4)) && ok;
+        }
+    }
+
+    if (selected("wake")) {
+        printTitle("wake: submit -> task start once every worker is parked (" + std::to_string(WAKE_SAMPLES) +
+                   " samples)");
+        std::cout << "  Threads | p50 us | p99 us | max us |   Parks |   Wakes" << std::endl;
+        std::cout << "  --------|--------|--------|--------|---------|--------" << std::endl;
+        for (size_t threads : threadCounts) {
+            WakeResult r = runWake(threads, WAKE_SAMPLES);
+            std::cout << "  " << threadsCell(threads) << " | " << std::setw(6) << r.latencyNs.percentile(0.50) / 1000.0
+                      << " | " << std::setw(6) << r.latencyNs.percentile(0.99) / 1000.0 << " | " << std::setw(6)
+                      << r.latencyNs.max() / 1000.0 << " | " << std::setw(7) << r.parks << " | " << r.wakes
+                      << std::endl;
+        }
+    }
+
+    std::cout << std::endl;
+    if (!ok) {
+        std::cerr << "Some runs did not execute every task exactly once" << std::endl;
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,256 @@
+#include "game/snapshot_store.hpp"
+
+#include <iostream>
+#include <iomanip>
+#include <chrono>
+#include <memory>
+#include <vector>
+#include <string>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <type_traits>
+
+using namespace para;
+using namespace std::chrono;
+
+/**
+ * Snapshot policy benchmark
+ *
+ * Runs the same rollback timeline against every snapshot store, for match
+ * states of growing size: each tick changes a few percent of the
+ * entities, snapshots are saved every ROLLBACK_INTERVAL ticks, and every
+ * ROLLBACK_INTERVAL ticks each match rolls back a pseudo-random 1..45
+ * ticks and re-simulates (saving again on the way, like Match does).
+ *
+ * Reports memory per match and the cost of a save, a restore and a whole
+ * rollback (restore + replay). Before timing, checks that every store
+ * restores exactly what full snapshots restore, rollback after rollback.
+ *
+ * Usage: snapshot_bench [matches] [ticks] [change-percent]
+ */
+
+struct Entity {
+    int32_t x;
+    int32_t y;
+    int32_t hp;
+    int32_t flags;
+};
+
+template<size_t Entities>
+struct EntityState {
+    int32_t tick = 0;
+    int32_t matchId = 0;
+    std::array<Entity, Entities> entities{};
+};
+
+uint32_t mix(uint32_t h) {
+    h ^= h >> 16;
+    h *= 0x85ebca6bu;
+    h ^= h >> 13;
+    h *= 0xc2b2ae35u;
+    h ^= h >> 16;
+    return h;
+}
+
+/**
+ * Deterministic tick: the same entities change the same way every time
+ * tick is simulated, as in a replay
+ */
+template<size_t Entities>
+void simulate(EntityState<Entities>& state, uint32_t changes) {
+    uint32_t seed = mix(static_cast<uint32_t>(state.tick) * 2654435761u + static_cast<uint32_t>(state.matchId));
+    for (uint32_t k = 0; k < changes; ++k) {
+        uint32_t h = mix(seed + k);
+        Entity& entity = state.entities[h % Entities];
+        entity.x += static_cast<int32_t>(h >> 28) - 8;
+        entity.y += static_cast<int32_t>((h >> 24) & 15) - 8;
+        entity.hp -= static_cast<int32_t>((h >> 20) & 1);
+    }
+    ++state.tick;
+}
+
+struct CaseResult {
+    double saveNs = 0.0;
+    double restoreNs = 0.0;
+    double rollbackUs = 0.0;
+    size_t bytesPerMatch = 0;
+    bool exact = true;
+};
+
+// Rollback distance for a match at a tick (1..MAX_ROLLBACK_TICKS - ROLLBACK_INTERVAL)
+int rollbackDistance(int tick, int match) {
+    return 1 + static_cast<int>(mix(static_cast<uint32_t>(tick * 31 + match)) %
+                                (MAX_ROLLBACK_TICKS - ROLLBACK_INTERVAL));
+}
+
+/**
+ * The timeline for one store type; with reference, every restore is
+ * compared with the FULL store's
+ */
+template<typename Store, size_t Entities>
+CaseResult runCase(size_t numMatches, int numTicks, uint32_t changes,
+                   std::vector<std::unique_ptr<SnapshotRing<ROLLBACK_INTERVAL, SNAPSHOT_DEPTH, EntityState<Entities>>>>* reference) {
+    using State = EntityState<Entities>;
+    using FullRing = SnapshotRing<ROLLBACK_INTERVAL, SNAPSHOT_DEPTH, State>;
+
+    std::vector<std::unique_ptr<State>> states;
+    std::vector<std::unique_ptr<Store>> stores;
+    std::vector<std::unique_ptr<State>> referenceStates;
+    for (size_t m = 0; m < numMatches; ++m) {
+        states.push_back(std::make_unique<State>());
+        states.back()->matchId = static_cast<int32_t>(m);
+        stores.push_back(std::make_unique<Store>());
+        stores.back()->save(0, *states.back());
+        if (reference) {
+            reference->push_back(std::make_unique<FullRing>());
+            reference->back()->save(0, *states.back());
+            referenceStates.push_back(std::make_unique<State>());
+        }
+    }
+
+    CaseResult result;
+    size_t saves = 0;
+    size_t rollbacks = 0;
+    nanoseconds saveTime(0);
+    nanoseconds restoreTime(0);
+    nanoseconds rollbackTime(0);
+
+    for (int tick = 1; tick <= numTicks; ++tick) {
+        for (size_t m = 0; m < numMatches; ++m) {
+            simulate(*states[m], changes);
+        }
+        if (tick % ROLLBACK_INTERVAL != 0) continue;
+
+        auto saveStart = high_resolution_clock::now();
+        for (size_t m = 0; m < numMatches; ++m) {
+            stores[m]->save(tick, *states[m]);
+        }
+        saveTime += duration_cast<nanoseconds>(high_resolution_clock::now() - saveStart);
+        saves += numMatches;
+        if (reference) {
+            for (size_t m = 0; m < numMatches; ++m) {
+                (*reference)[m]->save(tick, *states[m]);
+            }
+        }
+
+        // Roll every match back and replay it to tick
+        for (size_t m = 0; m < numMatches; ++m) {
+            State& state = *states[m];
+            int toTick = tick - rollbackDistance(tick, static_cast<int>(m));
+
+            auto rollbackStart = high_resolution_clock::now();
+            int restored = stores[m]->restore(toTick, state);
+            auto replayStart = high_resolution_clock::now();
+            if (restored < 0) {
+                result.exact = false;
+                continue;
+            }
+            if (reference) {
+                State& expected = *referenceStates[m];
+                int expectedTick = (*reference)[m]->restore(toTick, expected);
+                if (expectedTick != restored || std::memcmp(&expected, &state, sizeof(State)) != 0) {
+                    result.exact = false;
+                }
+            }
+            while (state.tick < tick) {
+                simulate(state, changes);
+                if (state.tick % ROLLBACK_INTERVAL == 0) {
+                    stores[m]->save(state.tick, state);
+                    if (reference) {
+                        (*reference)[m]->save(state.tick, state);
+                    }
+                }
+            }
+            auto rollbackEnd = high_resolution_clock::now();
+            restoreTime += duration_cast<nanoseconds>(replayStart - rollbackStart);
+            rollbackTime += duration_cast<nanoseconds>(rollbackEnd - rollbackStart);
+            ++rollbacks;
+        }
+    }
+
+    for (const auto& store : stores) {
+        result.bytesPerMatch += store->memoryBytes();
+    }
+    result.bytesPerMatch /= numMatches;
+    result.saveNs = saves ? saveTime.count() / static_cast<double>(saves) : 0.0;
+    result.restoreNs = rollbacks ? restoreTime.count() / static_cast<double>(rollbacks) : 0.0;
+    result.rollbackUs = rollbacks ? rollbackTime.count() / 1000.0 / rollbacks : 0.0;
+    return result;
+}
+
+void printSeparator() {
+    std::cout << std::string(82, '=') << std::endl;
+}
+
+void printRow(const std::string& name, const CaseResult& result, const CaseResult& baseline) {
+    std::cout << "  " << std::setw(14) << std::left << name << std::right
+              << " | " << std::setw(12) << result.bytesPerMatch
+              << " | " << std::setw(6) << std::setprecision(2)
+              << static_cast<double>(result.bytesPerMatch) / baseline.bytesPerMatch << "x"
+              << " | " << std::setw(10) << std::setprecision(0) << result.saveNs
+              << " | " << std::setw(10) << result.restoreNs
+              << " | " << std::setw(11) << std::setprecision(2) << result.rollbackUs
+              << " | " << (result.exact ? "yes" : "NO") << std::endl;
+}
+
+template<size_t Entities>
+bool runSize(size_t numMatches, int numTicks, double changePercent) {
+    using State = EntityState<Entities>;
+    uint32_t changes = static_cast<uint32_t>(Entities * changePercent / 100.0 + 0.5);
+    if (changes == 0) changes = 1;
+
+    std::cout << "\n  " << Entities << " entities (" << sizeof(State) << " bytes/state), "
+              << changes << " changed per tick" << std::endl;
+    std::cout << "  Policy         | Bytes/match  | vs full | Save ns    | Restore ns | Rollback us | Exact" << std::endl;
+    std::cout << "  ---------------|--------------|---------|------------|------------|-------------|------" << std::endl;
+
+    CaseResult full = runCase<SnapshotRing<ROLLBACK_INTERVAL, SNAPSHOT_DEPTH, State>, Entities>(
+        numMatches, numTicks, changes, nullptr);
+    printRow("full", full, full);
+
+    // The checked runs replay against a full ring of their own
+    bool exact = true;
+    auto checked = [&](auto* tag, const std::string& name) {
+        using Store = typename std::remove_pointer<decltype(tag)>::type;
+        std::vector<std::unique_ptr<SnapshotRing<ROLLBACK_INTERVAL, SNAPSHOT_DEPTH, State>>> reference;
+        CaseResult verify = runCase<Store, Entities>(numMatches, numTicks / 4 + ROLLBACK_INTERVAL, changes, &reference);
+        CaseResult timed = runCase<Store, Entities>(numMatches, numTicks, changes, nullptr);
+        timed.exact = verify.exact;
+        exact = exact && verify.exact;
+        printRow(name, timed, full);
+    };
+    checked(static_cast<DeltaSnapshotRing<ROLLBACK_INTERVAL, SNAPSHOT_DEPTH, 4, State>*>(nullptr), "delta (K=4)");
+    checked(static_cast<DeltaSnapshotRing<ROLLBACK_INTERVAL, SNAPSHOT_DEPTH, 11, State>*>(nullptr), "delta (K=11)");
+    checked(static_cast<PagedSnapshotRing<ROLLBACK_INTERVAL, SNAPSHOT_DEPTH, 64, State>*>(nullptr), "paged (64 B)");
+    checked(static_cast<PagedSnapshotRing<ROLLBACK_INTERVAL, SNAPSHOT_DEPTH, 1024, State>*>(nullptr), "paged (1 KiB)");
+    return exact;
+}
+
+int main(int argc, char** argv) {
+    size_t numMatches = argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 16;
+    int numTicks = argc > 2 ? std::atoi(argv[2]) : 2000;
+    double changePercent = argc > 3 ? std::atof(argv[3]) : 1.0;
+    if (numMatches == 0 || numTicks < ROLLBACK_INTERVAL * 4 || changePercent <= 0.0) {
+        std::cout << "Usage: snapshot_bench [matches] [ticks >= " << ROLLBACK_INTERVAL * 4
+                  << "] [change-percent > 0]" << std::endl;
+        return 2;
+    }
+
+    std::cout << std::fixed;
+    printSeparator();
+    std::cout << "  SNAPSHOT BENCHMARK - " << numMatches << " matches x " << numTicks << " ticks, "
+              << std::setprecision(1) << changePercent << "% of entities change per tick" << std::endl;
+    std::cout << "  Window: " << SNAPSHOT_DEPTH << " snapshots every " << ROLLBACK_INTERVAL
+              << " ticks; one rollback per match every " << ROLLBACK_INTERVAL << " ticks" << std::endl;
+    printSeparator();
+
+    bool exact = runSize<2>(numMatches, numTicks, changePercent);
+    exact = runSize<64>(numMatches, numTicks, changePercent) && exact;
+    exact = runSize<1024>(numMatches, numTicks, changePercent) && exact;
+    exact = runSize<16384>(numMatches, numTicks / 4, changePercent) && exact;
+
+    std::cout << "\n  Restores match full snapshots: " << (exact ? "PASS" : "FAIL") << std::endl;
+    std::cout << std::endl;
+    return exact ? 0 : 1;
+}
@@ -0,0 +1,169 @@
+#include "game/match_state_soa.hpp"
+#include "game/match.hpp"
+
+#include <iostream>
+#include <iomanip>
+#include <chrono>
+#include <random>
+#include <memory>
+#include <vector>
+#include <string>
+#include <cstdint>
+#include <cstdlib>
+
+using namespace para;
+using namespace std::chrono;
+
+/**
+ * SoA tick kernel benchmark
+ *
+ * Applies one action per player per tick across many matches and compares
+ * the per-match MatchState loop (PlayerState::move) with MatchStateSoA's
+ * scalar and SIMD kernels. Before timing, checks that both kernels give the
+ * same positions as Match::applyInput bit for bit.
+ *
+ * Usage: soa_bench [matches] [ticks]
+ */
+
+// Random actions for every player slot of every tick; ~1 in 8 slots idle
+std::vector<uint8_t> generateActions(size_t numPlayers, size_t numTicks, uint32_t seed) {
+    std::mt19937 rng(seed);
+    std::uniform_int_distribution<int> dist(0, 7);
+
+    std::vector<uint8_t> actions(numPlayers * numTicks);
+    for (auto& action : actions) {
+        int roll = dist(rng);
+        action = roll < 4 ? static_cast<uint8_t>(roll)
+                          : (roll == 7 ? MatchStateSoA::NO_ACTION : static_cast<uint8_t>(roll - 4));
+    }
+    return actions;
+}
+
+bool samePlayers(const MatchState& a, const MatchState& b) {
+    for (int p = 0; p < MatchStateSoA::PLAYERS_PER_MATCH; ++p) {
+        if (a.players[p].x != b.players[p].x || a.players[p].y != b.players[p].y) {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool verifyBitExact(size_t numMatches, size_t numTicks) {
+    size_t numPlayers = numMatches * MatchStateSoA::PLAYERS_PER_MATCH;
+    std::vector<uint8_t> actions = generateActions(numPlayers, numTicks, 7);
+
+    std::vector<std::unique_ptr<Match>> reference;
+    MatchStateSoA simd(numMatches);
+    MatchStateSoA scalar(numMatches);
+    for (size_t m = 0; m < numMatches; ++m) {
+        reference.push_back(std::make_unique<Match>(static_cast<int>(m)));
+        reference.back()->start();
+        simd.load(m, reference.back()->getState());
+        scalar.load(m, reference.back()->getState());
+    }
+
+    for (size_t t = 0; t < numTicks; ++t) {
+        const uint8_t* tickActions = actions.data() + t * numPlayers;
+        for (size_t slot = 0; slot < numPlayers; ++slot) {
+            if (tickActions[slot] == MatchStateSoA::NO_ACTION) continue;
+            size_t m = slot / MatchStateSoA::PLAYERS_PER_MATCH;
+            int player = static_cast<int>(slot % MatchStateSoA::PLAYERS_PER_MATCH);
+            reference[m]->applyInput(Input(static_cast<int>(m), player, static_cast<int>(t),
+                                           static_cast<ActionType>(tickActions[slot])));
+        }
+        simd.applyTick(tickActions);
+        scalar.applyTickScalar(tickActions);
+    }
+
+    for (size_t m = 0; m < numMatches; ++m) {
+        reference[m]->publishState();
+        MatchState expected = reference[m]->getState();
+        if (!samePlayers(expected, simd.extract(m)) || !samePlayers(expected, scalar.extract(m))) {
+            std::cout << "  Mismatch in match " << m << std::endl;
+            return false;
+        }
+    }
+    return true;
+}
+
+template<typename TickFn>
+double measureNsPerPlayerUpdate(size_t numPlayers, size_t numTicks, TickFn&& tick) {
+    auto start = high_resolution_clock::now();
+    for (size_t t = 0; t < numTicks; ++t) {
+        tick(t);
+    }
+    auto end = high_resolution_clock::now();
+    return duration_cast<nanoseconds>(end - start).count() / static_cast<double>(numPlayers * numTicks);
+}
+
+void printSeparator() {
+    std::cout << std::string(66, '=') << std::endl;
+}
+
+int main(int argc, char** argv) {
+    size_t numMatches = argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 20000;
+    size_t numTicks = argc > 2 ? std::strtoull(argv[2], nullptr, 10) : 200;
+    size_t numPlayers = numMatches * MatchStateSoA::PLAYERS_PER_MATCH;
+
+    std::cout << std::fixed << std::setprecision(3);
+
+    printSeparator();
+    std::cout << "  SOA BENCHMARK - " << numMatches << " matches x " << numTicks
+              << " ticks (kernel: " << MatchStateSoA::kernelName() << ")" << std::endl;
+    printSeparator();
+
+    // Odd match count so the scalar tail after the vector loop is exercised too
+    bool exact = verifyBitExact(1027, 500);
+    std::cout << "\n  Bit-exact vs Match::applyInput: " << (exact ? "PASS" : "FAIL") << std::endl;
+    if (!exact) {
+        return 1;
+    }
+
+    std::vector<uint8_t> actions = generateActions(numPlayers, numTicks, 42);
+
+    // Baseline: one MatchState per match, per-input switch
+    std::vector<MatchState> states;
+    states.reserve(numMatches);
+    for (size_t m = 0; m < numMatches; ++m) {
+        states.emplace_back(static_cast<int>(m));
+    }
+    double aosNs = measureNsPerPlayerUpdate(numPlayers, numTicks, [&](size_t t) {
+        const uint8_t* tickActions = actions.data() + t * numPlayers;
+        for (size_t slot = 0; slot < numPlayers; ++slot) {
+            if (tickActions[slot] == MatchStateSoA::NO_ACTION) continue;
+            MatchState& state = states[slot / MatchStateSoA::PLAYERS_PER_MATCH];
+            state.players[slot % MatchStateSoA::PLAYERS_PER_MATCH].move(static_cast<ActionType>(tickActions[slot]));
+        }
+        for (auto& state : states) {
+            state.currentTick++;
+        }
+    });
+
+    MatchStateSoA scalar(numMatches);
+    double scalarNs = measureNsPerPlayerUpdate(numPlayers, numTicks, [&](size_t t) {
+        scalar.applyTickScalar(actions.data() + t * numPlayers);
+    });
+
+    MatchStateSoA simd(numMatches);
+    double simdNs = measureNsPerPlayerUpdate(numPlayers, numTicks, [&](size_t t) {
+        simd.applyTick(actions.data() + t * numPlayers);
+    });
+
+    // Keep the baseline's results observable
+    long checksum = 0;
+    for (size_t m = 0; m < numMatches; ++m) {
+        checksum += states[m].players[0].x + simd.extract(m).players[1].y + scalar.extract(m).players[0].y;
+    }
+
+    std::cout << "\n  Layout          | ns/player-update | Bytes/match" << std::endl;
+    std::cout << "  ----------------|------------------|------------" << std::endl;
+    std::cout << "  MatchState AoS  | " << std::setw(16) << aosNs << " | " << sizeof(MatchState) << std::endl;
+    std::cout << "  SoA scalar      | " << std::setw(16) << scalarNs << " | " << MatchStateSoA::bytesPerMatch() << std::endl;
+    std::cout << "  SoA " << std::setw(11) << std::left << MatchStateSoA::kernelName() << std::right
+              << " | " << std::setw(16) << simdNs << " | " << MatchStateSoA::bytesPerMatch() << std::endl;
+    std::cout << "\n  Speedup (SIMD vs AoS): " << std::setprecision(2) << aosNs / simdNs << "x"
+              << "  (checksum " << checksum << ")" << std::endl;
+
+    std::cout << std::endl;
+    return 0;
+}
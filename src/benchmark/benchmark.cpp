@@ -0,0 +1,634 @@
+#include "benchmark.hpp"
+#include "traffic.hpp"
+#include "../scheduler/thread_pool.hpp"
+#include "../client/client.hpp"
+#include <algorithm>
+#include <memory>
+#include <thread>
+#include <vector>
+
+namespace para {
+
+using namespace std::chrono;
+
+namespace {
+
+/**
+ * Batches each client has sent, so a client can keep in step with the
+ * other clients of its match: it may only run one batch past the one
+ * furthest behind, as in the sequential run's round-robin order.
+ *
+ * With late traffic the pacing by match tick alone is not enough: past
+ * the deadline one client can push its match on by itself while the
+ * other's task waits, and the other's inputs then arrive after their
+ * ticks left the rollback window (they expire).
+ */
+class MatchLockstep {
+public:
+    explicit MatchLockstep(const PregeneratedTraffic& traffic)
+        : clientsOf_(traffic.numMatches())
+        , sent_(new std::atomic<uint32_t>[traffic.numClients()])
+    {
+        for (int c = 0; c < traffic.numClients(); ++c) {
+            clientsOf_[traffic.matchOf(c)].push_back(c);
+            sent_[c].store(0, std::memory_order_relaxed);
+        }
+    }
+    
+    // Batches client may send from nextBatch on (at least 1 for the client
+    // furthest behind)
+    size_t allowance(const PregeneratedTraffic& traffic, int client, size_t nextBatch) const {
+        size_t slowest = nextBatch;
+        for (int other : clientsOf_[traffic.matchOf(client)]) {
+            slowest = std::min<size_t>(slowest, sent_[other].load(std::memory_order_acquire));
+        }
+        return slowest + 1 - nextBatch;
+    }
+    
+    // client has sent every batch before nextBatch
+    void advance(int client, size_t nextBatch) {
+        sent_[client].store(static_cast<uint32_t>(nextBatch), std::memory_order_release);
+    }
+    
+private:
+    std::vector<std::vector<int>> clientsOf_;
+    std::unique_ptr<std::atomic<uint32_t>[]> sent_;
+};
+
+// How far a pipeline client may run ahead of its match
+struct ClientPacing {
+    int batchSize;
+    int maxLead;
+    MatchLockstep* lockstep;  // Late traffic: also in step with the match's other clients (else nullptr)
+};
+
+// Shared by every replaying client task of one run
+struct ReplayContext {
+    const PregeneratedTraffic* traffic;
+    GameServer* server;
+    ThreadPool* pool;
+    ClientPacing pacing;
+    AdaptiveBatchController* producers;  // One per client; nullptr: one batch per send
+};
+
+// Shared by every client task of a sharded run
+struct ShardedReplayContext {
+    const PregeneratedTraffic* traffic;
+    ShardedServer* server;
+    ClientPacing pacing;
+    AdaptiveBatchController* producers;
+};
+
+// Recorded batches a client's controller asks for per send (one without)
+size_t wantedBatches(const ClientPacing& pacing, const AdaptiveBatchController* control) {
+    if (!control) return 1;
+    size_t batchSize = static_cast<size_t>(pacing.batchSize);
+    return std::max<size_t>((control->size() + batchSize / 2) / batchSize, 1);
+}
+
+// Batches client sends next, starting at nextBatch: as many as it wants,
+// no further than pacing allows. 0 while even nextBatch would run more
+// than maxLead ticks past its match, or a batch past another of its clients.
+// The batch holding the match's current tick is always reachable, so a
+// batch longer than the lead cannot stall every client of a match
+size_t sendableBatches(const PregeneratedTraffic& traffic, const ClientPacing& pacing,
+                       const AdaptiveBatchController* control, int client, size_t nextBatch, int matchTick) {
+    // Batches whose last tick is within the lead
+    size_t reachable = static_cast<size_t>(std::max((matchTick + pacing.maxLead + 1) / pacing.batchSize,
+                                                    matchTick / pacing.batchSize + 1));
+    if (reachable <= nextBatch) return 0;
+    size_t batches = std::min({wantedBatches(pacing, control), reachable - nextBatch,
+                               traffic.batchesPerClient() - nextBatch});
+    if (pacing.lockstep) {
+        batches = std::min(batches, pacing.lockstep->allowance(traffic, client, nextBatch));
+    }
+    return batches;
+}
+
+// Per-client controllers for an adaptive run, nullptr otherwise
+std::unique_ptr<AdaptiveBatchController[]> makeProducers(const BenchmarkConfig& config, int numClients) {
+    if (!config.adaptiveBatching) return nullptr;
+    std::unique_ptr<AdaptiveBatchController[]> producers(new AdaptiveBatchController[numClients]);
+    for (int i = 0; i < numClients; ++i) {
+        producers[i].configure(config.batchTargets);
+    }
+    return producers;
+}
+
+BatchControlStats mergeProducers(const AdaptiveBatchController* producers, int numClients) {
+    BatchControlStats stats;
+    for (int i = 0; producers && i < numClients; ++i) {
+        stats.merge(producers[i].stats());
+    }
+    return stats;
+}
+
+// Self-replicating client task of a sharded run: same pacing as the
+// pipeline's, resubmitted next to its match in that match's shard
+struct ShardedClientTask {
+    const ShardedReplayContext* context;
+    int client;
+    uint32_t nextBatch;
+    uint64_t dueNs;                // Adaptive batching: when this run was submitted
+    
+    void operator()() {
+        const PregeneratedTraffic& traffic = *context->traffic;
+        ShardedServer& server = *context->server;
+        int matchId = traffic.matchOf(client);
+        ThreadPool& pool = server.getShardPool(server.getShardOf(matchId));
+        size_t home = static_cast<size_t>(server.getLocalMatch(matchId));
+        AdaptiveBatchController* control = context->producers ? &context->producers[client] : nullptr;
+        
+        size_t batches = sendableBatches(traffic, context->pacing, control, client, nextBatch,
+                                         server.getMatchTick(matchId));
+        if (batches == 0) {
+            resubmit(pool, home, control);
+            return;
+        }
+        uint64_t startNs = control ? AdaptiveBatchController::nowNs() : 0;
+        
+        size_t count;
+        const PackedInput* inputs = traffic.batches(client, nextBatch, batches, count);
+        server.receiveInputs(inputs, count);
+        nextBatch += static_cast<uint32_t>(batches);
+        if (context->pacing.lockstep) {
+            context->pacing.lockstep->advance(client, nextBatch);
+        }
+        metrics::record(metrics::Histogram::PRODUCER_BATCH_SIZE, count);
+        if (control) {
+            control->onSend(dueNs ? startNs - dueNs : 0, server.getQueueDepth(matchId),
+                            batches >= wantedBatches(context->pacing, control));
+        }
+        
+        if (nextBatch < traffic.batchesPerClient()) {
+            resubmit(pool, home, control);
+        }
+    }
+    
+    void resubmit(ThreadPool& pool, size_t home, const AdaptiveBatchController* control) {
+        dueNs = control ? AdaptiveBatchController::nowNs() : 0;
+        pool.submitAffine(home, *this);
+    }
+};
+static_assert(ThreadPool::Task::fits<ShardedClientTask>(), "ShardedClientTask must fit inline in a pool task");
+
+// Inputs the busiest match receives (clients wrap around the matches)
+size_t maxInputsPerMatch(const PregeneratedTraffic& traffic) {
+    std::vector<size_t> clientsPerMatch(static_cast<size_t>(std::max(traffic.numMatches(), 1)), 0);
+    for (int i = 0; i < traffic.numClients(); ++i) {
+        ++clientsPerMatch[static_cast<size_t>(traffic.matchOf(i))];
+    }
+    size_t busiest = *std::max_element(clientsPerMatch.begin(), clientsPerMatch.end());
+    return busiest * static_cast<size_t>(traffic.inputsPerClient());
+}
+
+// Same, for a recorded trace
+size_t maxInputsPerMatch(const InputTraceReplayer& trace) {
+    std::vector<size_t> perMatch(static_cast<size_t>(std::max(trace.numMatches(), 1)), 0);
+    const PackedInput* inputs = trace.inputs();
+    for (size_t i = 0; i < trace.size(); ++i) {
+        size_t match = static_cast<size_t>(inputs[i].localMatch());
+        if (match < perMatch.size()) ++perMatch[match];
+    }
+    return *std::max_element(perMatch.begin(), perMatch.end());
+}
+
+} // namespace
+
+BenchmarkResult runSequentialBenchmark(const BenchmarkConfig& config, const PregeneratedTraffic& traffic) {
+    BenchmarkResult result = {};
+    
+    // Each match queue holds its whole input stream
+    GameServer server(traffic.numMatches(), std::max(MATCH_QUEUE_CAPACITY, maxInputsPerMatch(traffic)));
+    if (config.adaptiveBatching) {
+        server.enableAdaptiveDrain(config.batchTargets);
+    }
+    server.setRollbackInterval(config.rollbackInterval);
+    server.setSnapshotPolicy(config.snapshotPolicy);
+    server.setSyncHook(config.syncHook);
+    server.start();
+    
+    // Enqueue the batches round-robin across clients to simulate interleaved
+    // arrival; this orders inputs roughly by time, as in the parallel modes
+    for (size_t b = 0; b < traffic.batchesPerClient(); ++b) {
+        for (int c = 0; c < traffic.numClients(); ++c) {
+            size_t count;
+            const PackedInput* inputs = traffic.batch(c, b, count);
+            server.receiveInputs(inputs, count);
+        }
+    }
+    
+    metrics::reset();
+    auto start = high_resolution_clock::now();
+    server.processAllSequential();
+    auto end = high_resolution_clock::now();
+    
+    result.timeMs = duration_cast<microseconds>(end - start).count() / 1000.0;
+    result.processedInputs = server.getProcessedCount();
+    result.rollbackCount = server.getTotalRollbackCount();
+    result.lateInputs = server.getTotalLateInputCount();
+    result.expiredInputs = server.getTotalExpiredInputCount();
+    result.workSteals = 0;
+    result.taskHeapAllocs = 0;
+    result.taskRecycled = 0;
+    result.workerParks = 0;
+    result.affineHomeRuns = 0;
+    result.affineAwayRuns = 0;
+    result.matchTasks = 0;
+    result.drainQuanta = server.getDrainControlStats();
+    if (metrics::ENABLED) {
+        result.metrics = metrics::snapshot();
+    }
+    
+    return result;
+}
+
+BenchmarkResult runConcurrentBenchmark(const BenchmarkConfig& config, const PregeneratedTraffic& traffic,
+                                       size_t numThreads, bool directInput,
+                                       InputTraceRecorder* recorder) {
+    BenchmarkResult result = {};
+    
+    GameServer server(traffic.numMatches());
+    ThreadPool pool(numThreads);
+    server.enableEventScheduling(pool);
+    if (directInput) {
+        server.enableDirectInput();
+    }
+    if (config.adaptiveBatching) {
+        server.enableAdaptiveDrain(config.batchTargets);
+    }
+    server.setTraceRecorder(recorder);
+    server.setRollbackInterval(config.rollbackInterval);
+    server.setSnapshotPolicy(config.snapshotPolicy);
+    server.setSyncHook(config.syncHook);
+    server.start();
+    
+    // Real clients are paced by wall time; here a client is held back while
+    // it would run more than maxLead ticks past its match. Late inputs need
+    // room past the deadline so the held-back ticks get forced, and clients
+    // in step with each other so that no input expires
+    std::unique_ptr<AdaptiveBatchController[]> producers = makeProducers(config, traffic.numClients());
+    MatchLockstep lockstep(traffic);
+    ReplayContext context{&traffic, &server, &pool, {traffic.batchSize(), INPUT_DEADLINE_TICKS, nullptr},
+                          producers.get()};
+    if (config.lateRatio > 0.0) {
+        context.pacing.maxLead += traffic.batchSize();
+        context.pacing.lockstep = &lockstep;
+    }
+    
+    // The previous run's pool is gone, so nothing is recording
+    metrics::reset();
+    auto start = high_resolution_clock::now();
+    
+    // 1. Submit initial Client Tasks
+    for (int i = 0; i < traffic.numClients(); ++i) {
+        // Clients share their match's home worker: producer and consumer stay on one core
+        int matchId = traffic.matchOf(i);
+        GameServer::PlayerRing* ring = server.getPlayerRing(matchId, traffic.playerOf(i));
+        pool.submitAffine(static_cast<size_t>(matchId), [&context, ring, i]() {
+            // Self-replicating Client Task: sends its client's recorded batches in order
+            struct ClientTask {
+                const ReplayContext* context;
+                GameServer::PlayerRing* ring;  // Direct input: this client's SPSC ring
+                int client;
+                uint32_t nextBatch;
+                uint32_t chunkBatches;         // Batches in the send under way
+                uint32_t sentOfChunk;          // Direct input: part of it already in the ring
+                uint64_t dueNs;                // Adaptive batching: when this run was submitted
+                
+                void operator()() {
+                    const PregeneratedTraffic& traffic = *context->traffic;
+                    int matchId = traffic.matchOf(client);
+                    AdaptiveBatchController* control =
+                        context->producers ? &context->producers[client] : nullptr;
+                    
+                    // Too far ahead of its match: go again later
+                    if (sentOfChunk == 0) {
+                        chunkBatches = static_cast<uint32_t>(sendableBatches(traffic, context->pacing, control, client,
+                                                                             nextBatch,
+                                                                             context->server->getMatchTick(matchId)));
+                        if (chunkBatches == 0) {
+                            resubmit(matchId, control);
+                            return;
+                        }
+                    }
+                    uint64_t startNs = control ? AdaptiveBatchController::nowNs() : 0;
+                    
+                    size_t count;
+                    const PackedInput* inputs = traffic.batches(client, nextBatch, chunkBatches, count);
+                    size_t sent = 0;
+                    if (ring) {
+                        // Copied into reserved slots; a full ring just means trying again later
+                        while (sentOfChunk < count) {
+                            size_t reserved;
+                            PackedInput* slots = ring->reserve(count - sentOfChunk, reserved);
+                            if (reserved == 0) break;
+                            std::copy(inputs + sentOfChunk, inputs + sentOfChunk + reserved, slots);
+                            ring->commit(reserved);
+                            sentOfChunk += static_cast<uint32_t>(reserved);
+                            sent += reserved;
+                        }
+                        context->server->notifyInputs(matchId, sent);
+                        if (sentOfChunk == count) {
+                            nextBatch += chunkBatches;
+                            sentOfChunk = 0;
+                        }
+                    } else {
+                        context->server->receiveInputs(inputs, count);
+                        nextBatch += chunkBatches;
+                        sent = count;
+                    }
+                    if (context->pacing.lockstep) {
+                        context->pacing.lockstep->advance(client, nextBatch);
+                    }
+                    metrics::record(metrics::Histogram::PRODUCER_BATCH_SIZE, sent);
+                    if (control) {
+                        control->onSend(dueNs ? startNs - dueNs : 0, context->server->getQueueDepth(matchId),
+                                        chunkBatches >= wantedBatches(context->pacing, control));
+                    }
+                    
+                    if (nextBatch < traffic.batchesPerClient()) {
+                        // Re-submit self next to its match
+                        resubmit(matchId, control);
+                    }
+                }
+                
+                void resubmit(int matchId, const AdaptiveBatchController* control) {
+                    dueNs = control ? AdaptiveBatchController::nowNs() : 0;
+                    context->pool->submitAffine(static_cast<size_t>(matchId), *this);
+                }
+            };
+            static_assert(ThreadPool::Task::fits<ClientTask>(), "ClientTask must fit inline in a pool task");
+            
+            ClientTask{&context, ring, i, 0, 0, 0, 0}();
+        });
+    }
+    
+    // 2. Match processing is event-driven: the server submits a match task
+    //    when that match's queue goes from empty to non-empty
+    
+    // Wait for everything to drain: once clients stop, no match task
+    // resubmits itself, so the pool runs dry exactly when all inputs are done
+    pool.waitAll();
+    
+    auto end = high_resolution_clock::now();
+    
+    result.timeMs = duration_cast<microseconds>(end - start).count() / 1000.0;
+    result.processedInputs = server.getProcessedCount();
+    result.rollbackCount = server.getTotalRollbackCount();
+    result.lateInputs = server.getTotalLateInputCount();
+    result.expiredInputs = server.getTotalExpiredInputCount();
+    result.workSteals = pool.getStealCount();
+    
+    TaskAllocationStats allocStats = pool.getTaskAllocationStats();
+    result.taskHeapAllocs = allocStats.heapAllocations;
+    result.taskRecycled = allocStats.recycled;
+    result.workerParks = pool.getParkCount();
+    
+    ThreadPool::AffinityStats affinity = pool.getAffinityStats();
+    result.affineHomeRuns = affinity.homeRuns;
+    result.affineAwayRuns = affinity.awayRuns;
+    result.matchTasks = server.getScheduledTaskCount();
+    result.producerBatches = mergeProducers(producers.get(), traffic.numClients());
+    result.drainQuanta = server.getDrainControlStats();
+    if (metrics::ENABLED) {
+        result.metrics = metrics::snapshot();
+    }
+    
+    return result;
+}
+
+BenchmarkResult runShardedBenchmark(const BenchmarkConfig& config, const PregeneratedTraffic& traffic,
+                                    size_t numThreads) {
+    BenchmarkResult result = {};
+    
+    size_t shards = config.numShards > 0 ? static_cast<size_t>(config.numShards) : detectNumaNodes().size();
+    ShardedServer server(traffic.numMatches(), shards, std::max<size_t>(numThreads / shards, 1));
+    if (config.adaptiveBatching) {
+        server.enableAdaptiveDrain(config.batchTargets);
+    }
+    server.setRollbackInterval(config.rollbackInterval);
+    server.setSnapshotPolicy(config.snapshotPolicy);
+    server.setSyncHook(config.syncHook);
+    server.start();
+    
+    std::unique_ptr<AdaptiveBatchController[]> producers = makeProducers(config, traffic.numClients());
+    MatchLockstep lockstep(traffic);
+    ShardedReplayContext context{&traffic, &server, {traffic.batchSize(), INPUT_DEADLINE_TICKS, nullptr},
+                                 producers.get()};
+    if (config.lateRatio > 0.0) {
+        context.pacing.maxLead += traffic.batchSize();
+        context.pacing.lockstep = &lockstep;
+    }
+    
+    metrics::reset();
+    auto start = high_resolution_clock::now();
+    
+    for (int i = 0; i < traffic.numClients(); ++i) {
+        int matchId = traffic.matchOf(i);
+        ThreadPool& pool = server.getShardPool(server.getShardOf(matchId));
+        pool.submitAffine(static_cast<size_t>(server.getLocalMatch(matchId)),
+                          ShardedClientTask{&context, i, 0, 0});
+    }
+    
+    // Client and match tasks only ever resubmit into their own shard
+    server.waitAll();
+    
+    auto end = high_resolution_clock::now();
+    
+    result.timeMs = duration_cast<microseconds>(end - start).count() / 1000.0;
+    result.processedInputs = server.getProcessedCount();
+    result.rollbackCount = server.getTotalRollbackCount();
+    result.lateInputs = server.getTotalLateInputCount();
+    result.expiredInputs = server.getTotalExpiredInputCount();
+    for (size_t s = 0; s < server.getNumShards(); ++s) {
+        const ThreadPool& pool = server.getShardPool(s);
+        result.workSteals += pool.getStealCount();
+        
+        TaskAllocationStats allocStats = pool.getTaskAllocationStats();
+        result.taskHeapAllocs += allocStats.heapAllocations;
+        result.taskRecycled += allocStats.recycled;
+        result.workerParks += pool.getParkCount();
+        
+        ThreadPool::AffinityStats affinity = pool.getAffinityStats();
+        result.affineHomeRuns += affinity.homeRuns;
+        result.affineAwayRuns += affinity.awayRuns;
+    }
+    result.matchTasks = server.getScheduledTaskCount();
+    result.producerBatches = mergeProducers(producers.get(), traffic.numClients());
+    result.drainQuanta = server.getDrainControlStats();
+    if (metrics::ENABLED) {
+        result.metrics = metrics::snapshot();
+    }
+    
+    return result;
+}
+
+BenchmarkResult runTraceReplayBenchmark(const BenchmarkConfig& config, const InputTraceReplayer& trace,
+                                        size_t numThreads, double speed, TraceReplayStats* replayStats) {
+    BenchmarkResult result = {};
+    
+    GameServer server(trace.numMatches(), std::max(MATCH_QUEUE_CAPACITY, maxInputsPerMatch(trace)));
+    ThreadPool pool(numThreads);
+    server.enableEventScheduling(pool);
+    if (config.adaptiveBatching) {
+        server.enableAdaptiveDrain(config.batchTargets);
+    }
+    server.setRollbackInterval(config.rollbackInterval);
+    server.setSnapshotPolicy(config.snapshotPolicy);
+    server.setSyncHook(config.syncHook);
+    server.start();
+    
+    metrics::reset();
+    auto start = high_resolution_clock::now();
+    
+    // This thread plays the network; match tasks drain behind it
+    TraceReplayStats stats = trace.replay(server, speed);
+    pool.waitAll();
+    
+    auto end = high_resolution_clock::now();
+    if (replayStats) {
+        *replayStats = stats;
+    }
+    
+    result.timeMs = duration_cast<microseconds>(end - start).count() / 1000.0;
+    result.processedInputs = server.getProcessedCount();
+    result.rollbackCount = server.getTotalRollbackCount();
+    result.lateInputs = server.getTotalLateInputCount();
+    result.expiredInputs = server.getTotalExpiredInputCount();
+    result.workSteals = pool.getStealCount();
+    
+    TaskAllocationStats allocStats = pool.getTaskAllocationStats();
+    result.taskHeapAllocs = allocStats.heapAllocations;
+    result.taskRecycled = allocStats.recycled;
+    result.workerParks = pool.getParkCount();
+    
+    ThreadPool::AffinityStats affinity = pool.getAffinityStats();
+    result.affineHomeRuns = affinity.homeRuns;
+    result.affineAwayRuns = affinity.awayRuns;
+    result.matchTasks = server.getScheduledTaskCount();
+    result.drainQuanta = server.getDrainControlStats();
+    if (metrics::ENABLED) {
+        result.metrics = metrics::snapshot();
+    }
+    
+    return result;
+}
+
+BenchmarkResult runUdpLoopbackBenchmark(const BenchmarkConfig& config, size_t numThreads, int ioThreads,
+                                        double packetsPerSec, UdpLoadStats* udpStats) {
+    BenchmarkResult result = {};
+    
+    // ClientManager's seats: client i plays for match (i / 2) % numMatches
+    std::vector<size_t> clientsPerMatch(static_cast<size_t>(std::max(config.numMatches, 1)), 0);
+    for (int i = 0; i < config.numClients; ++i) {
+        ++clientsPerMatch[static_cast<size_t>((i / PLAYERS_PER_MATCH) % config.numMatches)];
+    }
+    size_t busiest = *std::max_element(clientsPerMatch.begin(), clientsPerMatch.end());
+    
+    GameServer server(config.numMatches,
+                      std::max(MATCH_QUEUE_CAPACITY, busiest * static_cast<size_t>(config.inputsPerClient)));
+    ThreadPool pool(numThreads);
+    server.enableEventScheduling(pool);
+    if (config.adaptiveBatching) {
+        server.enableAdaptiveDrain(config.batchTargets);
+    }
+    server.setRollbackInterval(config.rollbackInterval);
+    server.setSnapshotPolicy(config.snapshotPolicy);
+    server.setSyncHook(config.syncHook);
+    server.start();
+    
+    UdpIngestConfig ingestConfig;
+    ingestConfig.ioThreads = ioThreads;
+    UdpIngest ingest(server, ingestConfig);
+    ingest.start();
+    
+    ClientManager clients(config.numClients, config.numMatches, config.inputsPerClient, config.lateRatio);
+    LoopbackLoadConfig load;
+    load.port = ingest.port();
+    load.senderThreads = ioThreads;
+    load.batchSize = config.batchSize;
+    load.packetsPerSec = packetsPerSec;
+    
+    metrics::reset();
+    auto start = high_resolution_clock::now();
+    
+    LoopbackLoadStats sent = clients.sendOverLoopback(load);
+    
+    // Wait out the datagrams still in flight; ones the kernel dropped never come
+    uint64_t received = ingest.getStats().datagrams;
+    auto lastProgress = high_resolution_clock::now();
+    while (received < sent.datagrams && high_resolution_clock::now() - lastProgress < milliseconds(100)) {
+        std::this_thread::sleep_for(microseconds(200));
+        uint64_t now = ingest.getStats().datagrams;
+        if (now != received) {
+            received = now;
+            lastProgress = high_resolution_clock::now();
+        }
+    }
+    ingest.stop();
+    pool.waitAll();
+    
+    auto end = high_resolution_clock::now();
+    
+    UdpIngestStats ingestStats = ingest.getStats();
+    if (udpStats) {
+        udpStats->sent = sent;
+        udpStats->received = ingestStats;
+        udpStats->droppedInputs = static_cast<size_t>(sent.inputs - ingestStats.inputs) + server.getDroppedCount();
+    }
+    
+    result.timeMs = duration_cast<microseconds>(end - start).count() / 1000.0;
+    result.processedInputs = server.getProcessedCount();
+    result.rollbackCount = server.getTotalRollbackCount();
+    result.lateInputs = server.getTotalLateInputCount();
+    result.expiredInputs = server.getTotalExpiredInputCount();
+    result.workSteals = pool.getStealCount();
+    
+    TaskAllocationStats allocStats = pool.getTaskAllocationStats();
+    result.taskHeapAllocs = allocStats.heapAllocations;
+    result.taskRecycled = allocStats.recycled;
+    result.workerParks = pool.getParkCount();
+    
+    ThreadPool::AffinityStats affinity = pool.getAffinityStats();
+    result.affineHomeRuns = affinity.homeRuns;
+    result.affineAwayRuns = affinity.awayRuns;
+    result.matchTasks = server.getScheduledTaskCount();
+    result.drainQuanta = server.getDrainControlStats();
+    if (metrics::ENABLED) {
+        result.metrics = metrics::snapshot();
+    }
+    
+    return result;
+}
+
+TickLoopStats runTickLoopBenchmark(const BenchmarkConfig& config, size_t numThreads, int hz,
+                                   milliseconds duration) {
+    GameServer server(config.numMatches);
+    ThreadPool pool(numThreads);
+    server.setRollbackInterval(config.rollbackInterval);
+    server.setSnapshotPolicy(config.snapshotPolicy);
+    server.setSyncHook(config.syncHook);
+    server.setRollbackStormMode(config.rollbackStorms);
+    server.start();
+    
+    ClientManager clientManager(config.numClients, config.numMatches, config.inputsPerClient,
+                                config.lateRatio);
+    
+    int hiccupEvery = config.hiccupEvery;
+    int hiccupTicks = std::min(config.hiccupTicks, hiccupEvery - 1);
+    return server.runTickLoop(pool, hz, duration, [&clientManager, &server, hiccupEvery, hiccupTicks](int tick) {
+        int batch = 1;
+        if (hiccupEvery > 0 && hiccupTicks > 0) {
+            // Quiet for the last hiccupTicks ticks of each period, then a burst
+            int phase = tick % hiccupEvery;
+            if (phase >= hiccupEvery - hiccupTicks) return;
+            if (phase == 0 && tick > 0) batch += hiccupTicks;
+        }
+        for (int i = 0; i < clientManager.getNumClients(); ++i) {
+            server.receiveInputs(clientManager.getClient(i)->generateBatch(batch));
+        }
+    });
+}
+
+} // namespace para
@@ -0,0 +1,142 @@
+#ifndef BENCHMARK_HPP
+#define BENCHMARK_HPP
+
+#include "../common/types.hpp"
+#include "../common/metrics.hpp"
+#include "../common/adaptive_batch.hpp"
+#include "../game/game_server.hpp"
+#include "../game/input_trace.hpp"
+#include "../game/sharded_server.hpp"
+#include "../client/client.hpp"
+#include "../net/udp_ingest.hpp"
+#include <chrono>
+#include <cstddef>
+
+namespace para {
+
+/**
+ * Workload shape shared by the demo (main.cpp) and bench/pipeline_bench
+ * The traffic fields go to PregeneratedTraffic::generate(); the runs take
+ * rollbackInterval and lateRatio (client pacing) from here
+ *
+ * With adaptiveBatching, every match drains at most an adaptive quantum per
+ * call and every pipeline client sizes its sends with its own controller
+ * (both after batchTargets). A send is still made of whole recorded
+ * batches and never runs past the client's pacing lead, so a small
+ * batchSize gives the producer side room to adapt.
+ */
+struct BenchmarkConfig {
+    int numMatches = NUM_MATCHES;
+    int numClients = NUM_CLIENTS;
+    int inputsPerClient = INPUTS_PER_CLIENT;
+    int batchSize = 50;                       // Inputs a client sends per batch
+    int rollbackInterval = ROLLBACK_INTERVAL; // Ticks between demo rollbacks (0: none)
+    SnapshotPolicy snapshotPolicy = SnapshotPolicy::FULL;  // How every match stores its snapshots
+    SyncHook syncHook;                                      // Every server's sync hook (empty: off)
+    double lateRatio = 0.0;                   // Fraction of inputs sent past their deadline
+    int numShards = 0;                        // Sharded mode: 0 = one per NUMA node
+    bool adaptiveBatching = false;            // Adaptive client sends and drain quanta
+    BatchTargets batchTargets;
+    bool rollbackStorms = false;              // Tick loop: GameServer rollback-storm mode
+    int hiccupEvery = 0;                      // Tick loop: ticks between network hiccups (0: none)
+    int hiccupTicks = 8;                      // Tick loop: ticks of input a hiccup holds back
+};
+
+/**
+ * Benchmark result structure
+ */
+struct BenchmarkResult {
+    double timeMs;
+    size_t processedInputs;
+    int rollbackCount;
+    int lateInputs;          // Inputs that arrived after their tick was simulated
+    int expiredInputs;       // Inputs that arrived after their tick left the rollback window
+    size_t workSteals;
+    size_t taskHeapAllocs;   // Task nodes allocated with new (pool warm-up)
+    size_t taskRecycled;     // Task nodes reused from the pool
+    size_t workerParks;      // Times an idle worker went to sleep
+    size_t affineHomeRuns;   // Match tasks run on their home worker
+    size_t affineAwayRuns;   // Match tasks stolen by another worker
+    size_t matchTasks;       // Match tasks scheduled by the server
+    BatchControlStats producerBatches;  // Adaptive batching: sizes clients chose (inputs)
+    BatchControlStats drainQuanta;      // Adaptive batching: drain caps matches chose
+    metrics::MetricsSnapshot metrics;  // Empty unless built with PARA_ENABLE_METRICS
+};
+
+class PregeneratedTraffic;
+
+/**
+ * Run sequential benchmark
+ * Enqueues all of traffic first, then processes it sequentially
+ * (only the processing is timed)
+ */
+BenchmarkResult runSequentialBenchmark(const BenchmarkConfig& config, const PregeneratedTraffic& traffic);
+
+/**
+ * Run task-based concurrent benchmark
+ * Pipeline: Client Task (Replay) -> Server (Queue) -> Match Task (Process)
+ * Client tasks send traffic's recorded batches, paced by their match;
+ * match tasks are scheduled by the server on demand (event-driven).
+ * directInput: clients write into per-player SPSC rings instead; needs
+ * at most one client per player (numClients <= 2 * numMatches)
+ * recorder, if given, captures what the server receives (not in direct mode)
+ */
+BenchmarkResult runConcurrentBenchmark(const BenchmarkConfig& config, const PregeneratedTraffic& traffic,
+                                       size_t numThreads, bool directInput,
+                                       InputTraceRecorder* recorder = nullptr);
+
+/**
+ * Run the pipeline on a ShardedServer (config.numShards shards)
+ * numThreads is split evenly across the shards' pools (at least one
+ * worker each); every client task runs in its match's shard and sends
+ * through the sharded front end
+ */
+BenchmarkResult runShardedBenchmark(const BenchmarkConfig& config, const PregeneratedTraffic& traffic,
+                                    size_t numThreads);
+
+/**
+ * Replay a recorded input trace into an event-scheduled server
+ * speed as for InputTraceReplayer::replay(); the run ends when every
+ * replayed input has been processed. Match queues hold a match's whole
+ * trace, so a replay that outruns the server queues instead of dropping.
+ * Only config.rollbackInterval is used; sets replayStats if given
+ */
+BenchmarkResult runTraceReplayBenchmark(const BenchmarkConfig& config, const InputTraceReplayer& trace,
+                                        size_t numThreads, double speed,
+                                        TraceReplayStats* replayStats = nullptr);
+
+/**
+ * What runUdpLoopbackBenchmark() sent and received
+ */
+struct UdpLoadStats {
+    LoopbackLoadStats sent;
+    UdpIngestStats received;
+    size_t droppedInputs;     // Sent but never queued: lost datagrams or full match queues
+};
+
+/**
+ * Run the pipeline behind a UDP front end over loopback
+ * A ClientManager in load-generator mode sends on ioThreads threads (each
+ * config.batchSize inputs per datagram, at most packetsPerSec in total, 0:
+ * unpaced) to a UdpIngest with ioThreads receiving threads, which feeds
+ * an event-scheduled server on a numThreads pool. Nothing paces the
+ * clients by their match, so match queues hold a match's whole stream.
+ * The run ends when every datagram has arrived (or none has for 100 ms)
+ * and the pool has run dry. Linux only: throws std::runtime_error elsewhere
+ */
+BenchmarkResult runUdpLoopbackBenchmark(const BenchmarkConfig& config, size_t numThreads, int ioThreads,
+                                        double packetsPerSec = 0.0, UdpLoadStats* udpStats = nullptr);
+
+/**
+ * Run the fixed-rate tick loop for duration at hz
+ * Every client sends one input per tick, at the start of the tick. With
+ * config.hiccupEvery, every client goes quiet for config.hiccupTicks ticks
+ * that often and then sends everything it held back at once: those inputs
+ * are all late, so every match rolls back in the same tick
+ */
+TickLoopStats runTickLoopBenchmark(const BenchmarkConfig& config, size_t numThreads, int hz,
+                                   std::chrono::milliseconds duration);
+
+} // namespace para
+
+#endif // BENCHMARK_HPP
@@ -0,0 +1,111 @@
+#include "traffic.hpp"
+#include "../client/client.hpp"
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <stdexcept>
+
+namespace para {
+
+using namespace std::chrono;
+
+namespace {
+
+const char TRAFFIC_MAGIC[8] = {'P', 'A', 'R', 'A', 'T', 'R', 'F', '1'};
+
+uint64_t alignTo64(uint64_t offset) {
+    return (offset + 63) & ~uint64_t(63);
+}
+
+} // namespace
+
+void PregeneratedTraffic::layout(Header& header) {
+    header.batchEndsOffset = sizeof(Header) + uint64_t(header.numClients) * sizeof(ClientEntry);
+    header.inputsOffset = alignTo64(header.batchEndsOffset +
+                                    uint64_t(header.numClients) * header.batchesPerClient * sizeof(uint32_t));
+    header.imageSize = header.inputsOffset +
+                       uint64_t(header.numClients) * header.inputsPerClient * sizeof(PackedInput);
+}
+
+PregeneratedTraffic PregeneratedTraffic::generate(const BenchmarkConfig& config, ThreadPool& pool,
+                                                  const std::string& path) {
+    auto start = high_resolution_clock::now();
+
+    ClientManager clientManager(config.numClients, config.numMatches, config.inputsPerClient,
+                                config.lateRatio);
+    int batchSize = std::max(config.batchSize, 1);
+
+    Header header = {};
+    std::memcpy(header.magic, TRAFFIC_MAGIC, sizeof(TRAFFIC_MAGIC));
+    header.version = VERSION;
+    header.numClients = static_cast<uint32_t>(config.numClients);
+    header.numMatches = static_cast<uint32_t>(config.numMatches);
+    header.inputsPerClient = static_cast<uint32_t>(config.inputsPerClient);
+    header.batchSize = static_cast<uint32_t>(batchSize);
+    header.batchesPerClient = static_cast<uint32_t>((config.inputsPerClient + batchSize - 1) / batchSize);
+    header.lateRatio = config.lateRatio;
+    layout(header);
+
+    PregeneratedTraffic traffic;
+    if (path.empty()) {
+        traffic.heap_.reset(new uint8_t[header.imageSize]);
+    } else {
+        traffic.file_ = MappedFile::create(path, header.imageSize);
+    }
+
+    uint8_t* base = traffic.image();
+    std::memcpy(base, &header, sizeof(Header));
+
+    ClientEntry* entries = reinterpret_cast<ClientEntry*>(base + sizeof(Header));
+    uint32_t* ends = reinterpret_cast<uint32_t*>(base + header.batchEndsOffset);
+    PackedInput* inputs = reinterpret_cast<PackedInput*>(base + header.inputsOffset);
+    size_t batches = header.batchesPerClient;
+
+    // Clients are independent (own RNG, own slice of the image): one task each
+    for (int c = 0; c < config.numClients; ++c) {
+        Client* client = clientManager.getClient(c);
+        entries[c] = ClientEntry{static_cast<uint32_t>(client->getMatchId()),
+                                 static_cast<uint32_t>(client->getPlayerId())};
+
+        PackedInput* out = inputs + static_cast<size_t>(c) * header.inputsPerClient;
+        uint32_t* clientEnds = ends + static_cast<size_t>(c) * batches;
+        pool.submit([client, out, clientEnds, batches, batchSize]() {
+            uint32_t written = 0;
+            for (size_t b = 0; b < batches; ++b) {
+                InputBatch batch = client->generateBatch(batchSize);
+                std::copy(batch.begin(), batch.end(), out + written);
+                written += static_cast<uint32_t>(batch.size());
+                clientEnds[b] = written;
+            }
+        });
+    }
+    pool.waitAll();
+
+    auto end = high_resolution_clock::now();
+    traffic.generationMs_ = duration_cast<microseconds>(end - start).count() / 1000.0;
+    return traffic;
+}
+
+PregeneratedTraffic PregeneratedTraffic::open(const std::string& path) {
+    PregeneratedTraffic traffic;
+    traffic.file_ = MappedFile::open(path);
+
+    if (traffic.file_.size() < sizeof(Header)) {
+        throw std::runtime_error("PregeneratedTraffic: file too small: " + path);
+    }
+    const Header& header = traffic.header();
+    if (std::memcmp(header.magic, TRAFFIC_MAGIC, sizeof(TRAFFIC_MAGIC)) != 0 || header.version != VERSION) {
+        throw std::runtime_error("PregeneratedTraffic: not a traffic file: " + path);
+    }
+
+    // The stored offsets must be the ones this build would compute
+    Header expected = header;
+    layout(expected);
+    if (expected.inputsOffset != header.inputsOffset || expected.imageSize != header.imageSize ||
+        header.imageSize > traffic.file_.size()) {
+        throw std::runtime_error("PregeneratedTraffic: truncated or inconsistent file: " + path);
+    }
+    return traffic;
+}
+
+} // namespace para
@@ -0,0 +1,134 @@
+#ifndef TRAFFIC_HPP
+#define TRAFFIC_HPP
+
+#include "benchmark.hpp"
+#include "../common/data_structures.hpp"
+#include "../common/mapped_file.hpp"
+#include "../scheduler/thread_pool.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+
+namespace para {
+
+/**
+ * PregeneratedTraffic - Every client's input stream, generated ahead of time
+ *
+ * generate() runs one Client per pool task (each seeded by its clientId,
+ * so the result does not depend on the thread count) and records exactly
+ * the batches the client would have sent live, late inputs included.
+ * Both benchmark modes replay it, so they see identical traffic and the
+ * generation cost is measured on its own (generationMs()).
+ *
+ * Storage is one flat image, on the heap or, given a path, in a
+ * memory-mapped file the workers write into directly; open() maps such a
+ * file back read-only. Image layout (native byte order):
+ *   Header
+ *   ClientEntry[numClients]
+ *   uint32 batchEnds[numClients * batchesPerClient]   (per client, cumulative)
+ *   PackedInput inputs[numClients * inputsPerClient]  (64-byte aligned, per client)
+ */
+class PregeneratedTraffic {
+public:
+    static constexpr uint32_t VERSION = 1;
+
+    PregeneratedTraffic(PregeneratedTraffic&&) = default;
+    PregeneratedTraffic& operator=(PregeneratedTraffic&&) = default;
+
+    /**
+     * Generate the traffic for config on pool; streams into a new file at
+     * path if not empty. Throws std::runtime_error if the file can't be made
+     */
+    static PregeneratedTraffic generate(const BenchmarkConfig& config, ThreadPool& pool,
+                                        const std::string& path = "");
+
+    /**
+     * Map a file written by generate(). Throws std::runtime_error if it is
+     * not a traffic image
+     */
+    static PregeneratedTraffic open(const std::string& path);
+
+    int numClients() const { return static_cast<int>(header().numClients); }
+    int numMatches() const { return static_cast<int>(header().numMatches); }
+    int inputsPerClient() const { return static_cast<int>(header().inputsPerClient); }
+    int batchSize() const { return static_cast<int>(header().batchSize); }
+    size_t batchesPerClient() const { return header().batchesPerClient; }
+    size_t totalInputs() const { return static_cast<size_t>(header().numClients) * header().inputsPerClient; }
+
+    int matchOf(int client) const { return static_cast<int>(clients()[client].matchId); }
+    int playerOf(int client) const { return static_cast<int>(clients()[client].playerId); }
+
+    /**
+     * Inputs of one client's batch (in send order); sets count
+     */
+    const PackedInput* batch(int client, size_t index, size_t& count) const {
+        return batches(client, index, 1, count);
+    }
+
+    /**
+     * Inputs of n consecutive batches of one client, which are contiguous
+     * (so they can go out as one send); sets count
+     */
+    const PackedInput* batches(int client, size_t first, size_t n, size_t& count) const {
+        const uint32_t* ends = batchEnds() + static_cast<size_t>(client) * batchesPerClient();
+        uint32_t begin = first == 0 ? 0 : ends[first - 1];
+        count = ends[first + n - 1] - begin;
+        return inputs() + static_cast<size_t>(client) * header().inputsPerClient + begin;
+    }
+
+    /**
+     * First tick of a batch's on-time inputs (its late extras are older)
+     */
+    int batchStartTick(size_t index) const {
+        return static_cast<int>(index) * batchSize();
+    }
+
+    double generationMs() const { return generationMs_; }
+    bool isMapped() const { return file_.isOpen(); }
+
+private:
+    struct Header {
+        char magic[8];
+        uint32_t version;
+        uint32_t numClients;
+        uint32_t numMatches;
+        uint32_t inputsPerClient;
+        uint32_t batchSize;
+        uint32_t batchesPerClient;
+        double lateRatio;
+        uint64_t batchEndsOffset;
+        uint64_t inputsOffset;
+        uint64_t imageSize;
+    };
+
+    struct ClientEntry {
+        uint32_t matchId;
+        uint32_t playerId;
+    };
+
+    PregeneratedTraffic() = default;
+
+    static void layout(Header& header);
+
+    const uint8_t* image() const { return file_.isOpen() ? file_.data() : heap_.get(); }
+    uint8_t* image() { return file_.isOpen() ? file_.data() : heap_.get(); }
+
+    const Header& header() const { return *reinterpret_cast<const Header*>(image()); }
+    const ClientEntry* clients() const { return reinterpret_cast<const ClientEntry*>(image() + sizeof(Header)); }
+    const uint32_t* batchEnds() const {
+        return reinterpret_cast<const uint32_t*>(image() + header().batchEndsOffset);
+    }
+    const PackedInput* inputs() const {
+        return reinterpret_cast<const PackedInput*>(image() + header().inputsOffset);
+    }
+
+private:
+    MappedFile file_;
+    std::unique_ptr<uint8_t[]> heap_;
+    double generationMs_ = 0.0;
+};
+
+} // namespace para
+
+#endif // TRAFFIC_HPP
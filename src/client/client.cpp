@@ -1,4 +1,21 @@
 #include "client.hpp"
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cstddef>
+#include <cstring>
+#include <functional>
+#include <stdexcept>
+#include <string>
+#include <thread>
+
+#ifdef __linux__
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#include <cerrno>
+#endif
 
 namespace para {
 
@@ -6,40 +23,118 @@ namespace para {
 // Client Implementation
 // ============================================
 
-Client::Client(int clientId, int matchId, int playerId, int numInputs)
+Client::Client(int clientId, int matchId, int playerId, int numInputs, double lateRatio)
     : clientId_(clientId)
     , matchId_(matchId)
     , playerId_(playerId)
     , numInputs_(numInputs)
     , currentTick_(0)
+    , lateRatio_(lateRatio)
     , rng_(clientId)  // Seed with clientId for reproducible results
 {
 }
 
-std::vector<Input> Client::generateBatch(int batchSize) {
-    std::vector<Input> batch;
-    batch.reserve(batchSize);
+InputBatch Client::generateBatch(int batchSize) {
+    InputBatch batch = InputBatchPool::acquire(static_cast<size_t>(std::max(batchSize, 0)) + held_.size());
     
     std::uniform_int_distribution<int> actionDist(0, 3);
     
     int endTick = std::min(currentTick_ + batchSize, numInputs_);
     
     for (int i = currentTick_; i < endTick; ++i) {
-        Input input;
-        input.matchId = matchId_;
-        input.playerId = playerId_;
-        input.tickId = i;
-        input.type = static_cast<ActionType>(actionDist(rng_));
+        ActionType type = static_cast<ActionType>(actionDist(rng_));
+        PackedInput input(matchId_, playerId_, i, type);
+        if (!holdBack(i, input)) {
+            batch.push_back(input);
+        }
         
-        batch.push_back(input);
+        // Held inputs go right behind the newer tick that made them late
+        size_t due = dueHeldInputs(i);
+        for (size_t h = 0; h < due; ++h) {
+            batch.push_back(held_[h].input);
+        }
+        held_.erase(held_.begin(), held_.begin() + due);
     }
     
     currentTick_ = endTick;
+    
+    // The last batch takes whatever is still held
+    if (currentTick_ >= numInputs_) {
+        for (const HeldInput& held : held_) {
+            batch.push_back(held.input);
+        }
+        held_.clear();
+    }
     return batch;
 }
 
+size_t Client::generateInto(SpscRing<PackedInput>& ring, int batchSize) {
+    std::uniform_int_distribution<int> actionDist(0, 3);
+    
+    int endTick = std::min(currentTick_ + batchSize, numInputs_);
+    size_t written = 0;
+    
+    while (currentTick_ < endTick) {
+        // The free run may stop at the end of the buffer: take it in pieces
+        size_t count;
+        PackedInput* slots = ring.reserve(static_cast<size_t>(endTick - currentTick_), count);
+        if (count == 0) break;
+        
+        // Stop the piece at a tick that makes held inputs due: they go next
+        size_t filled = 0;
+        size_t used = 0;
+        bool heldDue = false;
+        while (used < count && !heldDue) {
+            int tick = currentTick_ + static_cast<int>(used++);
+            ActionType type = static_cast<ActionType>(actionDist(rng_));
+            PackedInput input(matchId_, playerId_, tick, type);
+            if (!holdBack(tick, input)) {
+                slots[filled++] = input;
+            }
+            heldDue = dueHeldInputs(tick) > 0;
+        }
+        
+        ring.commit(filled);
+        currentTick_ += static_cast<int>(used);
+        written += filled;
+        written += pushHeldInputs(ring);
+    }
+    
+    // The rest only if the ring had no room for them above
+    return written + pushHeldInputs(ring);
+}
+
+size_t Client::pushHeldInputs(SpscRing<PackedInput>& ring) {
+    // Held inputs that are due, as far as the ring has room
+    size_t due = currentTick_ >= numInputs_ ? held_.size() : dueHeldInputs(currentTick_ - 1);
+    size_t sent = 0;
+    while (sent < due && ring.tryPush(held_[sent].input)) {
+        ++sent;
+    }
+    held_.erase(held_.begin(), held_.begin() + sent);
+    return sent;
+}
+
+bool Client::holdBack(int tick, PackedInput input) {
+    if (lateRatio_ <= 0.0) return false;
+    
+    std::uniform_real_distribution<double> lateDist(0.0, 1.0);
+    if (lateDist(rng_) >= lateRatio_) return false;
+    
+    held_.push_back(HeldInput{tick, input});
+    return true;
+}
+
+size_t Client::dueHeldInputs(int newestTick) const {
+    size_t due = 0;
+    while (due < held_.size() && newestTick - held_[due].tick >= LATE_INPUT_DELAY_TICKS) {
+        ++due;
+    }
+    return due;
+}
+
 bool Client::isFinished() const {
-    return currentTick_ >= numInputs_;
+    return currentTick_ >= numInputs_ && held_.empty();
 }
 
 int Client::getClientId() const {
@@ -54,6 +149,10 @@ int Client::getPlayerId() const {
     return playerId_;
 }
 
+int Client::getNextTick() const {
+    return currentTick_;
+}
+
 size_t Client::getNumInputs() const {
     return numInputs_;
 }
@@ -62,7 +161,7 @@ size_t Client::getNumInputs() const {
 // ClientManager Implementation
 // ============================================
 
-ClientManager::ClientManager(int numClients, int numMatches, int inputsPerClient)
+ClientManager::ClientManager(int numClients, int numMatches, int inputsPerClient, double lateRatio)
     : numClients_(numClients)
     , numMatches_(numMatches)
     , inputsPerClient_(inputsPerClient)
@@ -77,7 +176,7 @@ ClientManager::ClientManager(int numClients, int numMatches, int inputsPerClient
             matchId = matchId % numMatches;
         }
         
-        clients_.emplace_back(i, matchId, playerId, inputsPerClient);
+        clients_.emplace_back(i, matchId, playerId, inputsPerClient, lateRatio);
     }
 }
 
@@ -88,6 +187,158 @@ Client* ClientManager::getClient(int index) {
     return nullptr;
 }
 
+#ifdef __linux__
+
+namespace {
+
+// One sender thread: a connected socket (one flow) and its share of the clients
+struct LoopbackSender {
+    int socketFd = -1;
+    std::vector<Client*> clients;
+    uint64_t datagrams = 0;
+    uint64_t inputs = 0;
+    uint64_t sendCalls = 0;
+};
+
+void waitUntil(uint64_t dueNs) {
+    for (uint64_t now = datagramClockNs(); now < dueNs; now = datagramClockNs()) {
+        if (dueNs - now > 100000) {
+            std::this_thread::sleep_for(std::chrono::nanoseconds(dueNs - now - 50000));
+        } else {
+            std::this_thread::yield();
+        }
+    }
+}
+
+void runSender(LoopbackSender& sender, int batchSize, uint64_t intervalNs) {
+    constexpr int SEND_BATCH = ClientManager::SEND_BATCH;
+    std::vector<unsigned char> buffer(SEND_BATCH * MAX_DATAGRAM_BYTES);
+    std::array<iovec, SEND_BATCH> iov{};
+    std::array<mmsghdr, SEND_BATCH> messages{};
+    std::array<size_t, SEND_BATCH> counts{};
+    for (int k = 0; k < SEND_BATCH; ++k) {
+        messages[k].msg_hdr.msg_iov = &iov[k];
+        messages[k].msg_hdr.msg_iovlen = 1;
+    }
+    
+    int queued = 0;
+    uint64_t dueNs = datagramClockNs();
+    auto flush = [&]() {
+        if (queued == 0) return;
+        if (intervalNs > 0) {
+            dueNs += queued * intervalNs;
+            waitUntil(dueNs);
+        }
+        
+        // Stamped as they go out, so the latency is the receive path's alone
+        uint64_t sentNs = datagramClockNs();
+        for (int k = 0; k < queued; ++k) {
+            std::memcpy(buffer.data() + k * MAX_DATAGRAM_BYTES + offsetof(DatagramHeader, sentNs),
+                        &sentNs, sizeof(sentNs));
+        }
+        
+        int sent = 0;
+        while (sent < queued) {
+            int n = ::sendmmsg(sender.socketFd, messages.data() + sent, static_cast<unsigned>(queued - sent), 0);
+            if (n < 0) {
+                if (errno == EINTR || errno == EAGAIN || errno == ENOBUFS) {
+                    std::this_thread::yield();
+                    continue;
+                }
+                break;  // E.g. ECONNREFUSED: nobody listening, the rest is dropped
+            }
+            for (int k = sent; k < sent + n; ++k) {
+                sender.inputs += counts[k];
+            }
+            sender.datagrams += static_cast<uint64_t>(n);
+            ++sender.sendCalls;
+            sent += n;
+        }
+        queued = 0;
+    };
+    
+    // Round-robin: one batch per unfinished client per pass, as clients
+    // sending at the same rate would
+    bool active = true;
+    while (active) {
+        active = false;
+        for (Client* client : sender.clients) {
+            if (client->isFinished()) continue;
+            active = true;
+            
+            InputBatch batch = client->generateBatch(batchSize);
+            for (size_t offset = 0; offset < batch.size(); offset += MAX_DATAGRAM_INPUTS) {
+                size_t count = std::min(MAX_DATAGRAM_INPUTS, batch.size() - offset);
+                unsigned char* datagram = buffer.data() + queued * MAX_DATAGRAM_BYTES;
+                iov[queued].iov_base = datagram;
+                iov[queued].iov_len = encodeDatagram(datagram, batch.data() + offset, count, 0);
+                counts[queued] = count;
+                if (++queued == SEND_BATCH) flush();
+            }
+        }
+        flush();
+    }
+}
+
+} // namespace
+
+#endif
+
+LoopbackLoadStats ClientManager::sendOverLoopback(const LoopbackLoadConfig& config) {
+#ifdef __linux__
+    if (config.senderThreads <= 0 || config.batchSize <= 0 || config.port == 0) {
+        throw std::invalid_argument("ClientManager::sendOverLoopback: needs a port and positive threads and batch");
+    }
+    
+    int threads = config.senderThreads;
+    std::vector<LoopbackSender> senders(threads);
+    sockaddr_in address{};
+    address.sin_family = AF_INET;
+    address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    address.sin_port = htons(config.port);
+    for (LoopbackSender& sender : senders) {
+        sender.socketFd = ::socket(AF_INET, SOCK_DGRAM | SOCK_CLOEXEC, 0);
+        if (sender.socketFd < 0 ||
+            ::connect(sender.socketFd, reinterpret_cast<const sockaddr*>(&address), sizeof(address)) != 0) {
+            for (LoopbackSender& open : senders) {
+                if (open.socketFd >= 0) ::close(open.socketFd);
+            }
+            throw std::runtime_error("ClientManager::sendOverLoopback: cannot connect to 127.0.0.1:" +
+                                     std::to_string(config.port));
+        }
+    }
+    // A match's clients share a sender, so its players stay in step
+    for (Client& client : clients_) {
+        senders[static_cast<size_t>(client.getMatchId() % threads)].clients.push_back(&client);
+    }
+    
+    uint64_t intervalNs = config.packetsPerSec > 0.0
+        ? static_cast<uint64_t>(threads * 1e9 / config.packetsPerSec) : 0;
+    uint64_t startNs = datagramClockNs();
+    std::vector<std::thread> workers;
+    for (LoopbackSender& sender : senders) {
+        workers.emplace_back(runSender, std::ref(sender), config.batchSize, intervalNs);
+    }
+    for (std::thread& worker : workers) {
+        worker.join();
+    }
+    uint64_t endNs = datagramClockNs();
+    
+    LoopbackLoadStats stats{};
+    for (LoopbackSender& sender : senders) {
+        ::close(sender.socketFd);
+        stats.datagrams += sender.datagrams;
+        stats.inputs += sender.inputs;
+        stats.sendCalls += sender.sendCalls;
+    }
+    stats.elapsedMs = (endNs - startNs) / 1e6;
+    return stats;
+#else
+    (void)config;
+    throw std::runtime_error("ClientManager::sendOverLoopback: needs Linux (sendmmsg)");
+#endif
+}
+
 int ClientManager::getNumClients() const {
     return numClients_;
 }
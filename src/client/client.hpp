@@ -3,6 +3,10 @@
 
 #include "../common/types.hpp"
 #include "../common/data_structures.hpp"
+#include "../common/buffer_pool.hpp"
+#include "../common/spsc_ring.hpp"
+#include "../net/datagram.hpp"
+#include <cstdint>
 #include <vector>
 #include <random>
 
@@ -12,19 +16,39 @@ namespace para {
  * Client - Simulates a game client that sends inputs
  * 
  * Each client belongs to a specific match and player
+ *
+ * With a late ratio, that fraction of inputs is held back and sent right
+ * behind the input LATE_INPUT_DELAY_TICKS newer, i.e. just after the
+ * input's tick has passed the match's deadline but while it is still in
+ * the rollback window
  */
 class Client {
 public:
-    Client(int clientId, int matchId, int playerId, int numInputs = INPUTS_PER_CLIENT);
+    static constexpr int LATE_INPUT_DELAY_TICKS = INPUT_DEADLINE_TICKS + 1;
+    
+    static_assert(LATE_INPUT_DELAY_TICKS > INPUT_DEADLINE_TICKS && LATE_INPUT_DELAY_TICKS < MAX_ROLLBACK_TICKS,
+                  "Late inputs must miss the deadline and still be repairable by a rollback");
+    
+    Client(int clientId, int matchId, int playerId, int numInputs = INPUTS_PER_CLIENT,
+           double lateRatio = 0.0);
     
     /**
      * Generate inputs for the next batch of ticks
-     * Returns a vector of generated inputs
+     * Returns the inputs in wire (packed) form, in a buffer leased from the
+     * calling thread's InputBatchPool; it goes back to the pool when the
+     * batch is destroyed or handed to GameServer::receiveInputs()
+     */
+    InputBatch generateBatch(int batchSize);
+    
+    /**
+     * Generate up to batchSize inputs straight into reserved slots of ring
+     * (this client must be its only producer) and commit them
+     * Stops early if the ring is full; returns the number written
      */
-    std::vector<Input> generateBatch(int batchSize);
+    size_t generateInto(SpscRing<PackedInput>& ring, int batchSize);
     
     /**
-     * Check if client has finished generating all inputs
+     * Check if client has finished generating (and sending) all inputs
      */
     bool isFinished() const;
     
@@ -35,6 +59,7 @@ public:
     int getClientId() const;
     int getMatchId() const;
     int getPlayerId() const;
+    int getNextTick() const;  // Tick of the next input to generate
     size_t getNumInputs() const;
 
 private:
@@ -44,23 +69,74 @@ private:
     int numInputs_;
     int currentTick_; // Track current generation progress
     
+    // Inputs held back to arrive late, oldest first
+    struct HeldInput {
+        int tick;
+        PackedInput input;
+    };
+    
+    // True if input goes to held_ instead of out now (draws only if lateRatio_ > 0)
+    bool holdBack(int tick, PackedInput input);
+    
+    // Push the due held inputs into ring as far as it has room; returns the count pushed
+    size_t pushHeldInputs(SpscRing<PackedInput>& ring);
+    
+    // Number of held inputs, from the front, that are due once the input
+    // for newestTick is out
+    size_t dueHeldInputs(int newestTick) const;
+    
+    double lateRatio_;
+    std::vector<HeldInput> held_;
+    
     // std::vector<Input> inputs_; // Removed to save memory in streaming mode
     std::mt19937 rng_;
 };
 
+/**
+ * ClientManager::sendOverLoopback() settings
+ */
+struct LoopbackLoadConfig {
+    uint16_t port = 0;            // UdpIngest port on 127.0.0.1
+    int senderThreads = 1;        // One UDP socket each; thread t sends for matches t, t + N, ...
+    int batchSize = 50;           // Inputs per client batch (split at MAX_DATAGRAM_INPUTS)
+    double packetsPerSec = 0.0;   // Total send rate (0: as fast as the sockets take them)
+};
+
+struct LoopbackLoadStats {
+    uint64_t datagrams;
+    uint64_t inputs;
+    uint64_t sendCalls;           // sendmmsg calls
+    double elapsedMs;             // First to last send
+};
+
 /**
  * ClientManager - Manages all clients for simulation
+ *
+ * In load-generator mode (sendOverLoopback) the clients send their inputs
+ * as datagrams to a UdpIngest on the same host
  */
 class ClientManager {
 public:
     ClientManager(int numClients = NUM_CLIENTS, int numMatches = NUM_MATCHES, 
-                  int inputsPerClient = INPUTS_PER_CLIENT);
+                  int inputsPerClient = INPUTS_PER_CLIENT, double lateRatio = 0.0);
     
     // Legacy: Generate all inputs for all clients
     // void generateAllInputs();
     // std::vector<Input> getAllInputs() const;
     
     Client* getClient(int index);
+    
+    /**
+     * Load-generator mode: run every client to completion, each batch sent
+     * as a datagram to 127.0.0.1:port, round-robin over a sender thread's
+     * clients and up to SEND_BATCH datagrams per sendmmsg call. Returns
+     * once everything is sent (UDP: the receiver may still drop some).
+     * Linux only; throws std::runtime_error elsewhere or if a socket
+     * cannot be set up
+     */
+    LoopbackLoadStats sendOverLoopback(const LoopbackLoadConfig& config);
+    
+    static constexpr int SEND_BATCH = 32;
 
     int getNumClients() const;
     size_t getTotalInputs() const;
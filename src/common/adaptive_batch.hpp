@@ -0,0 +1,178 @@
+#ifndef ADAPTIVE_BATCH_HPP
+#define ADAPTIVE_BATCH_HPP
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+
+namespace para {
+
+/**
+ * Targets for an AdaptiveBatchController
+ *
+ * latencyNs is the budget for one call: a drain's run time on the
+ * consumer side, a client task's wait in the pool on the producer side.
+ * queueDepth is the consumer backlog above which producers stop growing
+ * their batches and back off.
+ */
+struct BatchTargets {
+    size_t minSize = 1;
+    size_t maxSize = 4096;
+    size_t initialSize = 64;
+    uint64_t latencyNs = 250000;
+    size_t queueDepth = 1024;
+};
+
+/**
+ * Sizes one controller (or a merged group) chose
+ */
+struct BatchControlStats {
+    size_t samples = 0;   // Decisions made
+    size_t sizeSum = 0;   // Sum of the sizes in effect at each decision
+    size_t grows = 0;
+    size_t shrinks = 0;
+    size_t current = 0;   // Last size (max across a merged group)
+
+    double mean() const { return samples ? static_cast<double>(sizeSum) / samples : 0.0; }
+
+    void merge(const BatchControlStats& other) {
+        samples += other.samples;
+        sizeSum += other.sizeSum;
+        grows += other.grows;
+        shrinks += other.shrinks;
+        current = std::max(current, other.current);
+    }
+};
+
+/**
+ * AdaptiveBatchController - Batch size steered by queue depth and latency
+ *
+ * Grows the size by a quarter while the observed latency stays within
+ * budget and the size was the limit (a send or a drain used all of it), and
+ * halves it as soon as a call goes over budget (or, for producers, the
+ * consumer's queue is deeper than the target). The size always stays
+ * within [minSize, maxSize].
+ *
+ * One thread at a time feeds it (the queue's consumer, or the producing
+ * client); size() and stats() may be read from any thread.
+ */
+class AdaptiveBatchController {
+public:
+    AdaptiveBatchController() {
+        configure(BatchTargets());
+    }
+
+    explicit AdaptiveBatchController(const BatchTargets& targets) {
+        configure(targets);
+    }
+
+    AdaptiveBatchController(const AdaptiveBatchController&) = delete;
+    AdaptiveBatchController& operator=(const AdaptiveBatchController&) = delete;
+
+    /**
+     * Reset to targets (not while another thread is feeding it)
+     */
+    void configure(const BatchTargets& targets) {
+        targets_ = targets;
+        targets_.minSize = std::max<size_t>(targets_.minSize, 1);
+        targets_.maxSize = std::max(targets_.maxSize, targets_.minSize);
+        size_.store(std::min(std::max(targets_.initialSize, targets_.minSize), targets_.maxSize),
+                    std::memory_order_relaxed);
+        samples_.store(0, std::memory_order_relaxed);
+        sizeSum_.store(0, std::memory_order_relaxed);
+        grows_.store(0, std::memory_order_relaxed);
+        shrinks_.store(0, std::memory_order_relaxed);
+    }
+
+    size_t size() const {
+        return size_.load(std::memory_order_relaxed);
+    }
+
+    const BatchTargets& targets() const {
+        return targets_;
+    }
+
+    /**
+     * Producer feedback after a send: waitNs since the send was due,
+     * queueDepth of the consumer it went to, and whether the send was as
+     * big as size() asked for (not cut short by the producer's own limits)
+     */
+    void onSend(uint64_t waitNs, size_t queueDepth, bool filled) {
+        note();
+        if (waitNs > targets_.latencyNs || queueDepth > targets_.queueDepth) {
+            shrink();
+        } else if (filled) {
+            grow();
+        }
+    }
+
+    /**
+     * Consumer feedback after a drain of at most size() items: how long it
+     * took and how many items it had to leave queued
+     */
+    void onDrain(uint64_t drainNs, size_t leftBehind) {
+        note();
+        if (drainNs > targets_.latencyNs) {
+            shrink();
+        } else if (leftBehind > 0) {
+            grow();
+        }
+    }
+
+    BatchControlStats stats() const {
+        BatchControlStats stats;
+        stats.samples = samples_.load(std::memory_order_relaxed);
+        stats.sizeSum = sizeSum_.load(std::memory_order_relaxed);
+        stats.grows = grows_.load(std::memory_order_relaxed);
+        stats.shrinks = shrinks_.load(std::memory_order_relaxed);
+        stats.current = size();
+        return stats;
+    }
+
+    /**
+     * Monotonic clock for the latency samples
+     */
+    static uint64_t nowNs() {
+        return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()).count());
+    }
+
+private:
+    // Single writer: plain load + store keeps the counters readable without RMWs
+    static void bump(std::atomic<size_t>& cell, size_t amount) {
+        cell.store(cell.load(std::memory_order_relaxed) + amount, std::memory_order_relaxed);
+    }
+
+    void note() {
+        bump(samples_, 1);
+        bump(sizeSum_, size());
+    }
+
+    void grow() {
+        size_t current = size();
+        if (current >= targets_.maxSize) return;
+        size_.store(std::min(current + std::max<size_t>(current / 4, 1), targets_.maxSize),
+                    std::memory_order_relaxed);
+        bump(grows_, 1);
+    }
+
+    void shrink() {
+        size_t current = size();
+        if (current <= targets_.minSize) return;
+        size_.store(std::max(current / 2, targets_.minSize), std::memory_order_relaxed);
+        bump(shrinks_, 1);
+    }
+
+    BatchTargets targets_;
+    std::atomic<size_t> size_{1};
+    std::atomic<size_t> samples_{0};
+    std::atomic<size_t> sizeSum_{0};
+    std::atomic<size_t> grows_{0};
+    std::atomic<size_t> shrinks_{0};
+};
+
+} // namespace para
+
+#endif // ADAPTIVE_BATCH_HPP
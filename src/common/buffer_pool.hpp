@@ -0,0 +1,199 @@
+#ifndef BUFFER_POOL_HPP
+#define BUFFER_POOL_HPP
+
+#include "data_structures.hpp"
+#include <atomic>
+#include <cstddef>
+#include <mutex>
+#include <utility>
+#include <vector>
+
+namespace para {
+
+/**
+ * Allocation statistics for pooled buffers
+ */
+struct BufferPoolStats {
+    size_t heapAllocations;  // Leases that had to allocate (or grow) storage
+    size_t recycled;         // Leases served by a recycled buffer
+};
+
+/**
+ * BufferPool - Recycles std::vector<T> buffers so steady-state batches never allocate
+ *
+ * acquire() leases a cleared buffer from the calling thread's free list;
+ * destroying (or release()-ing) the lease returns the buffer, capacity
+ * intact, to the free list of whichever thread does it. Per-thread lists
+ * take no locks; one that grows past LOCAL_CACHE_LIMIT spills half into a
+ * shared, locked list, and an empty one refills from it before allocating,
+ * so buffers released on a consumer thread find their way back to
+ * producers.
+ */
+template<typename T>
+class BufferPool {
+public:
+    static constexpr size_t LOCAL_CACHE_LIMIT = 64;
+    static constexpr size_t REFILL_BATCH = 16;
+
+    using Buffer = std::vector<T>;
+
+    /**
+     * Lease - Move-only owner of a pooled buffer
+     */
+    class Lease {
+    public:
+        Lease() = default;
+        explicit Lease(Buffer&& buffer) : buffer_(std::move(buffer)) {}
+
+        ~Lease() { release(); }
+
+        Lease(Lease&& other) noexcept : buffer_(std::move(other.buffer_)) {
+            other.buffer_ = Buffer();
+        }
+
+        Lease& operator=(Lease&& other) noexcept {
+            if (this != &other) {
+                release();
+                buffer_ = std::move(other.buffer_);
+                other.buffer_ = Buffer();
+            }
+            return *this;
+        }
+
+        Lease(const Lease&) = delete;
+        Lease& operator=(const Lease&) = delete;
+
+        /**
+         * Hand the buffer back to the pool now (the lease becomes empty)
+         */
+        void release() {
+            if (buffer_.capacity() > 0) {
+                BufferPool::recycle(std::move(buffer_));
+                buffer_ = Buffer();
+            }
+        }
+
+        template<typename... Args>
+        void emplace_back(Args&&... args) { buffer_.emplace_back(std::forward<Args>(args)...); }
+        void push_back(const T& item) { buffer_.push_back(item); }
+        void clear() { buffer_.clear(); }
+
+        T* data() { return buffer_.data(); }
+        const T* data() const { return buffer_.data(); }
+        size_t size() const { return buffer_.size(); }
+        size_t capacity() const { return buffer_.capacity(); }
+        bool empty() const { return buffer_.empty(); }
+
+        T& operator[](size_t i) { return buffer_[i]; }
+        const T& operator[](size_t i) const { return buffer_[i]; }
+
+        typename Buffer::iterator begin() { return buffer_.begin(); }
+        typename Buffer::iterator end() { return buffer_.end(); }
+        typename Buffer::const_iterator begin() const { return buffer_.begin(); }
+        typename Buffer::const_iterator end() const { return buffer_.end(); }
+
+    private:
+        Buffer buffer_;
+    };
+
+    /**
+     * Lease an empty buffer with room for at least capacity items
+     */
+    static Lease acquire(size_t capacity) {
+        LocalCache& cache = local();
+        if (cache.free.empty()) {
+            refill(cache);
+        }
+
+        Buffer buffer;
+        if (!cache.free.empty()) {
+            buffer = std::move(cache.free.back());
+            cache.free.pop_back();
+        }
+
+        if (buffer.capacity() >= capacity) {
+            recycledCount().fetch_add(1, std::memory_order_relaxed);
+        } else {
+            buffer.reserve(capacity);
+            heapCount().fetch_add(1, std::memory_order_relaxed);
+        }
+        return Lease(std::move(buffer));
+    }
+
+    static BufferPoolStats getStats() {
+        return {heapCount().load(std::memory_order_relaxed),
+                recycledCount().load(std::memory_order_relaxed)};
+    }
+
+private:
+    struct LocalCache {
+        LocalCache() {
+            // Sized up front so recycling never allocates
+            free.reserve(LOCAL_CACHE_LIMIT);
+        }
+
+        std::vector<Buffer> free;
+    };
+
+    struct Shared {
+        std::mutex mutex;
+        std::vector<Buffer> free;
+    };
+
+    static LocalCache& local() {
+        thread_local LocalCache cache;
+        return cache;
+    }
+
+    static Shared& shared() {
+        static Shared instance;
+        return instance;
+    }
+
+    static std::atomic<size_t>& heapCount() {
+        static std::atomic<size_t> count{0};
+        return count;
+    }
+
+    static std::atomic<size_t>& recycledCount() {
+        static std::atomic<size_t> count{0};
+        return count;
+    }
+
+    static void recycle(Buffer&& buffer) {
+        buffer.clear();
+
+        LocalCache& cache = local();
+        if (cache.free.size() >= LOCAL_CACHE_LIMIT) {
+            spill(cache);
+        }
+        cache.free.push_back(std::move(buffer));
+    }
+
+    static void spill(LocalCache& cache) {
+        Shared& pool = shared();
+        std::lock_guard<std::mutex> lock(pool.mutex);
+        size_t keep = cache.free.size() / 2;
+        for (size_t i = keep; i < cache.free.size(); ++i) {
+            pool.free.push_back(std::move(cache.free[i]));
+        }
+        cache.free.resize(keep);
+    }
+
+    static void refill(LocalCache& cache) {
+        Shared& pool = shared();
+        std::lock_guard<std::mutex> lock(pool.mutex);
+        for (size_t i = 0; i < REFILL_BATCH && !pool.free.empty(); ++i) {
+            cache.free.push_back(std::move(pool.free.back()));
+            pool.free.pop_back();
+        }
+    }
+};
+
+// Client -> server batch of wire inputs
+using InputBatchPool = BufferPool<PackedInput>;
+using InputBatch = InputBatchPool::Lease;
+
+} // namespace para
+
+#endif // BUFFER_POOL_HPP
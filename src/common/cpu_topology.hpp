@@ -0,0 +1,133 @@
+#ifndef CPU_TOPOLOGY_HPP
+#define CPU_TOPOLOGY_HPP
+
+#include <algorithm>
+#include <cstdlib>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#ifdef __linux__
+#include <sched.h>
+#endif
+
+namespace para {
+
+/**
+ * CPU affinity mask: the logical CPU numbers a thread may run on
+ */
+using CpuSet = std::vector<int>;
+
+/**
+ * One NUMA node and the CPUs (usable by this process) that belong to it
+ */
+struct NumaNode {
+    int id;
+    CpuSet cpus;
+};
+
+/**
+ * Parse a kernel CPU list ("0-3,8,10-11"); malformed entries are skipped
+ */
+inline CpuSet parseCpuList(const std::string& text) {
+    CpuSet cpus;
+    std::stringstream stream(text);
+    std::string range;
+    while (std::getline(stream, range, ',')) {
+        char* end = nullptr;
+        long first = std::strtol(range.c_str(), &end, 10);
+        if (end == range.c_str() || first < 0) continue;
+        long last = first;
+        if (*end == '-') {
+            const char* from = end + 1;
+            last = std::strtol(from, &end, 10);
+            if (end == from || last < first) continue;
+        }
+        for (long cpu = first; cpu <= last; ++cpu) {
+            cpus.push_back(static_cast<int>(cpu));
+        }
+    }
+    return cpus;
+}
+
+/**
+ * CPUs the calling process may run on
+ */
+inline CpuSet allowedCpus() {
+    CpuSet cpus;
+#ifdef __linux__
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    if (sched_getaffinity(0, sizeof(set), &set) == 0) {
+        for (int cpu = 0; cpu < CPU_SETSIZE; ++cpu) {
+            if (CPU_ISSET(cpu, &set)) cpus.push_back(cpu);
+        }
+    }
+#endif
+    if (cpus.empty()) {
+        unsigned count = std::max(std::thread::hardware_concurrency(), 1u);
+        for (unsigned cpu = 0; cpu < count; ++cpu) {
+            cpus.push_back(static_cast<int>(cpu));
+        }
+    }
+    return cpus;
+}
+
+/**
+ * NUMA nodes with at least one allowed CPU, from sysfs on Linux
+ * Elsewhere (or without sysfs) the machine is one node holding every
+ * allowed CPU
+ */
+inline std::vector<NumaNode> detectNumaNodes() {
+    CpuSet allowed = allowedCpus();
+    std::vector<NumaNode> nodes;
+
+#ifdef __linux__
+    std::ifstream online("/sys/devices/system/node/online");
+    std::string list;
+    if (online && std::getline(online, list)) {
+        for (int id : parseCpuList(list)) {
+            std::ifstream cpulist("/sys/devices/system/node/node" + std::to_string(id) + "/cpulist");
+            std::string cpus;
+            if (!cpulist || !std::getline(cpulist, cpus)) continue;
+
+            NumaNode node{id, {}};
+            for (int cpu : parseCpuList(cpus)) {
+                if (std::find(allowed.begin(), allowed.end(), cpu) != allowed.end()) {
+                    node.cpus.push_back(cpu);
+                }
+            }
+            if (!node.cpus.empty()) nodes.push_back(std::move(node));
+        }
+    }
+#endif
+
+    if (nodes.empty()) {
+        nodes.push_back(NumaNode{0, allowed});
+    }
+    return nodes;
+}
+
+/**
+ * Restrict the calling thread to cpus
+ * Returns false if cpus is empty, pinning is unsupported or it failed
+ */
+inline bool pinCurrentThread(const CpuSet& cpus) {
+    if (cpus.empty()) return false;
+#ifdef __linux__
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    for (int cpu : cpus) {
+        if (cpu >= 0 && cpu < CPU_SETSIZE) CPU_SET(cpu, &set);
+    }
+    return sched_setaffinity(0, sizeof(set), &set) == 0;
+#else
+    return false;
+#endif
+}
+
+} // namespace para
+
+#endif // CPU_TOPOLOGY_HPP
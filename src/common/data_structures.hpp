@@ -2,6 +2,7 @@
 #define DATA_STRUCTURES_HPP
 
 #include "types.hpp"
+#include "state_hash.hpp"
 #include <array>
 #include <vector>
 #include <algorithm>
@@ -22,6 +23,73 @@ struct Input {
         : matchId(match), playerId(player), tickId(tick), type(action) {}
 };
 
+// ============================================
+// PackedInput - 4-byte encoding of an Input
+// ============================================
+// Layout (LSB first): 2-bit action | 2-bit player | 12-bit match index
+// relative to the shard's first match | 16-bit wrapping tick.
+// The full tick is recovered against a reference tick (the newest tick the
+// receiver has seen), so it must be within +/-32767 ticks of it.
+struct PackedInput {
+    static constexpr int ACTION_BITS = 2;
+    static constexpr int PLAYER_BITS = 2;
+    static constexpr int MATCH_BITS = 12;
+    static constexpr int TICK_BITS = 16;
+    static constexpr int MAX_MATCHES = 1 << MATCH_BITS;  // Per shard
+    
+    uint32_t bits;
+    
+    PackedInput() = default;
+    explicit PackedInput(uint32_t raw) : bits(raw) {}
+    PackedInput(int localMatch, int player, int tick, ActionType action)
+        : bits(static_cast<uint32_t>(action) & ((1u << ACTION_BITS) - 1))
+    {
+        bits |= (static_cast<uint32_t>(player) & ((1u << PLAYER_BITS) - 1)) << ACTION_BITS;
+        bits |= (static_cast<uint32_t>(localMatch) & (MAX_MATCHES - 1u)) << (ACTION_BITS + PLAYER_BITS);
+        bits |= static_cast<uint32_t>(static_cast<uint16_t>(tick)) << (32 - TICK_BITS);
+    }
+    
+    static PackedInput pack(const Input& input, int matchBase = 0) {
+        return PackedInput(input.matchId - matchBase, input.playerId, input.tickId, input.type);
+    }
+    
+    ActionType type() const {
+        return static_cast<ActionType>(bits & ((1u << ACTION_BITS) - 1));
+    }
+    
+    int playerId() const {
+        return static_cast<int>((bits >> ACTION_BITS) & ((1u << PLAYER_BITS) - 1));
+    }
+    
+    int localMatch() const {
+        return static_cast<int>((bits >> (ACTION_BITS + PLAYER_BITS)) & (MAX_MATCHES - 1u));
+    }
+    
+    // Same input, addressed to another match index (e.g. the one in its shard)
+    PackedInput withLocalMatch(int localMatch) const {
+        constexpr uint32_t shift = ACTION_BITS + PLAYER_BITS;
+        constexpr uint32_t mask = (MAX_MATCHES - 1u) << shift;
+        return PackedInput((bits & ~mask) | ((static_cast<uint32_t>(localMatch) << shift) & mask));
+    }
+    
+    uint16_t wrappedTick() const {
+        return static_cast<uint16_t>(bits >> (32 - TICK_BITS));
+    }
+    
+    // Full tick closest to referenceTick with the same low 16 bits
+    static int unwrapTick(uint16_t wrapped, int referenceTick) {
+        int16_t delta = static_cast<int16_t>(static_cast<uint16_t>(wrapped - static_cast<uint16_t>(referenceTick)));
+        return referenceTick + delta;
+    }
+    
+    Input unpack(int referenceTick, int matchBase = 0) const {
+        return Input(localMatch() + matchBase, playerId(), unwrapTick(wrappedTick(), referenceTick), type());
+    }
+};
+
+static_assert(sizeof(PackedInput) == 4, "PackedInput must stay 4 bytes");
+static_assert(MAX_PLAYERS_PER_MATCH <= 1 << PackedInput::PLAYER_BITS, "PackedInput player id too narrow");
+
 // ============================================
 // PlayerState - State of a single player
 // ============================================
@@ -33,24 +101,30 @@ struct PlayerState {
     PlayerState() : id(0), x(ARENA_WIDTH / 2), y(ARENA_HEIGHT / 2) {}
     PlayerState(int playerId) : id(playerId), x(ARENA_WIDTH / 2), y(ARENA_HEIGHT / 2) {}
     
-    // Apply movement with boundary clamping
+    // Apply movement with boundary clamping to Config's arena
+    template<typename Config>
     void move(ActionType action) {
         switch (action) {
             case ActionType::MOVE_LEFT:
                 x = std::max(0, x - 1);
                 break;
             case ActionType::MOVE_RIGHT:
-                x = std::min(ARENA_WIDTH - 1, x + 1);
+                x = std::min(Config::ARENA_WIDTH - 1, x + 1);
                 break;
             case ActionType::MOVE_UP:
                 y = std::max(0, y - 1);
                 break;
             case ActionType::MOVE_DOWN:
-                y = std::min(ARENA_HEIGHT - 1, y + 1);
+                y = std::min(Config::ARENA_HEIGHT - 1, y + 1);
                 break;
         }
     }
     
+    // Same, in the default (DUEL) arena
+    void move(ActionType action) {
+        move<DuelConfig>(action);
+    }
+    
     // Clone for snapshot
     PlayerState clone() const {
         PlayerState copy;
@@ -62,37 +136,69 @@ struct PlayerState {
 };
 
 // ============================================
-// MatchState - State of a single match
+// BasicMatchState - State of a single match of one game mode
 // ============================================
-struct MatchState {
+template<typename Config>
+struct BasicMatchState {
+    using GameConfig = Config;
+    static constexpr int PLAYERS = Config::PLAYERS;
+    
     int matchId;
     int currentTick;
-    std::array<PlayerState, 2> players;  // 2 players per match
+    std::array<PlayerState, PLAYERS> players;
     bool isRunning;
+    uint64_t playerSum;   // Sum of statehash::playerTerm over players, kept up to date by moves
+    uint64_t syncHash;    // Chained hash of every completed tick (see state_hash.hpp)
     
-    MatchState() : matchId(0), currentTick(0), isRunning(false) {}
-    MatchState(int id) : matchId(id), currentTick(0), isRunning(false) {
-        players[0] = PlayerState(0);
-        players[1] = PlayerState(1);
-        // Start players at different positions
-        players[0].x = 5;
-        players[0].y = 10;
-        players[1].x = 15;
-        players[1].y = 10;
+    BasicMatchState() : matchId(0), currentTick(0), isRunning(false) {
+        refreshPlayerSum();
+    }
+    BasicMatchState(int id) : matchId(id), currentTick(0), isRunning(false) {
+        // Start players spread evenly across the middle row (5 and 15 in a duel)
+        for (int p = 0; p < PLAYERS; ++p) {
+            players[p] = PlayerState(p);
+            players[p].x = Config::ARENA_WIDTH * (2 * p + 1) / (2 * PLAYERS);
+            players[p].y = Config::ARENA_HEIGHT / 2;
+        }
+        refreshPlayerSum();
+    }
+    
+    // Move player p, keeping playerSum current
+    void movePlayer(int p, ActionType action) {
+        PlayerState& player = players[p];
+        playerSum -= statehash::PLAYER_TERMS<Config>.at(p, player.x, player.y);
+        player.move<Config>(action);
+        playerSum += statehash::PLAYER_TERMS<Config>.at(p, player.x, player.y);
+    }
+    
+    // Recompute playerSum from scratch and restart the tick chain, for a
+    // state whose players were set directly
+    void refreshPlayerSum() {
+        playerSum = 0;
+        for (int p = 0; p < PLAYERS; ++p) {
+            playerSum += statehash::playerTerm(p, players[p].x, players[p].y);
+        }
+        syncHash = statehash::INITIAL_SYNC_HASH;
     }
     
     // Clone for snapshot
-    MatchState clone() const {
-        MatchState copy;
+    BasicMatchState clone() const {
+        BasicMatchState copy;
         copy.matchId = matchId;
         copy.currentTick = currentTick;
-        copy.players[0] = players[0].clone();
-        copy.players[1] = players[1].clone();
+        for (int p = 0; p < PLAYERS; ++p) {
+            copy.players[p] = players[p].clone();
+        }
         copy.isRunning = isRunning;
+        copy.playerSum = playerSum;
+        copy.syncHash = syncHash;
         return copy;
     }
 };
 
+// The default (DUEL) mode's state
+using MatchState = BasicMatchState<DuelConfig>;
+
 // ============================================
 // Snapshot - State snapshot for rollback
 // ============================================
@@ -0,0 +1,200 @@
+#ifndef MAPPED_FILE_HPP
+#define MAPPED_FILE_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <stdexcept>
+#include <string>
+#include <utility>
+
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace para {
+
+/**
+ * MappedFile - A whole file mapped into memory (POSIX mmap / Win32 file mapping)
+ *
+ * create() sizes a new file and maps it read-write, so writers fill it in
+ * place and the OS pages it out as needed; open() maps an existing file
+ * read-only. Failures throw std::runtime_error. Move-only; unmaps on
+ * destruction.
+ */
+class MappedFile {
+public:
+    MappedFile() = default;
+
+    ~MappedFile() { close(); }
+
+    MappedFile(MappedFile&& other) noexcept { swap(other); }
+
+    MappedFile& operator=(MappedFile&& other) noexcept {
+        if (this != &other) {
+            close();
+            swap(other);
+        }
+        return *this;
+    }
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    /**
+     * Create (or truncate) path with size bytes and map it read-write
+     */
+    static MappedFile create(const std::string& path, size_t size) {
+        if (size == 0) {
+            throw std::runtime_error("MappedFile: cannot map an empty file: " + path);
+        }
+
+        MappedFile file;
+        file.size_ = size;
+        file.writable_ = true;
+#ifdef _WIN32
+        file.handle_ = CreateFileA(path.c_str(), GENERIC_READ | GENERIC_WRITE, FILE_SHARE_READ, nullptr,
+                                   CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL, nullptr);
+        if (file.handle_ == INVALID_HANDLE_VALUE) {
+            throw std::runtime_error("MappedFile: cannot create " + path);
+        }
+        LARGE_INTEGER length;
+        length.QuadPart = static_cast<LONGLONG>(size);
+        if (!SetFilePointerEx(file.handle_, length, nullptr, FILE_BEGIN) || !SetEndOfFile(file.handle_)) {
+            throw std::runtime_error("MappedFile: cannot size " + path);
+        }
+        file.mapView(path);
+#else
+        file.fd_ = ::open(path.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644);
+        if (file.fd_ < 0) {
+            throw std::runtime_error("MappedFile: cannot create " + path);
+        }
+        if (::ftruncate(file.fd_, static_cast<off_t>(size)) != 0) {
+            throw std::runtime_error("MappedFile: cannot size " + path);
+        }
+        file.mapView(path);
+#endif
+        return file;
+    }
+
+    /**
+     * Map an existing file read-only
+     */
+    static MappedFile open(const std::string& path) {
+        MappedFile file;
+#ifdef _WIN32
+        file.handle_ = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr,
+                                   OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+        if (file.handle_ == INVALID_HANDLE_VALUE) {
+            throw std::runtime_error("MappedFile: cannot open " + path);
+        }
+        LARGE_INTEGER length;
+        if (!GetFileSizeEx(file.handle_, &length) || length.QuadPart == 0) {
+            throw std::runtime_error("MappedFile: empty or unreadable file " + path);
+        }
+        file.size_ = static_cast<size_t>(length.QuadPart);
+        file.mapView(path);
+#else
+        file.fd_ = ::open(path.c_str(), O_RDONLY);
+        if (file.fd_ < 0) {
+            throw std::runtime_error("MappedFile: cannot open " + path);
+        }
+        struct stat info;
+        if (::fstat(file.fd_, &info) != 0 || info.st_size == 0) {
+            throw std::runtime_error("MappedFile: empty or unreadable file " + path);
+        }
+        file.size_ = static_cast<size_t>(info.st_size);
+        file.mapView(path);
+        ::madvise(file.data_, file.size_, MADV_SEQUENTIAL);
+#endif
+        return file;
+    }
+
+    // Writable only for files from create()
+    uint8_t* data() { return data_; }
+    const uint8_t* data() const { return data_; }
+    size_t size() const { return size_; }
+    bool isOpen() const { return data_ != nullptr; }
+
+    /**
+     * Write dirty pages back to the file (blocks until done)
+     */
+    void flush() {
+        if (!data_ || !writable_) return;
+#ifdef _WIN32
+        FlushViewOfFile(data_, 0);
+        FlushFileBuffers(handle_);
+#else
+        ::msync(data_, size_, MS_SYNC);
+#endif
+    }
+
+    void close() {
+#ifdef _WIN32
+        if (data_) UnmapViewOfFile(data_);
+        if (mapping_) CloseHandle(mapping_);
+        if (handle_ != INVALID_HANDLE_VALUE) CloseHandle(handle_);
+        mapping_ = nullptr;
+        handle_ = INVALID_HANDLE_VALUE;
+#else
+        if (data_) ::munmap(data_, size_);
+        if (fd_ >= 0) ::close(fd_);
+        fd_ = -1;
+#endif
+        data_ = nullptr;
+        size_ = 0;
+        writable_ = false;
+    }
+
+private:
+    void mapView(const std::string& path) {
+#ifdef _WIN32
+        mapping_ = CreateFileMappingA(handle_, nullptr, writable_ ? PAGE_READWRITE : PAGE_READONLY, 0, 0, nullptr);
+        if (!mapping_) {
+            throw std::runtime_error("MappedFile: cannot map " + path);
+        }
+        data_ = static_cast<uint8_t*>(MapViewOfFile(mapping_, writable_ ? FILE_MAP_WRITE : FILE_MAP_READ, 0, 0, size_));
+#else
+        void* address = ::mmap(nullptr, size_, writable_ ? (PROT_READ | PROT_WRITE) : PROT_READ,
+                               MAP_SHARED, fd_, 0);
+        data_ = address == MAP_FAILED ? nullptr : static_cast<uint8_t*>(address);
+#endif
+        if (!data_) {
+            throw std::runtime_error("MappedFile: cannot map " + path);
+        }
+    }
+
+    void swap(MappedFile& other) noexcept {
+        std::swap(data_, other.data_);
+        std::swap(size_, other.size_);
+        std::swap(writable_, other.writable_);
+#ifdef _WIN32
+        std::swap(handle_, other.handle_);
+        std::swap(mapping_, other.mapping_);
+#else
+        std::swap(fd_, other.fd_);
+#endif
+    }
+
+private:
+    uint8_t* data_ = nullptr;
+    size_t size_ = 0;
+    bool writable_ = false;
+#ifdef _WIN32
+    HANDLE handle_ = INVALID_HANDLE_VALUE;
+    HANDLE mapping_ = nullptr;
+#else
+    int fd_ = -1;
+#endif
+};
+
+} // namespace para
+
+#endif // MAPPED_FILE_HPP
@@ -0,0 +1,407 @@
+#ifndef METRICS_HPP
+#define METRICS_HPP
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <vector>
+
+namespace para {
+namespace metrics {
+
+/**
+ * Pipeline instrumentation (Client -> Server -> Match)
+ *
+ * Built only with PARA_ENABLE_METRICS (CMake option of the same name).
+ * Without it every hook below is an empty inline function, now() returns
+ * 0 without reading the clock, and nothing is registered or allocated.
+ *
+ * Each thread records into its own ThreadMetrics slot (cache-line
+ * aligned, single writer, relaxed atomics), so recording never takes a
+ * lock or contends with another thread. snapshot() merges the slots of
+ * every thread that ever recorded; slots of exited threads are kept and
+ * reused by new threads.
+ */
+#ifdef PARA_ENABLE_METRICS
+constexpr bool ENABLED = true;
+#else
+constexpr bool ENABLED = false;
+#endif
+
+// Timed hooks read the clock on one call in TIMING_SAMPLE_INTERVAL per thread
+constexpr uint32_t TIMING_SAMPLE_INTERVAL = 8;
+
+enum class Histogram : uint8_t {
+    ENQUEUE_TO_PROCESS_NS,   // Oldest queued input of a drain, enqueue -> processPending
+    ROLLBACK_REPLAY_TICKS,   // Ticks re-simulated by one rollback
+    ROLLBACK_REPLAY_NS,      // Cost of one rollback (restore + replay), sampled
+    DRAIN_BATCH_SIZE,        // Inputs taken by one processPending call
+    TASK_QUEUE_WAIT_NS,      // Task submit -> start of execution, sampled
+    DRAIN_QUANTUM,           // Adaptive drain cap in effect at a processPending call
+    PRODUCER_BATCH_SIZE,     // Inputs a client sent in one go
+    COUNT
+};
+
+enum class Counter : uint8_t {
+    INPUTS_PROCESSED,
+    DRAINS,
+    ROLLBACKS,
+    TASKS_RUN,
+    COUNT
+};
+
+constexpr size_t HISTOGRAM_COUNT = static_cast<size_t>(Histogram::COUNT);
+constexpr size_t COUNTER_COUNT = static_cast<size_t>(Counter::COUNT);
+
+inline const char* name(Histogram histogram) {
+    static const char* const names[HISTOGRAM_COUNT] = {
+        "enqueue_to_process_ns", "rollback_replay_ticks", "rollback_replay_ns",
+        "drain_batch_size", "task_queue_wait_ns", "drain_quantum", "producer_batch_size"
+    };
+    return names[static_cast<size_t>(histogram)];
+}
+
+inline const char* name(Counter counter) {
+    static const char* const names[COUNTER_COUNT] = {
+        "inputs_processed", "drains", "rollbacks", "tasks_run"
+    };
+    return names[static_cast<size_t>(counter)];
+}
+
+/**
+ * HDR-style log-linear bucketing
+ * Values below 2^SUB_BUCKET_BITS get exact buckets; above that each power
+ * of two is split into 2^SUB_BUCKET_BITS buckets, so a bucket's width is
+ * at most 1/16 of its value (~6% worst-case error) over the full uint64 range.
+ */
+struct HistogramLayout {
+    static constexpr int SUB_BUCKET_BITS = 4;
+    static constexpr size_t SUB_BUCKETS = size_t(1) << SUB_BUCKET_BITS;
+    static constexpr size_t NUM_BUCKETS = (64 - SUB_BUCKET_BITS + 1) * SUB_BUCKETS;
+
+    static int highestBit(uint64_t value) {
+#if defined(_MSC_VER) && !defined(__clang__)
+        int bit = 63;
+        while (!(value >> bit)) --bit;
+        return bit;
+#else
+        return 63 - __builtin_clzll(value);
+#endif
+    }
+
+    static size_t bucketFor(uint64_t value) {
+        if (value < SUB_BUCKETS) return static_cast<size_t>(value);
+        int shift = highestBit(value) - SUB_BUCKET_BITS;
+        return (shift + 1) * SUB_BUCKETS + static_cast<size_t>((value >> shift) - SUB_BUCKETS);
+    }
+
+    static uint64_t lowerBound(size_t bucket) {
+        if (bucket < SUB_BUCKETS) return bucket;
+        int shift = static_cast<int>(bucket / SUB_BUCKETS) - 1;
+        return static_cast<uint64_t>(SUB_BUCKETS + bucket % SUB_BUCKETS) << shift;
+    }
+
+    // Value reported for samples in a bucket (its midpoint)
+    static uint64_t representative(size_t bucket) {
+        if (bucket < SUB_BUCKETS) return bucket;
+        int shift = static_cast<int>(bucket / SUB_BUCKETS) - 1;
+        return lowerBound(bucket) + ((uint64_t(1) << shift) >> 1);
+    }
+};
+
+/**
+ * One thread's histogram (single writer; any thread may read)
+ */
+class LatencyHistogram {
+public:
+    void record(uint64_t value) {
+        bump(buckets_[HistogramLayout::bucketFor(value)], 1);
+        bump(sum_, value);
+        if (value > max_.load(std::memory_order_relaxed)) {
+            max_.store(value, std::memory_order_relaxed);
+        }
+    }
+
+    void reset() {
+        for (auto& bucket : buckets_) bucket.store(0, std::memory_order_relaxed);
+        sum_.store(0, std::memory_order_relaxed);
+        max_.store(0, std::memory_order_relaxed);
+    }
+
+private:
+    friend class HistogramSnapshot;
+
+    static void bump(std::atomic<uint64_t>& cell, uint64_t amount) {
+        cell.store(cell.load(std::memory_order_relaxed) + amount, std::memory_order_relaxed);
+    }
+
+    std::array<std::atomic<uint64_t>, HistogramLayout::NUM_BUCKETS> buckets_{};
+    std::atomic<uint64_t> sum_{0};
+    std::atomic<uint64_t> max_{0};
+};
+
+/**
+ * Merged, plain copy of one histogram across threads
+ */
+class HistogramSnapshot {
+public:
+    HistogramSnapshot() : buckets_(HistogramLayout::NUM_BUCKETS, 0) {}
+
+    void merge(const LatencyHistogram& histogram) {
+        for (size_t i = 0; i < HistogramLayout::NUM_BUCKETS; ++i) {
+            uint64_t n = histogram.buckets_[i].load(std::memory_order_relaxed);
+            buckets_[i] += n;
+            count_ += n;
+        }
+        sum_ += histogram.sum_.load(std::memory_order_relaxed);
+        uint64_t max = histogram.max_.load(std::memory_order_relaxed);
+        if (max > max_) max_ = max;
+    }
+
+    uint64_t count() const { return count_; }
+    uint64_t max() const { return max_; }
+    double mean() const { return count_ ? static_cast<double>(sum_) / count_ : 0.0; }
+
+    /**
+     * Value at quantile q in [0, 1] (bucket midpoint, never above max())
+     */
+    uint64_t percentile(double q) const {
+        if (count_ == 0) return 0;
+        uint64_t rank = static_cast<uint64_t>(q * (count_ - 1)) + 1;
+        uint64_t seen = 0;
+        for (size_t i = 0; i < buckets_.size(); ++i) {
+            seen += buckets_[i];
+            if (seen >= rank) {
+                uint64_t value = HistogramLayout::representative(i);
+                return value < max_ ? value : max_;
+            }
+        }
+        return max_;
+    }
+
+private:
+    std::vector<uint64_t> buckets_;
+    uint64_t count_ = 0;
+    uint64_t sum_ = 0;
+    uint64_t max_ = 0;
+};
+
+/**
+ * Everything one thread records
+ */
+struct alignas(64) ThreadMetrics {
+    std::array<LatencyHistogram, HISTOGRAM_COUNT> histograms;
+    alignas(64) std::array<std::atomic<uint64_t>, COUNTER_COUNT> counters{};
+    uint32_t sampleTick = 0;
+    bool inUse = false;  // Guarded by the registry mutex
+};
+
+/**
+ * Point-in-time copy of all metrics
+ */
+struct MetricsSnapshot {
+    std::array<HistogramSnapshot, HISTOGRAM_COUNT> histograms;
+    std::array<uint64_t, COUNTER_COUNT> totals{};
+    std::vector<std::array<uint64_t, COUNTER_COUNT>> perThread;  // One row per slot
+
+    const HistogramSnapshot& operator[](Histogram h) const { return histograms[static_cast<size_t>(h)]; }
+    uint64_t operator[](Counter c) const { return totals[static_cast<size_t>(c)]; }
+
+    /**
+     * Export as one JSON object
+     */
+    void writeJson(std::ostream& out) const {
+        out << "{\"histograms\":{";
+        for (size_t h = 0; h < HISTOGRAM_COUNT; ++h) {
+            const HistogramSnapshot& hist = histograms[h];
+            out << (h ? "," : "") << "\"" << name(static_cast<Histogram>(h)) << "\":{"
+                << "\"count\":" << hist.count() << ",\"mean\":" << hist.mean()
+                << ",\"p50\":" << hist.percentile(0.50) << ",\"p99\":" << hist.percentile(0.99)
+                << ",\"p999\":" << hist.percentile(0.999) << ",\"max\":" << hist.max() << "}";
+        }
+        out << "},\"counters\":{";
+        for (size_t c = 0; c < COUNTER_COUNT; ++c) {
+            out << (c ? "," : "") << "\"" << name(static_cast<Counter>(c)) << "\":" << totals[c];
+        }
+        out << "},\"per_thread\":[";
+        for (size_t t = 0; t < perThread.size(); ++t) {
+            out << (t ? "," : "") << "[";
+            for (size_t c = 0; c < COUNTER_COUNT; ++c) {
+                out << (c ? "," : "") << perThread[t][c];
+            }
+            out << "]";
+        }
+        out << "]}";
+    }
+};
+
+/**
+ * Registry of per-thread slots
+ */
+class Registry {
+public:
+    static Registry& instance() {
+        static Registry registry;
+        return registry;
+    }
+
+    /**
+     * The calling thread's slot (registered on first use)
+     */
+    static ThreadMetrics& local() {
+        // Trivial thread_local first: no init guard on the hot path
+        thread_local ThreadMetrics* slot = nullptr;
+        if (!slot) {
+            thread_local Handle handle;
+            slot = handle.slot;
+        }
+        return *slot;
+    }
+
+    MetricsSnapshot snapshot() {
+        MetricsSnapshot result;
+        std::lock_guard<std::mutex> lock(mutex_);
+        for (const auto& slot : slots_) {
+            for (size_t h = 0; h < HISTOGRAM_COUNT; ++h) {
+                result.histograms[h].merge(slot->histograms[h]);
+            }
+            std::array<uint64_t, COUNTER_COUNT> row{};
+            for (size_t c = 0; c < COUNTER_COUNT; ++c) {
+                row[c] = slot->counters[c].load(std::memory_order_relaxed);
+                result.totals[c] += row[c];
+            }
+            result.perThread.push_back(row);
+        }
+        return result;
+    }
+
+    /**
+     * Zero every slot. Only while no thread is recording (e.g. between runs)
+     */
+    void reset() {
+        std::lock_guard<std::mutex> lock(mutex_);
+        for (auto& slot : slots_) {
+            for (auto& histogram : slot->histograms) histogram.reset();
+            for (auto& counter : slot->counters) counter.store(0, std::memory_order_relaxed);
+        }
+    }
+
+private:
+    // Claims a slot for its thread, hands it back at thread exit
+    struct Handle {
+        Handle() : slot(instance().acquire()) {}
+        ~Handle() { instance().release(slot); }
+        ThreadMetrics* slot;
+    };
+
+    ThreadMetrics* acquire() {
+        std::lock_guard<std::mutex> lock(mutex_);
+        for (auto& slot : slots_) {
+            if (!slot->inUse) {
+                slot->inUse = true;
+                return slot.get();
+            }
+        }
+        slots_.push_back(std::make_unique<ThreadMetrics>());
+        slots_.back()->inUse = true;
+        return slots_.back().get();
+    }
+
+    void release(ThreadMetrics* slot) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        slot->inUse = false;
+    }
+
+    std::mutex mutex_;
+    std::vector<std::unique_ptr<ThreadMetrics>> slots_;
+};
+
+// ============================================================================
+// Hooks (no-ops without PARA_ENABLE_METRICS)
+// ============================================================================
+
+/**
+ * Monotonic nanoseconds, or 0 when metrics are compiled out
+ */
+inline uint64_t now() {
+#ifdef PARA_ENABLE_METRICS
+    return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count());
+#else
+    return 0;
+#endif
+}
+
+/**
+ * now() on one call in TIMING_SAMPLE_INTERVAL on this thread, 0 otherwise
+ * Lets hot paths time a fraction of events without a clock read each time
+ */
+inline uint64_t sampledNow() {
+#ifdef PARA_ENABLE_METRICS
+    ThreadMetrics& self = Registry::local();
+    if (++self.sampleTick % TIMING_SAMPLE_INTERVAL != 0) return 0;
+    return now();
+#else
+    return 0;
+#endif
+}
+
+inline void record(Histogram histogram, uint64_t value) {
+#ifdef PARA_ENABLE_METRICS
+    Registry::local().histograms[static_cast<size_t>(histogram)].record(value);
+#else
+    (void)histogram;
+    (void)value;
+#endif
+}
+
+/**
+ * Record now() - startNs, unless startNs is 0 (not sampled)
+ */
+inline void recordSince(Histogram histogram, uint64_t startNs) {
+#ifdef PARA_ENABLE_METRICS
+    if (startNs == 0) return;
+    uint64_t end = now();
+    record(histogram, end > startNs ? end - startNs : 0);
+#else
+    (void)histogram;
+    (void)startNs;
+#endif
+}
+
+inline void add(Counter counter, uint64_t amount = 1) {
+#ifdef PARA_ENABLE_METRICS
+    std::atomic<uint64_t>& cell = Registry::local().counters[static_cast<size_t>(counter)];
+    cell.store(cell.load(std::memory_order_relaxed) + amount, std::memory_order_relaxed);
+#else
+    (void)counter;
+    (void)amount;
+#endif
+}
+
+/**
+ * Merged copy of every thread's metrics (empty when compiled out)
+ */
+inline MetricsSnapshot snapshot() {
+#ifdef PARA_ENABLE_METRICS
+    return Registry::instance().snapshot();
+#else
+    return MetricsSnapshot();
+#endif
+}
+
+inline void reset() {
+#ifdef PARA_ENABLE_METRICS
+    Registry::instance().reset();
+#endif
+}
+
+} // namespace metrics
+} // namespace para
+
+#endif // METRICS_HPP
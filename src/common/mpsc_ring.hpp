@@ -0,0 +1,161 @@
+#ifndef MPSC_RING_HPP
+#define MPSC_RING_HPP
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <type_traits>
+#include <utility>
+
+namespace para {
+
+/**
+ * MpscRing - Bounded lock-free multi-producer / single-consumer ring
+ *
+ * Producers reserve a contiguous run of slots with one CAS on tail_, copy
+ * their items in, then mark each slot ready through its sequence number.
+ * The single consumer takes every ready item in one drain() and publishes
+ * its new head once, which is what producers check for free space.
+ *
+ * head_ and tail_ live on separate cache lines so producers and the
+ * consumer do not false-share.
+ */
+template<typename T>
+class MpscRing {
+    static_assert(std::is_trivially_copyable<T>::value, "MpscRing copies items by value");
+
+public:
+    explicit MpscRing(size_t capacity)
+        : capacity_(roundUpToPowerOfTwo(capacity))
+        , mask_(capacity_ - 1)
+        , slots_(new Slot[capacity_])
+    {
+        for (size_t i = 0; i < capacity_; ++i) {
+            // Ready marker for position p is p + 1, so 0 means "never written"
+            slots_[i].sequence.store(0, std::memory_order_relaxed);
+        }
+    }
+
+    MpscRing(const MpscRing&) = delete;
+    MpscRing& operator=(const MpscRing&) = delete;
+
+    /**
+     * Enqueue one item (any thread). Returns false if the ring is full
+     */
+    bool tryPush(const T& item) {
+        return tryPushBatch(&item, 1) == 1;
+    }
+
+    /**
+     * Enqueue up to count items with a single reservation (any thread)
+     * Returns how many were accepted; the rest did not fit
+     */
+    size_t tryPushBatch(const T* items, size_t count) {
+        if (count == 0) return 0;
+
+        size_t pos = tail_.load(std::memory_order_relaxed);
+        size_t accepted;
+        for (;;) {
+            size_t head = head_.load(std::memory_order_acquire);
+            size_t used = pos - head;
+            if (used > capacity_) {
+                // pos is stale (consumer already passed it): reload
+                pos = tail_.load(std::memory_order_relaxed);
+                continue;
+            }
+            accepted = count < capacity_ - used ? count : capacity_ - used;
+            if (accepted == 0) return 0;
+            if (tail_.compare_exchange_weak(pos, pos + accepted,
+                                            std::memory_order_relaxed,
+                                            std::memory_order_relaxed)) {
+                break;
+            }
+        }
+
+        for (size_t i = 0; i < accepted; ++i) {
+            Slot& slot = slots_[(pos + i) & mask_];
+            slot.value = items[i];
+            slot.sequence.store(static_cast<uint32_t>(pos + i + 1), std::memory_order_release);
+        }
+        return accepted;
+    }
+
+    /**
+     * Consume every ready item in FIFO order (consumer only)
+     * Stops early at a slot a producer reserved but has not finished writing
+     * Returns the number of items passed to fn
+     */
+    template<typename Fn>
+    size_t drain(Fn&& fn) {
+        return drain(static_cast<size_t>(-1), std::forward<Fn>(fn));
+    }
+
+    /**
+     * Consume at most maxItems ready items (consumer only)
+     */
+    template<typename Fn>
+    size_t drain(size_t maxItems, Fn&& fn) {
+        size_t head = head_.load(std::memory_order_relaxed);
+        size_t taken = 0;
+
+        while (taken < maxItems) {
+            Slot& slot = slots_[head & mask_];
+            if (slot.sequence.load(std::memory_order_acquire) != static_cast<uint32_t>(head + 1)) {
+                break;
+            }
+            fn(slot.value);
+            ++head;
+            ++taken;
+        }
+
+        if (taken > 0) {
+            head_.store(head, std::memory_order_release);
+        }
+        return taken;
+    }
+
+    /**
+     * Approximate number of queued items (reserved slots included)
+     */
+    size_t size() const {
+        // head first: tail can only have grown since, so this never underflows
+        size_t head = head_.load(std::memory_order_acquire);
+        size_t tail = tail_.load(std::memory_order_acquire);
+        return tail - head;
+    }
+
+    bool empty() const {
+        return size() == 0;
+    }
+
+    size_t capacity() const {
+        return capacity_;
+    }
+
+private:
+    struct Slot {
+        std::atomic<uint32_t> sequence;  // Compared modulo 2^32
+        T value;
+    };
+
+    static size_t roundUpToPowerOfTwo(size_t n) {
+        size_t cap = 2;
+        while (cap < n) {
+            cap <<= 1;
+        }
+        return cap;
+    }
+
+private:
+    const size_t capacity_;
+    const size_t mask_;
+    std::unique_ptr<Slot[]> slots_;
+
+    alignas(64) std::atomic<size_t> tail_{0};  // Producers
+    alignas(64) std::atomic<size_t> head_{0};  // Consumer
+};
+
+} // namespace para
+
+#endif // MPSC_RING_HPP
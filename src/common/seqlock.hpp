@@ -0,0 +1,97 @@
+#ifndef SEQLOCK_HPP
+#define SEQLOCK_HPP
+
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
+
+namespace para {
+
+/**
+ * SeqLock - Single-writer published value that readers never block
+ *
+ * The writer bumps the sequence to odd, stores the value, then bumps it to
+ * even. Readers copy the value and retry if the sequence was odd or changed
+ * meanwhile. The payload is stored as relaxed atomic words, so a torn read
+ * is discarded rather than being a data race.
+ *
+ * Only one thread may call store() at a time.
+ */
+template<typename T>
+class SeqLock {
+    static_assert(std::is_trivially_copyable<T>::value, "SeqLock copies the value bytewise");
+
+public:
+    SeqLock() {
+        store(T());
+    }
+
+    explicit SeqLock(const T& value) {
+        store(value);
+    }
+
+    SeqLock(const SeqLock&) = delete;
+    SeqLock& operator=(const SeqLock&) = delete;
+
+    /**
+     * Publish a new value (single writer)
+     */
+    void store(const T& value) {
+        uint32_t buffer[WORDS] = {};
+        std::memcpy(buffer, &value, sizeof(T));
+
+        uint32_t seq = sequence_.load(std::memory_order_relaxed);
+        sequence_.store(seq + 1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+
+        for (size_t i = 0; i < WORDS; ++i) {
+            words_[i].store(buffer[i], std::memory_order_relaxed);
+        }
+
+        sequence_.store(seq + 2, std::memory_order_release);
+    }
+
+    /**
+     * Read a consistent copy (any thread, never blocks the writer)
+     */
+    T load() const {
+        uint32_t buffer[WORDS];
+        for (;;) {
+            uint32_t before = sequence_.load(std::memory_order_acquire);
+            if (before & 1) {
+                continue;  // Write in progress
+            }
+
+            for (size_t i = 0; i < WORDS; ++i) {
+                buffer[i] = words_[i].load(std::memory_order_relaxed);
+            }
+
+            std::atomic_thread_fence(std::memory_order_acquire);
+            if (sequence_.load(std::memory_order_relaxed) == before) {
+                break;
+            }
+        }
+
+        T value;
+        std::memcpy(&value, buffer, sizeof(T));
+        return value;
+    }
+
+    /**
+     * Number of completed publications
+     */
+    uint32_t version() const {
+        return sequence_.load(std::memory_order_acquire) / 2;
+    }
+
+private:
+    static constexpr size_t WORDS = (sizeof(T) + sizeof(uint32_t) - 1) / sizeof(uint32_t);
+
+    std::atomic<uint32_t> sequence_{0};
+    std::atomic<uint32_t> words_[WORDS];
+};
+
+} // namespace para
+
+#endif // SEQLOCK_HPP
@@ -0,0 +1,173 @@
+#ifndef SPSC_RING_HPP
+#define SPSC_RING_HPP
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <memory>
+#include <type_traits>
+#include <utility>
+
+namespace para {
+
+/**
+ * SpscRing - Bounded single-producer / single-consumer ring with in-place access
+ *
+ * The producer reserve()s a run of contiguous free slots, writes items
+ * straight into them and commit()s; the consumer drain()s by reading the
+ * committed slots in place. Nothing is copied through an intermediate
+ * buffer. The producer re-reads the consumer's index only when its cached
+ * copy says the ring looks full; the consumer reads the producer's index
+ * once per drain.
+ *
+ * Exactly one thread may produce and one may consume at a time.
+ */
+template<typename T>
+class SpscRing {
+    static_assert(std::is_trivially_copyable<T>::value, "SpscRing slots are raw storage");
+
+public:
+    explicit SpscRing(size_t capacity)
+        : capacity_(roundUpToPowerOfTwo(capacity))
+        , mask_(capacity_ - 1)
+        , slots_(new T[capacity_])
+    {
+    }
+
+    SpscRing(const SpscRing&) = delete;
+    SpscRing& operator=(const SpscRing&) = delete;
+
+    /**
+     * Reserve up to maxCount contiguous free slots (producer only)
+     * Sets count to the number reserved, which is smaller than maxCount when
+     * the ring is nearly full or the run reaches the end of the buffer.
+     * Fill them, then commit(); until then the consumer cannot see them
+     */
+    T* reserve(size_t maxCount, size_t& count) {
+        size_t tail = tail_.load(std::memory_order_relaxed);
+        size_t free = capacity_ - (tail - cachedHead_);
+        if (free < maxCount) {
+            cachedHead_ = head_.load(std::memory_order_acquire);
+            free = capacity_ - (tail - cachedHead_);
+        }
+
+        size_t index = tail & mask_;
+        size_t untilEnd = capacity_ - index;
+        count = maxCount;
+        if (count > free) count = free;
+        if (count > untilEnd) count = untilEnd;
+        return slots_.get() + index;
+    }
+
+    /**
+     * Publish the first count reserved slots (producer only)
+     */
+    void commit(size_t count) {
+        tail_.store(tail_.load(std::memory_order_relaxed) + count, std::memory_order_release);
+    }
+
+    /**
+     * Copy one item in (producer only). Returns false if the ring is full
+     */
+    bool tryPush(const T& item) {
+        size_t count;
+        T* slot = reserve(1, count);
+        if (count == 0) return false;
+        *slot = item;
+        commit(1);
+        return true;
+    }
+
+    /**
+     * Visit every committed item in place, in FIFO order, then free the
+     * slots (consumer only). Items committed during the drain wait for the
+     * next call. Returns the number of items passed to fn
+     */
+    template<typename Fn>
+    size_t drain(Fn&& fn) {
+        return drain(static_cast<size_t>(-1), std::forward<Fn>(fn));
+    }
+
+    /**
+     * Same, visiting at most maxItems items (consumer only)
+     */
+    template<typename Fn>
+    size_t drain(size_t maxItems, Fn&& fn) {
+        size_t head = head_.load(std::memory_order_relaxed);
+        size_t available = std::min(tail_.load(std::memory_order_acquire) - head, maxItems);
+        if (available == 0) return 0;
+
+        for (size_t i = 0; i < available; ++i) {
+            const T& item = slots_[(head + i) & mask_];
+            fn(item);
+        }
+
+        head_.store(head + available, std::memory_order_release);
+        return available;
+    }
+
+    /**
+     * Same, stopping before the first item stop(item) is true for; stop
+     * sees each item after fn has seen the previous one (consumer only)
+     */
+    template<typename Stop, typename Fn>
+    size_t drainUntil(size_t maxItems, Stop&& stop, Fn&& fn) {
+        size_t head = head_.load(std::memory_order_relaxed);
+        size_t available = std::min(tail_.load(std::memory_order_acquire) - head, maxItems);
+
+        size_t taken = 0;
+        while (taken < available) {
+            const T& item = slots_[(head + taken) & mask_];
+            if (stop(item)) break;
+            fn(item);
+            ++taken;
+        }
+
+        if (taken > 0) {
+            head_.store(head + taken, std::memory_order_release);
+        }
+        return taken;
+    }
+
+    /**
+     * Number of committed, unconsumed items (approximate from other threads)
+     */
+    size_t size() const {
+        size_t head = head_.load(std::memory_order_acquire);
+        size_t tail = tail_.load(std::memory_order_acquire);
+        return tail - head;
+    }
+
+    bool empty() const {
+        return size() == 0;
+    }
+
+    size_t capacity() const {
+        return capacity_;
+    }
+
+private:
+    static size_t roundUpToPowerOfTwo(size_t n) {
+        size_t cap = 2;
+        while (cap < n) {
+            cap <<= 1;
+        }
+        return cap;
+    }
+
+private:
+    const size_t capacity_;
+    const size_t mask_;
+    std::unique_ptr<T[]> slots_;
+
+    // Producer side
+    alignas(64) std::atomic<size_t> tail_{0};
+    size_t cachedHead_ = 0;
+
+    // Consumer side
+    alignas(64) std::atomic<size_t> head_{0};
+};
+
+} // namespace para
+
+#endif // SPSC_RING_HPP
@@ -0,0 +1,182 @@
+#ifndef STATE_HASH_HPP
+#define STATE_HASH_HPP
+
+#include "types.hpp"
+#include <array>
+#include <cstdint>
+#include <functional>
+
+namespace para {
+
+// ============================================
+// State hashing - Desync detection on the rollback path
+// ============================================
+// A match state carries two checksums, updated as it is simulated:
+// - playerSum: the wrapping sum of one term per player. A move swaps that
+//   player's old term for its new one, so an input costs two table loads
+//   (PlayerTermTable) however many players the match has.
+// - syncHash: a chain over every tick, folded in when the tick advances:
+//   syncHash(t) = chain(syncHash(t - 1), playerSum).
+// Both live in the state, so snapshots restore them, and a re-simulation
+// recomputes the same values a straight simulation would. Because the
+// hash is chained, once two runs diverge they keep disagreeing on every
+// later tick. That is what makes TickHashHistory bisectable.
+//
+// The mixing steps are xxHash64's round and avalanche.
+namespace statehash {
+
+constexpr uint64_t PRIME64_1 = 0x9E3779B185EBCA87ULL;
+constexpr uint64_t PRIME64_2 = 0xC2B2AE3D27D4EB4FULL;
+constexpr uint64_t PRIME64_3 = 0x165667B19E3779F9ULL;
+constexpr uint64_t PRIME64_5 = 0x27D4EB2F165667C5ULL;
+
+// syncHash of a fresh match (before tick 0 completes)
+constexpr uint64_t INITIAL_SYNC_HASH = PRIME64_5;
+
+constexpr uint64_t rotl(uint64_t value, int bits) {
+    return (value << bits) | (value >> (64 - bits));
+}
+
+constexpr uint64_t mixRound(uint64_t acc, uint64_t input) {
+    return rotl(acc + input * PRIME64_2, 31) * PRIME64_1;
+}
+
+constexpr uint64_t avalanche(uint64_t h) {
+    h ^= h >> 33;
+    h *= PRIME64_2;
+    h ^= h >> 29;
+    h *= PRIME64_3;
+    h ^= h >> 32;
+    return h;
+}
+
+// One player's contribution to playerSum
+constexpr uint64_t playerTerm(int player, int x, int y) {
+    uint64_t position = (static_cast<uint64_t>(static_cast<uint32_t>(x)) << 32) | static_cast<uint32_t>(y);
+    return avalanche(mixRound(PRIME64_5 + static_cast<uint64_t>(player), position));
+}
+
+/**
+ * playerTerm of every seat on every cell of Config's arena, computed at
+ * compile time: updating playerSum for a move is two loads
+ */
+template<typename Config>
+struct PlayerTermTable {
+    static constexpr int CELLS = Config::ARENA_WIDTH * Config::ARENA_HEIGHT;
+
+    std::array<uint64_t, static_cast<size_t>(Config::PLAYERS * CELLS)> terms{};
+
+    constexpr PlayerTermTable() {
+        for (int player = 0; player < Config::PLAYERS; ++player) {
+            for (int y = 0; y < Config::ARENA_HEIGHT; ++y) {
+                for (int x = 0; x < Config::ARENA_WIDTH; ++x) {
+                    terms[static_cast<size_t>(player * CELLS + y * Config::ARENA_WIDTH + x)] = playerTerm(player, x, y);
+                }
+            }
+        }
+    }
+
+    // x, y inside the arena (moves clamp to it)
+    uint64_t at(int player, int x, int y) const {
+        return terms[static_cast<size_t>(player * CELLS + y * Config::ARENA_WIDTH + x)];
+    }
+};
+
+template<typename Config>
+inline constexpr PlayerTermTable<Config> PLAYER_TERMS{};
+
+// syncHash after a tick, from the previous tick's and the players' sum.
+// One round: it only feeds equality checks, and it is on every tick's path
+constexpr uint64_t chain(uint64_t previous, uint64_t playerSum) {
+    return mixRound(previous, playerSum);
+}
+
+} // namespace statehash
+
+// ============================================
+// TickHashHistory - A match's syncHash for its most recent ticks
+// ============================================
+/**
+ * Ring of the last TICKS per-tick hashes, written as ticks complete
+ * (again when a rollback re-simulates them). Owner only.
+ *
+ * TICKS covers the rollback window plus one sync interval, so at a final
+ * sync tick the whole interval since the previous one can still be
+ * bisected.
+ */
+class TickHashHistory {
+public:
+    static constexpr int TICKS = 128;
+
+    static_assert(MAX_ROLLBACK_TICKS + ROLLBACK_INTERVAL + SYNC_TICK_INTERVAL < TICKS,
+                  "Hash history must reach back one sync interval past the rollback window");
+
+    void record(int tick, uint64_t hash) {
+        hashes_[static_cast<size_t>(tick) % TICKS] = hash;
+        newestTick_ = tick;
+    }
+
+    // The hash of tick is still retained (and current)
+    bool contains(int tick) const {
+        return tick >= 0 && tick <= newestTick_ && newestTick_ - tick < TICKS;
+    }
+
+    uint64_t at(int tick) const {
+        return hashes_[static_cast<size_t>(tick) % TICKS];
+    }
+
+    int newestTick() const { return newestTick_; }
+
+    void clear() {
+        newestTick_ = -1;
+    }
+
+    /**
+     * First tick in (goodTick, badTick] whose hash differs from
+     * expectedAt(tick), given that goodTick agrees and badTick does not
+     * (binary search, valid because the hash is chained). Both ticks
+     * must be retained; returns -1 if they are not
+     */
+    template<typename Fn>
+    int firstDivergence(int goodTick, int badTick, Fn&& expectedAt) const {
+        if (goodTick >= badTick || !contains(goodTick + 1) || !contains(badTick)) return -1;
+
+        while (badTick - goodTick > 1) {
+            int mid = goodTick + (badTick - goodTick) / 2;
+            if (at(mid) == expectedAt(mid)) {
+                goodTick = mid;
+            } else {
+                badTick = mid;
+            }
+        }
+        return badTick;
+    }
+
+private:
+    std::array<uint64_t, TICKS> hashes_{};
+    int newestTick_ = -1;
+};
+
+// ============================================
+// SyncPoint - One final SYNC_TICK of a match
+// ============================================
+/**
+ * Passed to the sync hook (on the match's owner thread) once tick, a
+ * multiple of SYNC_TICK_INTERVAL, has left the rollback window: no late
+ * input can change its hash any more. Compare hash with the clients'; on
+ * a mismatch, history->firstDivergence(tick - SYNC_TICK_INTERVAL, tick,
+ * clientHashAt) finds the first tick that differs. history is only valid
+ * during the call
+ */
+struct SyncPoint {
+    int matchId;
+    int tick;
+    uint64_t hash;
+    const TickHashHistory* history;
+};
+
+using SyncHook = std::function<void(const SyncPoint&)>;
+
+} // namespace para
+
+#endif // STATE_HASH_HPP
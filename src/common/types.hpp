@@ -2,6 +2,7 @@
 #define TYPES_HPP
 
 #include <cstdint>
+#include <cstddef>
 
 namespace para {
 
@@ -15,12 +16,72 @@ enum class ActionType : uint8_t {
     MOVE_DOWN
 };
 
+// ============================================
+// Game Modes
+// ============================================
+/**
+ * GameConfig - Compile-time parameters of a game mode
+ *
+ * BasicMatch<Config> and BasicMatchState<Config> are specialized per
+ * mode, so arena clamping and player indexing fold to constants in the
+ * simulation loop. GameServer hosts matches of every GameMode side by side
+ */
+template<int ArenaWidth, int ArenaHeight, int Players>
+struct GameConfig {
+    static_assert(ArenaWidth > 0 && ArenaHeight > 0, "Arena must not be empty");
+    static_assert(Players > 0 && Players <= 4, "PackedInput carries a 2-bit player id");
+    
+    static constexpr int ARENA_WIDTH = ArenaWidth;
+    static constexpr int ARENA_HEIGHT = ArenaHeight;
+    static constexpr int PLAYERS = Players;
+};
+
+using DuelConfig = GameConfig<20, 20, 2>;   // 1v1, the default mode
+using TeamConfig = GameConfig<32, 32, 4>;   // 2v2 on a larger arena
+
+// Runtime tag of a match's GameConfig (GameServer::createMatch())
+enum class GameMode : uint8_t {
+    DUEL,
+    TEAM
+};
+
+constexpr int GAME_MODES = 2;
+
+inline const char* gameModeName(GameMode mode) {
+    switch (mode) {
+        case GameMode::DUEL: return "duel";
+        case GameMode::TEAM: return "team";
+        default: return "unknown";
+    }
+}
+
 // ============================================
 // Game Constants
 // ============================================
-constexpr int ARENA_WIDTH = 20;
-constexpr int ARENA_HEIGHT = 20;
+// The default (DUEL) mode's parameters
+constexpr int ARENA_WIDTH = DuelConfig::ARENA_WIDTH;
+constexpr int ARENA_HEIGHT = DuelConfig::ARENA_HEIGHT;
+constexpr int PLAYERS_PER_MATCH = DuelConfig::PLAYERS;
+constexpr int MAX_PLAYERS_PER_MATCH = TeamConfig::PLAYERS;  // Over every mode
 constexpr int ROLLBACK_INTERVAL = 5;  // Rollback every 5 ticks
+constexpr int MAX_ROLLBACK_TICKS = 70;  // Furthest back a rollback can restore exactly
+constexpr size_t SNAPSHOT_DEPTH = MAX_ROLLBACK_TICKS / ROLLBACK_INTERVAL + 1;  // Snapshots kept per match
+constexpr int INPUT_DEADLINE_TICKS = 64;  // Simulate a tick without missing inputs once a player is this far ahead
+constexpr int MAX_INPUT_LEAD_TICKS = 4 * INPUT_DEADLINE_TICKS;  // Furthest past the current tick an input is accepted
+constexpr int SYNC_TICK_INTERVAL = 32;  // Ticks between state hash checks (SyncHook)
+
+// An input that misses its deadline must still find its tick's snapshot
+static_assert(INPUT_DEADLINE_TICKS <= MAX_ROLLBACK_TICKS - ROLLBACK_INTERVAL,
+              "The input deadline must fall inside the rollback window");
+
+// ============================================
+// Server Constants
+// ============================================
+// Per-match input ring size; large enough for the sequential benchmark,
+// which enqueues a match's whole input stream before processing it
+constexpr size_t MATCH_QUEUE_CAPACITY = 1 << 15;
+// Per-player ring size for the direct (SPSC) client input path
+constexpr size_t PLAYER_RING_CAPACITY = 1 << 14;
 
 // ============================================
 // Simulation Constants
@@ -0,0 +1,108 @@
+#ifndef ANY_MATCH_HPP
+#define ANY_MATCH_HPP
+
+#include "match.hpp"
+#include "../common/types.hpp"
+#include <type_traits>
+#include <utility>
+#include <variant>
+
+namespace para {
+
+/**
+ * AnyMatch - A match of any GameMode, as GameServer's registry holds it
+ *
+ * The BasicMatch<Config> is held in place (a std::variant in GameMode
+ * order, no virtual calls). The forwarding calls below dispatch on the
+ * mode once per call; hot loops go through visit() instead, so one
+ * dispatch covers a whole drain and the loop inside runs on the
+ * specialized match.
+ *
+ * The same threading rules as BasicMatch apply to each call.
+ */
+class AnyMatch {
+public:
+    using Variant = std::variant<BasicMatch<DuelConfig>, BasicMatch<TeamConfig>>;
+    
+    AnyMatch(GameMode mode, int matchId) : match_(make(mode, matchId)) {}
+    
+    AnyMatch(const AnyMatch&) = delete;
+    AnyMatch& operator=(const AnyMatch&) = delete;
+    
+    GameMode mode() const {
+        return static_cast<GameMode>(match_.index());
+    }
+    
+    /**
+     * Call fn with the match as its concrete BasicMatch<Config>&
+     */
+    template<typename Fn>
+    decltype(auto) visit(Fn&& fn) {
+        return std::visit(std::forward<Fn>(fn), match_);
+    }
+    
+    template<typename Fn>
+    decltype(auto) visit(Fn&& fn) const {
+        return std::visit(std::forward<Fn>(fn), match_);
+    }
+    
+    /**
+     * The match if it is of Config's mode, else nullptr
+     */
+    template<typename Config>
+    BasicMatch<Config>* get() {
+        return std::get_if<BasicMatch<Config>>(&match_);
+    }
+    
+    template<typename Config>
+    const BasicMatch<Config>* get() const {
+        return std::get_if<BasicMatch<Config>>(&match_);
+    }
+    
+    // Seats of this match's mode
+    int players() const {
+        return visit([](const auto& match) {
+            return std::decay_t<decltype(match)>::GameConfig::PLAYERS;
+        });
+    }
+    
+    // ============================================
+    // Forwarded BasicMatch calls
+    // ============================================
+    void reset(int matchId) { visit([matchId](auto& m) { m.reset(matchId); }); }
+    void start() { visit([](auto& m) { m.start(); }); }
+    void processInput(const Input& input) { visit([&input](auto& m) { m.processInput(input); }); }
+    void advanceTo(int tick) { visit([tick](auto& m) { m.advanceTo(tick); }); }
+    void setRollbackInterval(int ticks) { visit([ticks](auto& m) { m.setRollbackInterval(ticks); }); }
+    void setSnapshotPolicy(SnapshotPolicy policy) { visit([policy](auto& m) { m.setSnapshotPolicy(policy); }); }
+    void setDeferRollbacks(bool defer) { visit([defer](auto& m) { m.setDeferRollbacks(defer); }); }
+    void setSyncHook(const SyncHook* hook) { visit([hook](auto& m) { m.setSyncHook(hook); }); }
+    void applyCommands() { visit([](auto& m) { m.applyCommands(); }); }
+    void resolveDeferredRollback() { visit([](auto& m) { m.resolveDeferredRollback(); }); }
+    void publishState() { visit([](auto& m) { m.publishState(); }); }
+    
+    bool hasDeferredRollback() const { return visit([](const auto& m) { return m.hasDeferredRollback(); }); }
+    int getDeferredReplayTicks() const { return visit([](const auto& m) { return m.getDeferredReplayTicks(); }); }
+    int getCurrentTick() const { return visit([](const auto& m) { return m.getCurrentTick(); }); }
+    int getRollbackCount() const { return visit([](const auto& m) { return m.getRollbackCount(); }); }
+    int getLateInputCount() const { return visit([](const auto& m) { return m.getLateInputCount(); }); }
+    int getExpiredInputCount() const { return visit([](const auto& m) { return m.getExpiredInputCount(); }); }
+    int getMatchId() const { return visit([](const auto& m) { return m.getMatchId(); }); }
+    bool isRunning() const { return visit([](const auto& m) { return m.isRunning(); }); }
+    
+private:
+    static Variant make(GameMode mode, int matchId) {
+        if (mode == GameMode::TEAM) {
+            return Variant(std::in_place_index<1>, matchId);
+        }
+        return Variant(std::in_place_index<0>, matchId);
+    }
+    
+    Variant match_;
+};
+
+static_assert(std::variant_size<AnyMatch::Variant>::value == GAME_MODES, "One alternative per GameMode");
+
+} // namespace para
+
+#endif // ANY_MATCH_HPP
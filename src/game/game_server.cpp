@@ -1,59 +1,549 @@
 #include "game_server.hpp"
+#include "input_trace.hpp"
+#include "../common/metrics.hpp"
 #include <algorithm>
+#include <stdexcept>
+#include <thread>
+#include <type_traits>
 
 namespace para {
 
-GameServer::GameServer(int numMatches) 
-    : numMatches_(numMatches)
+GameServer::GameServer(int numMatches, size_t queueCapacity, int maxMatches) 
+    : queueCapacity_(queueCapacity)
+    , numMatches_(std::max(numMatches, maxMatches))
 {
-    // Create all matches and queues
-    matches_.reserve(numMatches);
-    matchQueues_.reserve(numMatches);
+    // Queued inputs carry a 12-bit match index
+    if (numMatches_ > PackedInput::MAX_MATCHES) {
+        throw std::invalid_argument("GameServer: too many matches for PackedInput");
+    }
+    
+    // Every slot exists up front; queues and matches come with first use
+    slots_.reset(new MatchSlot[numMatches_]);
+    matchStorage_.reserve(numMatches_);
+    queueStorage_.reserve(numMatches_);
+    for (int i = 0; i < numMatches_; ++i) {
+        freeSlots_.push_back(i);
+    }
     for (int i = 0; i < numMatches; ++i) {
-        matches_.push_back(std::make_unique<Match>(i));
-        matchQueues_.push_back(std::make_unique<MatchQueue>());
+        createMatchLocked(GameMode::DUEL);
     }
 }
 
 void GameServer::start() {
-    for (auto& match : matches_) {
+    std::lock_guard<std::mutex> lock(lifecycleMutex_);
+    started_ = true;
+    for (int i = 0; i < numMatches_; ++i) {
+        if (AnyMatch* match = currentMatch(i)) {
+            match->start();
+        }
+    }
+}
+
+MatchHandle GameServer::createMatch(GameMode mode) {
+    std::lock_guard<std::mutex> lock(lifecycleMutex_);
+    return createMatchLocked(mode);
+}
+
+MatchHandle GameServer::createMatchLocked(GameMode mode) {
+    if (freeSlots_.empty()) return MatchHandle();
+    
+    int slotId = freeSlots_.front();
+    freeSlots_.pop_front();
+    MatchSlot& slot = slots_[slotId];
+    
+    // A slot's queue is made for its first match and kept for the next ones
+    if (!slot.queue.load(std::memory_order_relaxed)) {
+        queueStorage_.push_back(std::make_unique<MatchQueue>(queueCapacity_));
+        MatchQueue* mq = queueStorage_.back().get();
+        if (adaptiveDrain_) {
+            mq->drainControl.configure(drainTargets_);
+        }
+        addPlayerRings(*mq);
+        slot.queue.store(mq, std::memory_order_release);
+    }
+    
+    // Recycled matches keep their buffers: no allocation once the pool is
+    // warm. Pools are per mode, a match's Config is fixed
+    std::vector<AnyMatch*>& pool = freeMatches_[static_cast<size_t>(mode)];
+    AnyMatch* match;
+    if (!pool.empty()) {
+        match = pool.back();
+        pool.pop_back();
+    } else {
+        matchStorage_.push_back(std::make_unique<AnyMatch>(mode, slotId));
+        match = matchStorage_.back().get();
+    }
+    match->reset(slotId);
+    match->setRollbackInterval(rollbackInterval_);
+    match->setSnapshotPolicy(snapshotPolicy_);
+    match->setSyncHook(syncHook_ ? &syncHook_ : nullptr);
+    match->setDeferRollbacks(rollbackStorms_);
+    if (started_) {
         match->start();
     }
+    slot.match.store(match, std::memory_order_relaxed);
+    
+    // Publishing the new generation makes match and queue visible to routing
+    uint32_t generation = (slot.state.load(std::memory_order_relaxed) >> 2) + 1;
+    uint32_t key = (generation << 2) | SLOT_LIVE;
+    slot.state.store(key, std::memory_order_release);
+    activeMatches_.fetch_add(1, std::memory_order_relaxed);
+    return MatchHandle{slotId, key};
+}
+
+bool GameServer::endMatch(MatchHandle handle) {
+    if (handle.slot < 0 || handle.slot >= numMatches_) return false;
+    
+    MatchSlot& slot = slots_[handle.slot];
+    {
+        std::lock_guard<std::mutex> lock(lifecycleMutex_);
+        if (slot.state.load(std::memory_order_relaxed) != handle.key) return false;
+        slot.state.store((handle.key & ~PHASE_MASK) | SLOT_ENDED, std::memory_order_release);
+        activeMatches_.fetch_sub(1, std::memory_order_relaxed);
+    }
+    
+    // Only the match's owner may recycle it
+    if (pool_) {
+        scheduleMatch(handle.slot);
+    } else {
+        retireMatch(handle.slot, slot.match.load(std::memory_order_relaxed));
+    }
+    return true;
+}
+
+void GameServer::retireMatch(int matchId, AnyMatch* match) {
+    MatchSlot& slot = slots_[matchId];
+    discardQueued(*slot.queue.load(std::memory_order_relaxed));
+    retiredRollbacks_.fetch_add(match->getRollbackCount(), std::memory_order_relaxed);
+    retiredLateInputs_.fetch_add(match->getLateInputCount(), std::memory_order_relaxed);
+    retiredExpiredInputs_.fetch_add(match->getExpiredInputCount(), std::memory_order_relaxed);
+    
+    std::lock_guard<std::mutex> lock(lifecycleMutex_);
+    uint32_t generationBits = slot.state.load(std::memory_order_relaxed) & ~PHASE_MASK;
+    slot.state.store(generationBits | SLOT_FREE, std::memory_order_release);
+    freeMatches_[static_cast<size_t>(match->mode())].push_back(match);
+    freeSlots_.push_back(matchId);
+}
+
+void GameServer::discardQueued(MatchQueue& mq) {
+    auto discard = [](PackedInput) {};
+    size_t discarded = mq.ring.drain(discard);
+    for (auto& ring : mq.players) {
+        if (ring) {
+            discarded += ring->drain(discard);
+        }
+    }
+    if (discarded > 0) {
+        pendingInputs_.fetch_sub(discarded, std::memory_order_relaxed);
+        droppedCount_.fetch_add(discarded, std::memory_order_relaxed);
+    }
+}
+
+bool GameServer::isLive(MatchHandle handle) const {
+    if (handle.slot < 0 || handle.slot >= numMatches_) return false;
+    return slots_[handle.slot].state.load(std::memory_order_acquire) == handle.key;
+}
+
+MatchHandle GameServer::getMatchHandle(int slot) const {
+    if (slot < 0 || slot >= numMatches_) return MatchHandle();
+    uint32_t state = slots_[slot].state.load(std::memory_order_acquire);
+    if ((state & PHASE_MASK) != SLOT_LIVE) return MatchHandle();
+    return MatchHandle{slot, state};
+}
+
+int GameServer::getActiveMatchCount() const {
+    return activeMatches_.load(std::memory_order_relaxed);
+}
+
+size_t GameServer::getAllocatedMatchCount() const {
+    std::lock_guard<std::mutex> lock(lifecycleMutex_);
+    return matchStorage_.size();
+}
+
+GameServer::MatchQueue* GameServer::liveQueue(int matchId) const {
+    const MatchSlot& slot = slots_[matchId];
+    if ((slot.state.load(std::memory_order_acquire) & PHASE_MASK) != SLOT_LIVE) return nullptr;
+    return slot.queue.load(std::memory_order_relaxed);
+}
+
+AnyMatch* GameServer::currentMatch(int matchId) const {
+    const MatchSlot& slot = slots_[matchId];
+    if ((slot.state.load(std::memory_order_acquire) & PHASE_MASK) == SLOT_FREE) return nullptr;
+    return slot.match.load(std::memory_order_relaxed);
+}
+
+void GameServer::enableEventScheduling(ThreadPool& pool) {
+    pool_ = &pool;
+}
+
+void GameServer::setRollbackInterval(int ticks) {
+    std::lock_guard<std::mutex> lock(lifecycleMutex_);
+    rollbackInterval_ = ticks;
+    for (int i = 0; i < numMatches_; ++i) {
+        if (AnyMatch* match = currentMatch(i)) {
+            match->setRollbackInterval(ticks);
+        }
+    }
+}
+
+void GameServer::setSnapshotPolicy(SnapshotPolicy policy) {
+    std::lock_guard<std::mutex> lock(lifecycleMutex_);
+    snapshotPolicy_ = policy;
+    for (int i = 0; i < numMatches_; ++i) {
+        if (AnyMatch* match = currentMatch(i)) {
+            match->setSnapshotPolicy(policy);
+        }
+    }
+}
+
+void GameServer::setSyncHook(SyncHook hook) {
+    std::lock_guard<std::mutex> lock(lifecycleMutex_);
+    syncHook_ = std::move(hook);
+    for (int i = 0; i < numMatches_; ++i) {
+        if (AnyMatch* match = currentMatch(i)) {
+            match->setSyncHook(syncHook_ ? &syncHook_ : nullptr);
+        }
+    }
+}
+
+void GameServer::enableAdaptiveDrain(const BatchTargets& targets) {
+    std::lock_guard<std::mutex> lock(lifecycleMutex_);
+    drainTargets_ = targets;
+    adaptiveDrain_ = true;
+    for (auto& mq : queueStorage_) {
+        mq->drainControl.configure(targets);
+    }
+}
+
+void GameServer::setRollbackStormMode(bool enabled) {
+    std::lock_guard<std::mutex> lock(lifecycleMutex_);
+    rollbackStorms_ = enabled;
+    for (int i = 0; i < numMatches_; ++i) {
+        if (AnyMatch* match = currentMatch(i)) {
+            match->setDeferRollbacks(enabled);
+        }
+    }
+}
+
+void GameServer::setTraceRecorder(InputTraceRecorder* recorder) {
+    recorder_ = recorder;
 }
 
 void GameServer::receiveInput(const Input& input) {
-    if (input.matchId >= 0 && input.matchId < numMatches_) {
-        std::lock_guard<std::mutex> lock(matchQueues_[input.matchId]->mutex);
-        matchQueues_[input.matchId]->queue.push(input);
+    if (input.matchId < 0 || input.matchId >= numMatches_) return;
+    
+    PackedInput packed = PackedInput::pack(input);
+    if (recorder_) recorder_->record(&packed, 1);
+    enqueueGroup(input.matchId, &packed, 1);
+}
+
+void GameServer::receiveInput(PackedInput input) {
+    if (recorder_) recorder_->record(&input, 1);
+    enqueueGroup(input.localMatch(), &input, 1);
+}
+
+void GameServer::receiveInputs(const PackedInput* inputs, size_t count) {
+    if (count == 0) return;
+    if (recorder_) recorder_->record(inputs, count);
+    
+    // Fast path: a client batch targets a single match
+    int firstMatch = inputs[0].localMatch();
+    size_t run = 1;
+    while (run < count && inputs[run].localMatch() == firstMatch) {
+        ++run;
+    }
+    if (run == count) {
+        enqueueGroup(firstMatch, inputs, count);
+        return;
+    }
+    
+    // Mixed batch: counting sort by matchId into per-match spans.
+    // Scratch is per thread and only cleared for touched matches, so
+    // steady-state batches allocate nothing and cost O(batch), not O(matches)
+    struct Scratch {
+        std::vector<size_t> counts;
+        std::vector<int> touched;
+        std::vector<PackedInput> sorted;
+    };
+    thread_local Scratch scratch;
+    
+    if (scratch.counts.size() < static_cast<size_t>(numMatches_)) {
+        scratch.counts.resize(numMatches_, 0);
+    }
+    scratch.touched.clear();
+    
+    size_t valid = 0;
+    for (size_t i = 0; i < count; ++i) {
+        int matchId = inputs[i].localMatch();
+        if (matchId < 0 || matchId >= numMatches_) continue;
+        if (scratch.counts[matchId]++ == 0) {
+            scratch.touched.push_back(matchId);
+        }
+        ++valid;
+    }
+    
+    // Exclusive prefix sum over the touched matches only
+    size_t offset = 0;
+    for (int matchId : scratch.touched) {
+        size_t groupSize = scratch.counts[matchId];
+        scratch.counts[matchId] = offset;
+        offset += groupSize;
+    }
+    
+    scratch.sorted.resize(valid);
+    for (size_t i = 0; i < count; ++i) {
+        int matchId = inputs[i].localMatch();
+        if (matchId < 0 || matchId >= numMatches_) continue;
+        scratch.sorted[scratch.counts[matchId]++] = inputs[i];
+    }
+    
+    // counts[m] now holds the end of m's span; spans follow touched order
+    size_t begin = 0;
+    for (int matchId : scratch.touched) {
+        size_t end = scratch.counts[matchId];
+        enqueueGroup(matchId, scratch.sorted.data() + begin, end - begin);
+        begin = end;
+        scratch.counts[matchId] = 0;
+    }
+}
+
+void GameServer::receiveInputs(const std::vector<PackedInput>& inputs) {
+    receiveInputs(inputs.data(), inputs.size());
+}
+
+void GameServer::receiveInputs(std::vector<PackedInput>&& inputs) {
+    receiveInputs(inputs.data(), inputs.size());
+    inputs.clear();
+}
+
+void GameServer::receiveInputs(InputBatch&& batch) {
+    receiveInputs(batch.data(), batch.size());
+    batch.release();
+}
+
+void GameServer::enableDirectInput(size_t ringCapacity) {
+    std::lock_guard<std::mutex> lock(lifecycleMutex_);
+    playerRingCapacity_ = ringCapacity;
+    for (int i = 0; i < numMatches_; ++i) {
+        MatchQueue* mq = slots_[i].queue.load(std::memory_order_relaxed);
+        if (mq) {
+            addPlayerRings(*mq);
+        }
+    }
+}
+
+void GameServer::addPlayerRings(MatchQueue& mq) {
+    if (playerRingCapacity_ == 0) return;
+    for (int p = 0; p < MAX_PLAYERS_PER_MATCH; ++p) {
+        if (!mq.players[p]) {
+            mq.players[p] = std::make_unique<PlayerRing>(playerRingCapacity_);
+        }
+    }
+}
+
+GameServer::PlayerRing* GameServer::getPlayerRing(int matchId, int playerId) {
+    if (matchId < 0 || matchId >= numMatches_) return nullptr;
+    if (playerId < 0 || playerId >= MAX_PLAYERS_PER_MATCH) return nullptr;
+    MatchQueue* mq = slots_[matchId].queue.load(std::memory_order_acquire);
+    return mq ? mq->players[playerId].get() : nullptr;
+}
+
+void GameServer::notifyInputs(int matchId, size_t count) {
+    if (matchId < 0 || matchId >= numMatches_ || count == 0) return;
+    
+    // Already in the slot's ring: counted even if the match has ended, so
+    // the discard on retirement balances the books
+    MatchQueue* mq = slots_[matchId].queue.load(std::memory_order_acquire);
+    if (!mq) return;
+    noteEnqueued(*mq);
+    pendingInputs_.fetch_add(count, std::memory_order_relaxed);
+    if (pool_) {
+        scheduleMatch(matchId);
+    }
+}
+
+void GameServer::enqueueGroup(int matchId, const PackedInput* inputs, size_t count) {
+    if (matchId < 0 || matchId >= numMatches_) return;
+    
+    MatchQueue* mq = liveQueue(matchId);
+    if (!mq) {
+        droppedCount_.fetch_add(count, std::memory_order_relaxed);
+        return;
+    }
+    
+    size_t accepted = mq->ring.tryPushBatch(inputs, count);
+    if (accepted < count) {
+        droppedCount_.fetch_add(count - accepted, std::memory_order_relaxed);
+    }
+    if (accepted == 0) return;
+    
+    noteEnqueued(*mq);
+    pendingInputs_.fetch_add(accepted, std::memory_order_relaxed);
+    if (pool_) {
+        scheduleMatch(matchId);
+    }
+}
+
+void GameServer::noteEnqueued(MatchQueue& mq) {
+#ifdef PARA_ENABLE_METRICS
+    if (mq.oldestEnqueueNs.load(std::memory_order_relaxed) != 0) return;
+    uint64_t expected = 0;
+    mq.oldestEnqueueNs.compare_exchange_strong(expected, metrics::now(), std::memory_order_relaxed);
+#else
+    (void)mq;
+#endif
+}
+
+void GameServer::scheduleMatch(int matchId) {
+    MatchQueue& mq = *slots_[matchId].queue.load(std::memory_order_acquire);
+    
+    // Pairs with the fence in runScheduledMatch(): either we see the flag
+    // cleared, or the task sees our inputs when it re-checks the ring
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (mq.scheduled.load(std::memory_order_relaxed)) return;
+    if (mq.scheduled.exchange(true, std::memory_order_acq_rel)) return;
+    
+    scheduledTasks_.fetch_add(1, std::memory_order_relaxed);
+    pool_->submitAffine(static_cast<size_t>(matchId), [this, matchId]() {
+        runScheduledMatch(matchId);
+    });
+}
+
+void GameServer::runScheduledMatch(int matchId) {
+    MatchQueue& mq = *slots_[matchId].queue.load(std::memory_order_acquire);
+    
+    processPending(matchId);
+    
+    mq.scheduled.store(false, std::memory_order_release);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    
+    // Inputs (or an endMatch()) that raced with the drain: take the flag
+    // back and go again
+    uint32_t phase = slots_[matchId].state.load(std::memory_order_relaxed) & PHASE_MASK;
+    if (hasQueuedInputs(mq) || phase == SLOT_ENDED) {
+        scheduleMatch(matchId);
+    }
+}
+
+bool GameServer::hasQueuedInputs(const MatchQueue& mq) const {
+    if (!mq.ring.empty()) return true;
+    for (const auto& ring : mq.players) {
+        if (ring && !ring->empty()) return true;
     }
+    return false;
 }
 
-void GameServer::receiveInputs(const std::vector<Input>& inputs) {
-    for (const auto& input : inputs) {
-        receiveInput(input);
+size_t GameServer::queuedInputs(const MatchQueue& mq) const {
+    size_t queued = mq.ring.size();
+    for (const auto& ring : mq.players) {
+        if (ring) {
+            queued += ring->size();
+        }
     }
+    return queued;
 }
 
 void GameServer::processPending(int matchId) {
+    drainPending(matchId, false);
+}
+
+void GameServer::drainPending(int matchId, bool holdRollbacks) {
     if (matchId < 0 || matchId >= numMatches_) return;
     
-    std::queue<Input> localQueue;
+    MatchSlot& slot = slots_[matchId];
+    MatchQueue* queue = slot.queue.load(std::memory_order_acquire);
+    if (!queue) return;
+    MatchQueue& mq = *queue;
     
-    // Extract everything currently in the queue
-    {
-        std::lock_guard<std::mutex> lock(matchQueues_[matchId]->mutex);
-        if (matchQueues_[matchId]->queue.empty()) return;
-        std::swap(localQueue, matchQueues_[matchId]->queue);
+    // The slot's phase says whose inputs these are: a free slot's are
+    // stragglers of a match already retired
+    uint32_t phase = slot.state.load(std::memory_order_acquire) & PHASE_MASK;
+    AnyMatch* match = slot.match.load(std::memory_order_relaxed);
+    if (phase == SLOT_FREE) {
+        discardQueued(mq);
+        return;
+    }
+    if (phase == SLOT_ENDED) {
+        retireMatch(matchId, match);
+        return;
     }
     
-    Match* match = matches_[matchId].get();
+    // This call is the match's owner until it returns: run queued commands,
+    // then take what is queued now straight from the ring, no lock. Later
+    // arrivals wait for the next call so producers can't pin us
+    match->applyCommands();
+#ifdef PARA_ENABLE_METRICS
+    uint64_t oldestEnqueued = mq.oldestEnqueueNs.exchange(0, std::memory_order_relaxed);
+#endif
+    size_t quantum = adaptiveDrain_ ? mq.drainControl.size() : static_cast<size_t>(-1);
+    uint64_t drainStart = adaptiveDrain_ ? AdaptiveBatchController::nowNs() : 0;
     
-    // Process without holding the lock
-    while (!localQueue.empty()) {
-        const Input& input = localQueue.front();
-        match->processInput(input);
-        localQueue.pop();
-        processedCount_.fetch_add(1, std::memory_order_relaxed);
+    // One dispatch on the match's mode: the loops below run on the
+    // specialized match
+    size_t processed = match->visit([&mq, quantum](auto& typed) {
+        auto process = [&typed](PackedInput input) {
+            typed.processInput(input);
+        };
+        size_t taken = mq.ring.drain(std::min(mq.ring.size(), quantum), process);
+        
+        // Direct rings are read in place and merged by tick: in each pass a
+        // player's ring gives up its turn at an input that would force the
+        // deadline of a tick another player has still to send, and takes
+        // at most an even share of what is left of the quantum. Only this
+        // mode's seats (the rings past them never fill), and only what each
+        // ring held when the drain started
+        constexpr size_t seats = std::decay_t<decltype(typed)>::GameConfig::PLAYERS;
+        if (!mq.players[0]) return taken;
+        std::array<size_t, seats> budget;
+        for (size_t p = 0; p < seats; ++p) {
+            budget[p] = mq.players[p]->size();
+        }
+        auto ahead = [&typed](PackedInput input) {
+            return typed.forcesDeadline(input);
+        };
+        while (taken < quantum) {
+            size_t before = taken;
+            for (size_t p = 0; p < seats; ++p) {
+                size_t left = quantum - taken;
+                size_t share = std::min(left / (seats - p) + (left % (seats - p) != 0), budget[p]);
+                size_t got = mq.players[p]->drainUntil(share, ahead, process);
+                budget[p] -= got;
+                taken += got;
+            }
+            if (taken > before) continue;
+            
+            // Every ring stopped short of the deadline: the inputs the match
+            // waits for have not arrived, so the first ring's next one forces it
+            for (size_t p = 0; p < seats && taken == before; ++p) {
+                if (budget[p] == 0) continue;
+                taken += mq.players[p]->drain(1, process);
+                --budget[p];
+            }
+            if (taken == before) break;
+        }
+        return taken;
+    });
+    
+    // Storm mode: late inputs so far cost one replay between them
+    if (!holdRollbacks) {
+        match->resolveDeferredRollback();
+    }
+    match->publishState();
+    
+    if (processed > 0) {
+        processedCount_.fetch_add(processed, std::memory_order_relaxed);
+        pendingInputs_.fetch_sub(processed, std::memory_order_relaxed);
+        if (adaptiveDrain_) {
+            metrics::record(metrics::Histogram::DRAIN_QUANTUM, quantum);
+            mq.drainControl.onDrain(AdaptiveBatchController::nowNs() - drainStart, queuedInputs(mq));
+        }
+        
+        metrics::add(metrics::Counter::DRAINS);
+        metrics::add(metrics::Counter::INPUTS_PROCESSED, processed);
+        metrics::record(metrics::Histogram::DRAIN_BATCH_SIZE, processed);
+#ifdef PARA_ENABLE_METRICS
+        metrics::recordSince(metrics::Histogram::ENQUEUE_TO_PROCESS_NS, oldestEnqueued);
+#endif
     }
 }
 
@@ -62,11 +552,9 @@ void GameServer::processAllSequential() {
     while (hasWork) {
         hasWork = false;
         for (int i = 0; i < numMatches_; ++i) {
-            {
-                std::lock_guard<std::mutex> lock(matchQueues_[i]->mutex);
-                if (!matchQueues_[i]->queue.empty()) {
-                    hasWork = true;
-                }
+            MatchQueue* mq = slots_[i].queue.load(std::memory_order_acquire);
+            if (mq && hasQueuedInputs(*mq)) {
+                hasWork = true;
             }
             if (hasWork) {
                 processPending(i);
@@ -76,19 +564,157 @@ void GameServer::processAllSequential() {
 }
 
 void GameServer::processAllParallel(ThreadPool& pool) {
+    if (pool_) {
+        // Event scheduling owns the consumers: just wait for them to drain
+        pool.waitAll();
+        return;
+    }
+    
     // Just submit a task for each match to process its queue
+    TaskGroup drains(pool);
     for (int i = 0; i < numMatches_; ++i) {
-        pool.submit([this, i]() {
-            processPending(i);
+        if (!slots_[i].queue.load(std::memory_order_acquire)) continue;
+        submitDrain(drains, i);
+    }
+    drains.wait();
+    
+    if (rollbackStorms_) {
+        std::vector<std::pair<int, int>> storm;
+        collectRollbackStorm(storm);
+        pool.parallelFor(0, storm.size(), 1, [this, &storm](size_t k) {
+            AnyMatch* match = currentMatch(storm[k].second);
+            match->resolveDeferredRollback();
+            match->publishState();
         });
     }
-    pool.waitAll();
+}
+
+void GameServer::collectRollbackStorm(std::vector<std::pair<int, int>>& storm) const {
+    storm.clear();
+    for (int i = 0; i < numMatches_; ++i) {
+        const AnyMatch* match = currentMatch(i);
+        if (match && match->hasDeferredRollback()) {
+            storm.emplace_back(match->getDeferredReplayTicks(), i);
+        }
+    }
+    std::sort(storm.begin(), storm.end(), std::greater<std::pair<int, int>>());
+}
+
+void GameServer::submitDrain(TaskGroup& group, int matchId) {
+    group.runAffine(static_cast<size_t>(matchId), [this, &group, matchId]() {
+        drainPending(matchId, rollbackStorms_);
+        
+        // A capped drain left the rest: go again behind the other matches
+        MatchQueue& mq = *slots_[matchId].queue.load(std::memory_order_acquire);
+        if (adaptiveDrain_ && hasQueuedInputs(mq)) {
+            submitDrain(group, matchId);
+        }
+    });
+}
+
+TickLoopStats GameServer::runTickLoop(ThreadPool& pool, int hz, std::chrono::milliseconds duration,
+                                      const std::function<void(int)>& onTickStart) {
+    using Clock = std::chrono::steady_clock;
+    
+    TickLoopStats stats;
+    stats.overrunsPerMatch.assign(numMatches_, 0);
+    if (hz <= 0 || pool_) return stats;
+    
+    const auto period = std::chrono::duration_cast<Clock::duration>(std::chrono::nanoseconds(1000000000LL / hz));
+    const int numTicks = static_cast<int>(duration.count() * hz / 1000);
+    
+    std::vector<double> latenciesMs;
+    latenciesMs.reserve(numTicks);
+    
+    // Each match task flags its own slot; read after the tick's wait()
+    std::vector<char> overran(numMatches_, 0);
+    std::vector<std::pair<int, int>> storm;
+    storm.reserve(numMatches_);
+    
+    const int rollbacksBefore = getTotalRollbackCount();
+    const auto loopStart = Clock::now();
+    for (int tick = 0; tick < numTicks; ++tick) {
+        const auto tickStart = loopStart + tick * period;
+        const auto deadline = tickStart + period;
+        
+        // Behind schedule: start right away and let the latency show it
+        std::this_thread::sleep_until(tickStart);
+        
+        if (onTickStart) {
+            onTickStart(tick);
+        }
+        
+        TaskGroup matches(pool);
+        for (int i = 0; i < numMatches_; ++i) {
+            if (!currentMatch(i)) continue;
+            matches.runAffine(static_cast<size_t>(i), [this, i, tick, deadline, &overran]() {
+                drainPending(i, rollbackStorms_);
+                
+                // Gone if it had ended (the drain retired it); a held
+                // rollback is replayed in the storm pass below
+                AnyMatch* match = currentMatch(i);
+                if (!match || match->hasDeferredRollback()) return;
+                match->advanceTo(tick + 1);
+                match->publishState();
+                
+                overran[i] = Clock::now() > deadline ? 1 : 0;
+            });
+        }
+        matches.wait();
+        
+        // Rollback storm: every replay at once, longest first, over the
+        // whole pool (this thread joins in)
+        if (rollbackStorms_) {
+            collectRollbackStorm(storm);
+            if (!storm.empty()) {
+                ++stats.stormTicks;
+                stats.stormReplays += storm.size();
+                pool.parallelFor(0, storm.size(), 1, [this, &storm, tick, deadline, &overran](size_t k) {
+                    int i = storm[k].second;
+                    AnyMatch* match = currentMatch(i);
+                    match->resolveDeferredRollback();
+                    match->advanceTo(tick + 1);
+                    match->publishState();
+                    
+                    overran[i] = Clock::now() > deadline ? 1 : 0;
+                });
+            }
+        }
+        
+        const auto tickEnd = Clock::now();
+        latenciesMs.push_back(std::chrono::duration<double, std::milli>(tickEnd - tickStart).count());
+        if (tickEnd > deadline) {
+            ++stats.missedDeadlines;
+        }
+        for (int i = 0; i < numMatches_; ++i) {
+            if (overran[i]) {
+                ++stats.overrunsPerMatch[i];
+                ++stats.matchOverruns;
+            }
+        }
+    }
+    
+    stats.ticks = latenciesMs.size();
+    stats.rollbacks = getTotalRollbackCount() - rollbacksBefore;
+    if (!latenciesMs.empty()) {
+        std::sort(latenciesMs.begin(), latenciesMs.end());
+        auto percentile = [&latenciesMs](double p) {
+            size_t index = static_cast<size_t>(p * (latenciesMs.size() - 1) + 0.5);
+            return latenciesMs[index];
+        };
+        stats.p50Ms = percentile(0.50);
+        stats.p99Ms = percentile(0.99);
+        stats.p999Ms = percentile(0.999);
+        stats.maxMs = latenciesMs.back();
+    }
+    return stats;
 }
 
 void GameServer::processSingleInput(const Input& input) {
     // Legacy helper - mostly redundant now but keeping for interface compatibility if needed internally
-    if (input.matchId >= 0 && input.matchId < numMatches_) {
-        matches_[input.matchId]->processInput(input);
+    if (input.matchId < 0 || input.matchId >= numMatches_) return;
+    if (AnyMatch* match = currentMatch(input.matchId)) {
+        match->processInput(input);
         processedCount_.fetch_add(1, std::memory_order_relaxed);
     }
 }
@@ -98,22 +724,87 @@ size_t GameServer::getProcessedCount() const {
 }
 
 int GameServer::getTotalRollbackCount() const {
-    int total = 0;
-    for (const auto& match : matches_) {
-        total += match->getRollbackCount();
+    int total = retiredRollbacks_.load(std::memory_order_relaxed);
+    for (int i = 0; i < numMatches_; ++i) {
+        if (const AnyMatch* match = currentMatch(i)) {
+            total += match->getRollbackCount();
+        }
     }
     return total;
 }
 
-size_t GameServer::getPendingCount() const {
-    size_t total = 0;
-    for (const auto& mq : matchQueues_) {
-        std::lock_guard<std::mutex> lock(mq->mutex);
-        total += mq->queue.size();
+int GameServer::getTotalLateInputCount() const {
+    int total = retiredLateInputs_.load(std::memory_order_relaxed);
+    for (int i = 0; i < numMatches_; ++i) {
+        if (const AnyMatch* match = currentMatch(i)) {
+            total += match->getLateInputCount();
+        }
+    }
+    return total;
+}
+
+int GameServer::getTotalExpiredInputCount() const {
+    int total = retiredExpiredInputs_.load(std::memory_order_relaxed);
+    for (int i = 0; i < numMatches_; ++i) {
+        if (const AnyMatch* match = currentMatch(i)) {
+            total += match->getExpiredInputCount();
+        }
     }
     return total;
 }
 
+int GameServer::getMatchTick(int matchId) const {
+    if (matchId < 0 || matchId >= numMatches_) return 0;
+    const AnyMatch* match = currentMatch(matchId);
+    return match ? match->getCurrentTick() : 0;
+}
+
+MatchState GameServer::getMatchState(int matchId) const {
+    MatchState state;
+    getMatchState(matchId, state);
+    return state;
+}
+
+GameMode GameServer::getMatchMode(int matchId) const {
+    if (matchId < 0 || matchId >= numMatches_) return GameMode::DUEL;
+    const AnyMatch* match = currentMatch(matchId);
+    return match ? match->mode() : GameMode::DUEL;
+}
+
+size_t GameServer::getDroppedCount() const {
+    return droppedCount_.load(std::memory_order_relaxed);
+}
+
+size_t GameServer::getPendingCount() const {
+    return pendingInputs_.load(std::memory_order_relaxed);
+}
+
+size_t GameServer::getQueueDepth(int matchId) const {
+    if (matchId < 0 || matchId >= numMatches_) return 0;
+    const MatchQueue* mq = slots_[matchId].queue.load(std::memory_order_acquire);
+    return mq ? queuedInputs(*mq) : 0;
+}
+
+size_t GameServer::getDrainQuantum(int matchId) const {
+    if (!adaptiveDrain_ || matchId < 0 || matchId >= numMatches_) return 0;
+    const MatchQueue* mq = slots_[matchId].queue.load(std::memory_order_acquire);
+    return mq ? mq->drainControl.size() : 0;
+}
+
+BatchControlStats GameServer::getDrainControlStats() const {
+    std::lock_guard<std::mutex> lock(lifecycleMutex_);
+    BatchControlStats stats;
+    if (!adaptiveDrain_) return stats;
+    for (const auto& mq : queueStorage_) {
+        stats.merge(mq->drainControl.stats());
+    }
+    return stats;
+}
+
+size_t GameServer::getScheduledTaskCount() const {
+    return scheduledTasks_.load(std::memory_order_relaxed);
+}
+
 bool GameServer::isAllProcessed() const {
     return getPendingCount() == 0;
 }
@@ -123,12 +814,19 @@ int GameServer::getNumMatches() const {
 }
 
 void GameServer::clearInputs() {
-    for (const auto& mq : matchQueues_) {
-        std::lock_guard<std::mutex> lock(mq->mutex);
-        std::queue<Input> empty;
-        std::swap(mq->queue, empty);
+    // Acts as the consumer of every queue: no processPending() may run concurrently
+    std::lock_guard<std::mutex> lock(lifecycleMutex_);
+    for (const auto& mq : queueStorage_) {
+        mq->ring.drain([](PackedInput) {});
+        for (auto& ring : mq->players) {
+            if (ring) {
+                ring->drain([](PackedInput) {});
+            }
+        }
     }
     processedCount_.store(0, std::memory_order_relaxed);
+    droppedCount_.store(0, std::memory_order_relaxed);
+    pendingInputs_.store(0, std::memory_order_relaxed);
 }
 
 } // namespace para
\ No newline at end of file
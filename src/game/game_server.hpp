@@ -1,26 +1,123 @@
 #ifndef GAME_SERVER_HPP
 #define GAME_SERVER_HPP
 
-#include "match.hpp"
+#include "any_match.hpp"
 #include "../common/types.hpp"
 #include "../common/data_structures.hpp"
+#include "../common/mpsc_ring.hpp"
+#include "../common/adaptive_batch.hpp"
+#include "../common/buffer_pool.hpp"
+#include "../common/spsc_ring.hpp"
 #include "../scheduler/thread_pool.hpp"
+#include <array>
 #include <vector>
-#include <queue>
-#include <mutex>
 #include <atomic>
+#include <chrono>
+#include <functional>
+#include <deque>
 #include <memory>
+#include <mutex>
+#include <utility>
 
 namespace para {
 
+class InputTraceRecorder;
+
+/**
+ * Results of GameServer::runTickLoop()
+ *
+ * Tick latency is measured from a tick's scheduled start to the moment
+ * its last match has published state; a tick misses its deadline when
+ * that takes longer than one tick period.
+ */
+struct TickLoopStats {
+    size_t ticks = 0;
+    size_t missedDeadlines = 0;
+    size_t matchOverruns = 0;              // Match tasks that finished past the deadline
+    int rollbacks = 0;                     // Rollbacks performed during the loop
+    size_t stormTicks = 0;                 // Rollback storms: ticks with a replay pass
+    size_t stormReplays = 0;               // Matches replayed in those passes
+    double p50Ms = 0.0;
+    double p99Ms = 0.0;
+    double p999Ms = 0.0;
+    double maxMs = 0.0;
+    std::vector<size_t> overrunsPerMatch;  // Indexed by matchId
+};
+
+/**
+ * MatchHandle - Generational reference to a match in a GameServer
+ *
+ * slot is the matchId inputs carry; key also encodes the slot's
+ * generation, so a handle goes stale once its match ends, even after the
+ * slot has been reused by a new match.
+ */
+struct MatchHandle {
+    int slot = -1;
+    uint32_t key = 0;
+    
+    bool isNull() const { return slot < 0; }
+};
+
 /**
  * GameServer - Manages multiple matches and input routing
  * 
  * Supports both sequential and parallel processing modes
+ *
+ * Inputs are queued in their 4-byte PackedInput form, so a server (shard)
+ * holds at most PackedInput::MAX_MATCHES matches.
+ *
+ * Each match has a lock-free MPSC input ring: any thread may call
+ * receiveInput(), but processPending() for a given match must only run on
+ * one thread at a time (its single consumer).
+ *
+ * With enableEventScheduling(), the server drives the ThreadPool itself:
+ * a match is submitted exactly once when its queue goes from empty to
+ * non-empty (guarded by a per-match "scheduled" flag), and is not
+ * resubmitted while its queue stays empty.
+ *
+ * With enableDirectInput(), every (match, player) also gets a dedicated
+ * SPSC ring: that player's client writes into reserved slots and the
+ * match reads them in place, with no intermediate copies.
+ *
+ * Matches live in a fixed slot map (maxMatches slots, never reallocated):
+ * createMatch() and endMatch() change it at runtime under a lifecycle lock
+ * that routing never takes. Routing reads the slot's state word (one
+ * acquire load) and drops inputs for slots without a live match. An ended
+ * match is retired by its owner (its next processing task), which discards
+ * its queued inputs and returns the Match, snapshots and history buffers
+ * included, to a free list for the next createMatch(). A slot keeps its
+ * queue forever. PackedInput has no room for a generation: an input
+ * already being routed while its match ends and its slot is reused may
+ * reach the new match.
+ *
+ * Each slot holds an AnyMatch: matches of different game modes (a
+ * GameConfig each, e.g. 1v1 and 2v2) run side by side. A drain dispatches
+ * on the match's mode once and then processes its inputs on the
+ * specialized BasicMatch<Config>; pooled matches are reused per mode.
+ *
+ * processPending() normally takes everything queued. With
+ * enableAdaptiveDrain() each call takes at most the match's current drain
+ * quantum, which an AdaptiveBatchController grows while capped drains stay
+ * within the latency target and halves when one overruns it; the rest
+ * waits for the match's next task, behind the other matches' work.
+ *
+ * In rollback-storm mode (setRollbackStormMode()) matches defer the
+ * rollbacks late inputs cause, so a drain replays at most once however
+ * many of its inputs were late. The tick loop and processAllParallel()
+ * drain every match first, then replay the matches left holding a
+ * rollback in one ThreadPool::parallelFor(), longest replay first, so a
+ * burst of late inputs across many matches spreads over every worker.
+ * Other paths replay at the end of each drain.
  */
 class GameServer {
 public:
-    explicit GameServer(int numMatches = NUM_MATCHES);
+    using PlayerRing = SpscRing<PackedInput>;
+    
+    // numMatches live matches in slots 0..numMatches-1, room for
+    // max(numMatches, maxMatches) in total
+    explicit GameServer(int numMatches = NUM_MATCHES,
+                        size_t queueCapacity = MATCH_QUEUE_CAPACITY,
+                        int maxMatches = 0);
     ~GameServer() = default;
     
     GameServer(const GameServer&) = delete;
@@ -28,44 +125,278 @@ public:
     
     void start();
     
+    // Schedule match processing on pool whenever inputs arrive
+    // Call before any input is received; the pool must outlive the server's use
+    void enableEventScheduling(ThreadPool& pool);
+    
+    // Ticks between every match's demo rollbacks (0: none). Before start()
+    void setRollbackInterval(int ticks);
+    
+    // Every match's Match::setSnapshotPolicy(). Before start()
+    void setSnapshotPolicy(SnapshotPolicy policy);
+    
+    // Desync checks: hook gets every match's final SYNC_TICK hashes, on
+    // the thread processing that match (empty: off). Before start()
+    void setSyncHook(SyncHook hook);
+    
+    // Cap every processPending() call at an adaptive per-match quantum
+    // Call before any input is received
+    void enableAdaptiveDrain(const BatchTargets& targets = BatchTargets());
+    
+    // Defer late-input rollbacks and replay them in storm passes (see
+    // above). Before any input is received
+    void setRollbackStormMode(bool enabled);
+    
+    // Record everything receiveInput(s) accepts from now on (nullptr: stop)
+    // The recorder must outlive its use; direct-path inputs are not seen
+    void setTraceRecorder(InputTraceRecorder* recorder);
+    
+    // Create a match of mode in a free slot (any thread). It starts right
+    // away if the server has been started. Null handle if every slot is
+    // in use. The constructor's initial matches are DUEL matches
+    MatchHandle createMatch(GameMode mode = GameMode::DUEL);
+    
+    // End a live match (any thread); false if the handle is stale. Without
+    // event scheduling the match is retired at once, so call this only
+    // while no processing call is running (e.g. from onTickStart)
+    bool endMatch(MatchHandle handle);
+    
+    // The match is still the one the handle was created for
+    bool isLive(MatchHandle handle) const;
+    
+    // Handle of the match currently live in a slot (null if none)
+    MatchHandle getMatchHandle(int slot) const;
+    
+    int getActiveMatchCount() const;
+    
+    // Match objects ever allocated (live plus pooled)
+    size_t getAllocatedMatchCount() const;
+    
     // Receive input and dispatch to correct match queue
+    // Inputs that do not fit in a full match queue, or whose match is not
+    // live, are dropped and counted
     void receiveInput(const Input& input);
+    void receiveInput(PackedInput input);
+    
+    // Receive a batch: grouped by match (counting sort), one ring
+    // reservation per match instead of one per input
+    void receiveInputs(const PackedInput* inputs, size_t count);
+    void receiveInputs(const std::vector<PackedInput>& inputs);
+    
+    // Same, taking ownership of the batch (left empty)
+    void receiveInputs(std::vector<PackedInput>&& inputs);
+    
+    // Same, for a pooled batch: the rings copy the inputs in, so the
+    // buffer is returned to its pool as soon as it has been routed
+    void receiveInputs(InputBatch&& batch);
     
-    // Receive multiple inputs
-    void receiveInputs(const std::vector<Input>& inputs);
+    // Topology-aware input path: one SPSC ring per (match, player)
+    // Call before any input is received
+    void enableDirectInput(size_t ringCapacity = PLAYER_RING_CAPACITY);
     
-    // Process pending inputs for a specific match
+    // Ring a player's client writes into; nullptr if direct input is off
+    // Each ring must have exactly one producer at a time
+    PlayerRing* getPlayerRing(int matchId, int playerId);
+    
+    // Account for count inputs just committed to one of matchId's player
+    // rings and schedule the match (call from the producer after commit)
+    void notifyInputs(int matchId, size_t count);
+    
+    // Process pending inputs for a specific match (at most one drain
+    // quantum of them with adaptive drain)
     void processPending(int matchId);
     
     // Legacy support: Process all inputs SEQUENTIALLY
     void processAllSequential();
     
-    // Legacy support: Process all inputs in PARALLEL
+    // Legacy support: Process all inputs in PARALLEL (one TaskGroup of
+    // match tasks that the caller helps run, so other work on pool is
+    // not waited for)
     void processAllParallel(ThreadPool& pool);
     
+    // Real-time mode: every 1/hz seconds for duration, drain each match's
+    // inputs (one quantum per tick with adaptive drain), simulate it up to
+    // the current tick on pool (missing inputs' deadline has passed) and
+    // publish its state. Each tick's match tasks form one TaskGroup.
+    // onTickStart(tick), if given, runs at the start of each tick, e.g. to
+    // feed inputs. Requires event scheduling to be off (the loop is the
+    // only consumer)
+    TickLoopStats runTickLoop(ThreadPool& pool, int hz, std::chrono::milliseconds duration,
+                              const std::function<void(int)>& onTickStart = {});
+    
     void processSingleInput(const Input& input);
     
     size_t getProcessedCount() const;
     int getTotalRollbackCount() const;
     
-    // Get total pending count across all queues
+    // Inputs that arrived after their tick was simulated, across all matches
+    int getTotalLateInputCount() const;
+    
+    // Inputs that arrived too late for any rollback, across all matches
+    int getTotalExpiredInputCount() const;
+    
+    // Last published simulated tick of a match (any thread)
+    int getMatchTick(int matchId) const;
+    
+    // Last published state of a DUEL match (any thread); a default
+    // MatchState for other modes
+    MatchState getMatchState(int matchId) const;
+    
+    // Last published state of a match of Config's mode (any thread);
+    // false if the slot holds no such match
+    template<typename Config>
+    bool getMatchState(int matchId, BasicMatchState<Config>& out) const {
+        if (matchId < 0 || matchId >= numMatches_) return false;
+        const AnyMatch* match = currentMatch(matchId);
+        const BasicMatch<Config>* typed = match ? match->get<Config>() : nullptr;
+        if (!typed) return false;
+        out = typed->getState();
+        return true;
+    }
+    
+    // Game mode of a slot's live or ended match (DUEL if none)
+    GameMode getMatchMode(int matchId) const;
+    
+    // Inputs rejected because their match queue was full or their match
+    // was not live (including those discarded when a match ended)
+    size_t getDroppedCount() const;
+    
+    // Get total pending count across all queues (one counter, no scan)
     size_t getPendingCount() const;
     
+    // Inputs queued for one match, all rings (approximate, any thread)
+    size_t getQueueDepth(int matchId) const;
+    
+    // A match's current drain quantum (0: adaptive drain off)
+    size_t getDrainQuantum(int matchId) const;
+    
+    // Every slot's drain decisions, merged
+    BatchControlStats getDrainControlStats() const;
+    
+    // Number of match tasks submitted by event scheduling (for statistics)
+    size_t getScheduledTaskCount() const;
+    
     bool isAllProcessed() const;
+    
+    // Slot count: valid match ids are 0..getNumMatches()-1
     int getNumMatches() const;
     void clearInputs();
 
 private:
-    struct MatchQueue {
-        std::queue<Input> queue;
-        std::mutex mutex;
+    // Padded so neighbouring matches' queues never share a cache line
+    struct alignas(64) MatchQueue {
+        explicit MatchQueue(size_t capacity) : ring(capacity) {}
+        
+        MpscRing<PackedInput> ring;
+        
+        // Direct input path (enableDirectInput()), one ring per seat of the
+        // largest mode. Filled before any drain can run, then never changed
+        std::array<std::unique_ptr<PlayerRing>, MAX_PLAYERS_PER_MATCH> players;
+        
+        // Drain quantum (enableAdaptiveDrain()), fed by the consumer
+        AdaptiveBatchController drainControl;
+        
+        // True while a processing task for this match is queued or running
+        alignas(64) std::atomic<bool> scheduled{false};
+        
+#ifdef PARA_ENABLE_METRICS
+        // Enqueue time of the oldest input not yet drained (0: none)
+        std::atomic<uint64_t> oldestEnqueueNs{0};
+#endif
+    };
+
+    // Slot state word: generation << 2 | phase
+    static constexpr uint32_t PHASE_MASK = 3;
+    static constexpr uint32_t SLOT_FREE = 0;
+    static constexpr uint32_t SLOT_LIVE = 1;
+    static constexpr uint32_t SLOT_ENDED = 2;  // Waiting for its owner to retire it
+    
+    // One entry of the match registry; the array never moves
+    struct MatchSlot {
+        std::atomic<uint32_t> state{SLOT_FREE};
+        std::atomic<AnyMatch*> match{nullptr};    // Meaningful unless FREE
+        std::atomic<MatchQueue*> queue{nullptr};  // Allocated on first use, then kept
     };
+    
+    // Queue of a slot whose match is live, else nullptr (lock-free)
+    MatchQueue* liveQueue(int matchId) const;
+    
+    // Match of a live or ended slot, else nullptr
+    AnyMatch* currentMatch(int matchId) const;
+    
+    // createMatch() without taking the lifecycle lock
+    MatchHandle createMatchLocked(GameMode mode);
+    
+    // Player rings for every seat mq lacks (direct input on)
+    void addPlayerRings(MatchQueue& mq);
+    
+    // Owner of an ended match: discard its inputs, recycle match and slot
+    void retireMatch(int matchId, AnyMatch* match);
+    
+    // Drop everything queued for a slot (caller is its consumer)
+    void discardQueued(MatchQueue& mq);
+    
+    // processPending(); with holdRollbacks, a deferred rollback is left for
+    // the caller's storm pass instead of being replayed here
+    void drainPending(int matchId, bool holdRollbacks);
+    
+    // Matches holding a deferred rollback, longest replay first, as
+    // (replay ticks, matchId). Only while no match is being processed
+    void collectRollbackStorm(std::vector<std::pair<int, int>>& storm) const;
+    
+    // Append one match's contiguous group of inputs with a single reservation
+    void enqueueGroup(int matchId, const PackedInput* inputs, size_t count);
+    
+    // Stamp the queue's oldest-input time if unset (metrics builds only)
+    void noteEnqueued(MatchQueue& mq);
+    
+    // Submit the match's processing task unless one is already pending
+    void scheduleMatch(int matchId);
+    
+    // Body of a scheduled match task: drain, release the flag, re-check
+    void runScheduledMatch(int matchId);
+    
+    // Shared ring or any player ring has inputs
+    bool hasQueuedInputs(const MatchQueue& mq) const;
+    
+    // Inputs in the shared ring and every player ring
+    size_t queuedInputs(const MatchQueue& mq) const;
+    
+    // processAllParallel() task: drain, and go again while capped drains
+    // leave inputs behind
+    void submitDrain(TaskGroup& group, int matchId);
 
-    std::vector<std::unique_ptr<Match>> matches_;
-    std::vector<std::unique_ptr<MatchQueue>> matchQueues_;
+    std::unique_ptr<MatchSlot[]> slots_;
+    
+    // Lifecycle state, only touched under lifecycleMutex_
+    mutable std::mutex lifecycleMutex_;
+    std::vector<std::unique_ptr<AnyMatch>> matchStorage_;  // Every match ever allocated
+    std::vector<std::unique_ptr<MatchQueue>> queueStorage_;
+    std::array<std::vector<AnyMatch*>, GAME_MODES> freeMatches_;  // Per GameMode
+    std::deque<int> freeSlots_;                 // FIFO: a slot rests before reuse
+    size_t queueCapacity_;
+    size_t playerRingCapacity_ = 0;             // 0: direct input off
+    int rollbackInterval_ = ROLLBACK_INTERVAL;
+    SnapshotPolicy snapshotPolicy_ = SnapshotPolicy::FULL;
+    SyncHook syncHook_;                         // Shared by every match
+    bool started_ = false;
+    BatchTargets drainTargets_;
+    bool adaptiveDrain_ = false;
+    bool rollbackStorms_ = false;
+    
+    std::atomic<int> activeMatches_{0};
+    std::atomic<int> retiredRollbacks_{0};      // Counters of matches already recycled
+    std::atomic<int> retiredLateInputs_{0};
+    std::atomic<int> retiredExpiredInputs_{0};
     
     std::atomic<size_t> processedCount_{0};
-    int numMatches_;
+    std::atomic<size_t> droppedCount_{0};
+    std::atomic<size_t> pendingInputs_{0};     // Accepted but not yet processed
+    std::atomic<size_t> scheduledTasks_{0};
+    
+    ThreadPool* pool_ = nullptr;
+    InputTraceRecorder* recorder_ = nullptr;
+    int numMatches_;                            // Slot count
 };
 
 } // namespace para
@@ -0,0 +1,134 @@
+#include "input_history.hpp"
+#include <utility>
+
+namespace para {
+
+InputHistory::InputHistory(size_t initialTicks) {
+    size_t capacity = 2;
+    while (capacity < initialTicks) {
+        capacity <<= 1;
+    }
+    buckets_.resize(capacity);
+    mask_ = capacity - 1;
+    reserveBuckets(buckets_);
+}
+
+bool InputHistory::record(int tick, PackedInput input) {
+    if (tick < baseTick_) {
+        // Older than every retained snapshot: can never be replayed
+        return false;
+    }
+
+    int newEnd = tick >= endTick_ ? tick + 1 : endTick_;
+    size_t span = static_cast<size_t>(newEnd - baseTick_);
+    if (span > MAX_TICKS) return false;
+    if (span > buckets_.size()) {
+        grow(span);
+    }
+
+    Bucket& bucket = bucketFor(tick);
+    if (bucket.tick != tick) {
+        // Stale bucket from an earlier lap of the ring
+        bucket.tick = tick;
+        bucket.inputs.clear();
+    }
+    bucket.inputs.push_back(input);
+
+    endTick_ = newEnd;
+    ++count_;
+    return true;
+}
+
+void InputHistory::discardBefore(int tick) {
+    if (tick <= baseTick_) return;
+
+    int limit = tick < endTick_ ? tick : endTick_;
+    for (int t = baseTick_; t < limit; ++t) {
+        Bucket& bucket = bucketFor(t);
+        if (bucket.tick == t) {
+            count_ -= bucket.inputs.size();
+            bucket.inputs.clear();
+            bucket.tick = -1;
+        }
+    }
+
+    baseTick_ = tick;
+    if (endTick_ < baseTick_) {
+        endTick_ = baseTick_;
+    }
+}
+
+void InputHistory::clear() {
+    for (auto& bucket : buckets_) {
+        bucket.tick = -1;
+        bucket.inputs.clear();
+    }
+    baseTick_ = 0;
+    endTick_ = 0;
+    count_ = 0;
+}
+
+bool InputHistory::empty() const {
+    return count_ == 0;
+}
+
+size_t InputHistory::size() const {
+    return count_;
+}
+
+int InputHistory::getBaseTick() const {
+    return baseTick_;
+}
+
+int InputHistory::getEndTick() const {
+    return endTick_;
+}
+
+size_t InputHistory::getCapacity() const {
+    return buckets_.size();
+}
+
+void InputHistory::grow(size_t minTicks) {
+    size_t capacity = buckets_.size();
+    while (capacity < minTicks) {
+        capacity <<= 1;
+    }
+
+    std::vector<Bucket> bigger(capacity);
+    size_t newMask = capacity - 1;
+    for (int t = baseTick_; t < endTick_; ++t) {
+        Bucket& bucket = bucketFor(t);
+        if (bucket.tick == t) {
+            bigger[static_cast<size_t>(t) & newMask] = std::move(bucket);
+        }
+    }
+
+    // Hand the storage of the remaining old buckets to empty new slots,
+    // then reserve the rest: a bigger ring never gives capacity back
+    size_t slot = 0;
+    for (auto& bucket : buckets_) {
+        if (bucket.inputs.capacity() == 0) continue;
+        while (slot < capacity && bigger[slot].inputs.capacity() != 0) {
+            ++slot;
+        }
+        if (slot == capacity) break;
+        bucket.inputs.clear();
+        bigger[slot].inputs = std::move(bucket.inputs);
+    }
+    reserveBuckets(bigger);
+
+    buckets_ = std::move(bigger);
+    mask_ = newMask;
+}
+
+void InputHistory::reserveBuckets(std::vector<Bucket>& buckets) {
+    // Storage for the usual inputs per tick, so record() allocates only for
+    // crowded ticks and a ring that stopped growing allocates nothing
+    for (auto& bucket : buckets) {
+        if (bucket.inputs.capacity() == 0) {
+            bucket.inputs.reserve(INPUTS_PER_TICK_HINT);
+        }
+    }
+}
+
+} // namespace para
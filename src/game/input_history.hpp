@@ -0,0 +1,121 @@
+#ifndef INPUT_HISTORY_HPP
+#define INPUT_HISTORY_HPP
+
+#include "../common/types.hpp"
+#include "../common/data_structures.hpp"
+#include <vector>
+#include <cstddef>
+
+namespace para {
+
+/**
+ * InputHistory - Inputs indexed by tickId for rollback re-simulation
+ *
+ * A growable ring of per-tick buckets covering [baseTick, endTick).
+ * Replaying a tick window touches only the buckets in that window instead
+ * of scanning every input ever received. Inputs older than the oldest
+ * retained snapshot can never be replayed, so the Match discards them with
+ * discardBefore() and the ring stays at roughly the snapshot window size.
+ *
+ * Inputs are stored packed (4 bytes each); the bucket carries the full tick.
+ * Within a tick, inputs are kept in arrival order.
+ */
+class InputHistory {
+public:
+    // Bucket storage reserved per tick: one input from each of two players
+    static constexpr size_t INPUTS_PER_TICK_HINT = 2;
+
+    // Ring size limit: the snapshot window plus the furthest accepted lead
+    static constexpr size_t MAX_TICKS = 512;
+    static_assert(MAX_ROLLBACK_TICKS + ROLLBACK_INTERVAL + MAX_INPUT_LEAD_TICKS < static_cast<int>(MAX_TICKS),
+                  "InputHistory::MAX_TICKS must cover the rollback window and the input lead");
+
+    explicit InputHistory(size_t initialTicks = 64);
+
+    /**
+     * Record an input for tick. Inputs older than the retained window, or
+     * that would stretch it past MAX_TICKS, are dropped; returns false for those
+     */
+    bool record(int tick, PackedInput input);
+
+    /**
+     * Visit every input with fromTick <= tickId <= toTick, in tick order
+     */
+    template<typename Fn>
+    void forEachInRange(int fromTick, int toTick, Fn&& fn) const {
+        if (fromTick < baseTick_) fromTick = baseTick_;
+        if (toTick >= endTick_) toTick = endTick_ - 1;
+
+        for (int tick = fromTick; tick <= toTick; ++tick) {
+            const Bucket& bucket = bucketFor(tick);
+            if (bucket.tick != tick) continue;
+            for (PackedInput input : bucket.inputs) {
+                fn(input);
+            }
+        }
+    }
+
+    /**
+     * Bit p is set if player p has an input recorded for tick
+     */
+    uint32_t playerMaskAt(int tick) const {
+        if (tick < baseTick_ || tick >= endTick_) return 0;
+        const Bucket& bucket = bucketFor(tick);
+        if (bucket.tick != tick) return 0;
+
+        uint32_t mask = 0;
+        for (PackedInput input : bucket.inputs) {
+            mask |= 1u << input.playerId();
+        }
+        return mask;
+    }
+
+    /**
+     * Drop all inputs with tickId < tick
+     */
+    void discardBefore(int tick);
+
+    /**
+     * Remove everything (keeps bucket capacity)
+     */
+    void clear();
+
+    bool empty() const;
+    size_t size() const;
+
+    int getBaseTick() const;
+    int getEndTick() const;
+
+    /**
+     * Number of tick buckets currently allocated
+     */
+    size_t getCapacity() const;
+
+private:
+    struct Bucket {
+        int tick = -1;
+        std::vector<PackedInput> inputs;
+    };
+
+    Bucket& bucketFor(int tick) {
+        return buckets_[static_cast<size_t>(tick) & mask_];
+    }
+
+    const Bucket& bucketFor(int tick) const {
+        return buckets_[static_cast<size_t>(tick) & mask_];
+    }
+
+    void grow(size_t minTicks);
+    static void reserveBuckets(std::vector<Bucket>& buckets);
+
+private:
+    std::vector<Bucket> buckets_;
+    size_t mask_;
+    int baseTick_ = 0;   // Oldest tick still retained
+    int endTick_ = 0;    // One past the newest recorded tick
+    size_t count_ = 0;
+};
+
+} // namespace para
+
+#endif // INPUT_HISTORY_HPP
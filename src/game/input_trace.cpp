@@ -0,0 +1,145 @@
+#include "input_trace.hpp"
+#include "game_server.hpp"
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+#include <thread>
+
+namespace para {
+
+namespace {
+
+const char TRACE_MAGIC[8] = {'P', 'A', 'R', 'A', 'T', 'R', 'C', '1'};
+
+void layoutTrace(TraceHeader& header) {
+    header.arrivalOffset = sizeof(TraceHeader);
+    header.inputsOffset = (header.arrivalOffset + header.count * sizeof(uint32_t) + 63) & ~uint64_t(63);
+    header.fileSize = header.inputsOffset + header.count * sizeof(PackedInput);
+}
+
+} // namespace
+
+// ============================================
+// InputTraceRecorder Implementation
+// ============================================
+
+InputTraceRecorder::InputTraceRecorder(int numMatches, size_t expectedInputs)
+    : numMatches_(numMatches)
+{
+    arrivalUs_.reserve(expectedInputs);
+    inputs_.reserve(expectedInputs);
+}
+
+void InputTraceRecorder::record(const PackedInput* inputs, size_t count) {
+    if (count == 0) return;
+    
+    Clock::time_point now = Clock::now();
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (!started_) {
+        start_ = now;
+        started_ = true;
+    }
+    
+    // Timestamps are taken outside the lock: keep them monotonic in file order
+    auto sinceStart = std::chrono::duration_cast<std::chrono::microseconds>(now - start_).count();
+    uint32_t arrival = static_cast<uint32_t>(std::max<long long>(sinceStart, 0));
+    if (!arrivalUs_.empty() && arrival < arrivalUs_.back()) {
+        arrival = arrivalUs_.back();
+    }
+    
+    arrivalUs_.insert(arrivalUs_.end(), count, arrival);
+    inputs_.insert(inputs_.end(), inputs, inputs + count);
+}
+
+size_t InputTraceRecorder::size() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return inputs_.size();
+}
+
+void InputTraceRecorder::save(const std::string& path) const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    
+    TraceHeader header = {};
+    std::memcpy(header.magic, TRACE_MAGIC, sizeof(TRACE_MAGIC));
+    header.version = TraceHeader::VERSION;
+    header.numMatches = static_cast<uint32_t>(numMatches_);
+    header.count = inputs_.size();
+    layoutTrace(header);
+    
+    MappedFile file = MappedFile::create(path, header.fileSize);
+    uint8_t* base = file.data();
+    std::memcpy(base, &header, sizeof(TraceHeader));
+    if (!inputs_.empty()) {
+        std::memcpy(base + header.arrivalOffset, arrivalUs_.data(), arrivalUs_.size() * sizeof(uint32_t));
+        std::memcpy(base + header.inputsOffset, inputs_.data(), inputs_.size() * sizeof(PackedInput));
+    }
+    file.flush();
+}
+
+// ============================================
+// InputTraceReplayer Implementation
+// ============================================
+
+InputTraceReplayer::InputTraceReplayer(const std::string& path)
+    : file_(MappedFile::open(path))
+{
+    if (file_.size() < sizeof(TraceHeader)) {
+        throw std::runtime_error("InputTraceReplayer: file too small: " + path);
+    }
+    const TraceHeader& stored = header();
+    if (std::memcmp(stored.magic, TRACE_MAGIC, sizeof(TRACE_MAGIC)) != 0 || stored.version != TraceHeader::VERSION) {
+        throw std::runtime_error("InputTraceReplayer: not an input trace: " + path);
+    }
+    
+    TraceHeader expected = stored;
+    layoutTrace(expected);
+    if (expected.inputsOffset != stored.inputsOffset || expected.fileSize != stored.fileSize ||
+        stored.fileSize > file_.size()) {
+        throw std::runtime_error("InputTraceReplayer: truncated or inconsistent trace: " + path);
+    }
+}
+
+TraceReplayStats InputTraceReplayer::replay(GameServer& server, double speed) const {
+    using Clock = std::chrono::steady_clock;
+    
+    if (numMatches() > server.getNumMatches()) {
+        throw std::invalid_argument("InputTraceReplayer: trace has more matches than the server");
+    }
+    
+    TraceReplayStats stats;
+    const PackedInput* wire = inputs();
+    const uint32_t* arrival = arrivalUs();
+    size_t count = size();
+    
+    Clock::time_point start = Clock::now();
+    size_t begin = 0;
+    while (begin < count) {
+        // One slice: every input recorded at the same instant
+        size_t end = begin + 1;
+        while (end < count && arrival[end] == arrival[begin]) {
+            ++end;
+        }
+    
+        if (speed > 0.0) {
+            auto due = start + std::chrono::duration_cast<Clock::duration>(
+                std::chrono::duration<double, std::micro>(arrival[begin] / speed));
+            Clock::time_point now = Clock::now();
+            if (due > now) {
+                std::this_thread::sleep_until(due);
+            } else {
+                double lagMs = std::chrono::duration<double, std::milli>(now - due).count();
+                stats.maxLagMs = std::max(stats.maxLagMs, lagMs);
+            }
+        }
+    
+        server.receiveInputs(wire + begin, end - begin);
+        stats.inputs += end - begin;
+        ++stats.slices;
+        begin = end;
+    }
+    
+    stats.elapsedMs = std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+    return stats;
+}
+
+} // namespace para
@@ -0,0 +1,125 @@
+#ifndef INPUT_TRACE_HPP
+#define INPUT_TRACE_HPP
+
+#include "../common/data_structures.hpp"
+#include "../common/mapped_file.hpp"
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace para {
+
+class GameServer;
+
+/**
+ * Input trace file format (native byte order)
+ *
+ *   TraceHeader
+ *   uint32 arrivalUs[count]        microseconds since the first recorded input
+ *   PackedInput inputs[count]      64-byte aligned, in arrival order
+ *
+ * Inputs are stored exactly as GameServer received them (wire form), so a
+ * replay can hand slices of the mapped array straight to receiveInputs().
+ */
+struct TraceHeader {
+    static constexpr uint32_t VERSION = 2;   // 2: PackedInput with a 2-bit player id
+    
+    char magic[8];
+    uint32_t version;
+    uint32_t numMatches;
+    uint64_t count;
+    uint64_t arrivalOffset;
+    uint64_t inputsOffset;
+    uint64_t fileSize;
+};
+
+/**
+ * InputTraceRecorder - Captures what GameServer::receiveInput(s) accepts
+ *
+ * Attach with GameServer::setTraceRecorder(). record() may be called from
+ * any thread (it takes a lock: recording is a capture mode, not the fast
+ * path); save() writes the trace file once recording is over.
+ */
+class InputTraceRecorder {
+public:
+    explicit InputTraceRecorder(int numMatches, size_t expectedInputs = 0);
+    
+    /**
+     * Append inputs that arrived now, in order (any thread)
+     */
+    void record(const PackedInput* inputs, size_t count);
+    
+    size_t size() const;
+    
+    /**
+     * Write the trace to path. Throws std::runtime_error on I/O failure
+     */
+    void save(const std::string& path) const;
+
+private:
+    using Clock = std::chrono::steady_clock;
+    
+    int numMatches_;
+    mutable std::mutex mutex_;
+    bool started_ = false;
+    Clock::time_point start_;
+    std::vector<uint32_t> arrivalUs_;
+    std::vector<PackedInput> inputs_;
+};
+
+/**
+ * Results of InputTraceReplayer::replay()
+ */
+struct TraceReplayStats {
+    size_t inputs = 0;
+    size_t slices = 0;        // receiveInputs() calls
+    double elapsedMs = 0.0;
+    double maxLagMs = 0.0;    // Worst delay behind the paced schedule
+};
+
+/**
+ * InputTraceReplayer - Feeds a memory-mapped trace into a GameServer
+ *
+ * Each slice is a run of inputs recorded with the same arrival time, passed
+ * to receiveInputs() straight from the mapping (no copy). Slices are paced
+ * by their arrival times divided by speed: 1 replays at the original
+ * speed, N at N times it, and AS_FAST_AS_POSSIBLE does not wait at all.
+ */
+class InputTraceReplayer {
+public:
+    static constexpr double AS_FAST_AS_POSSIBLE = 0.0;
+    
+    /**
+     * Map the trace at path. Throws std::runtime_error if it is not one
+     */
+    explicit InputTraceReplayer(const std::string& path);
+    
+    /**
+     * Send the whole trace to server (from the calling thread)
+     * Throws std::invalid_argument if the trace has more matches than server
+     */
+    TraceReplayStats replay(GameServer& server, double speed = 1.0) const;
+    
+    size_t size() const { return static_cast<size_t>(header().count); }
+    int numMatches() const { return static_cast<int>(header().numMatches); }
+    double durationMs() const { return size() ? arrivalUs()[size() - 1] / 1000.0 : 0.0; }
+    
+    const PackedInput* inputs() const {
+        return reinterpret_cast<const PackedInput*>(file_.data() + header().inputsOffset);
+    }
+    const uint32_t* arrivalUs() const {
+        return reinterpret_cast<const uint32_t*>(file_.data() + header().arrivalOffset);
+    }
+
+private:
+    const TraceHeader& header() const { return *reinterpret_cast<const TraceHeader*>(file_.data()); }
+    
+    MappedFile file_;
+};
+
+} // namespace para
+
+#endif // INPUT_TRACE_HPP
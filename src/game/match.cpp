@@ -1,180 +1,416 @@
 #include "match.hpp"
+#include "../common/metrics.hpp"
 #include <algorithm>
 
 namespace para {
 
-Match::Match(int matchId) 
+template<typename Config>
+BasicMatch<Config>::BasicMatch(int matchId)
     : state_(matchId)
-    , lastSnapshotTick_(-ROLLBACK_INTERVAL)
+    , published_(state_)
 {
 }
 
-Match::Match(Match&& other) noexcept
+template<typename Config>
+BasicMatch<Config>::BasicMatch(BasicMatch&& other) noexcept
     : state_(std::move(other.state_))
     , snapshots_(std::move(other.snapshots_))
     , inputHistory_(std::move(other.inputHistory_))
+    , tickHashes_(other.tickHashes_)
+    , published_(other.published_.load())
     , rollbackCount_(other.rollbackCount_.load())
-    , lastSnapshotTick_(other.lastSnapshotTick_)
+    , lateInputCount_(other.lateInputCount_.load())
+    , expiredInputCount_(other.expiredInputCount_.load())
+    , requestedRollbackTick_(other.requestedRollbackTick_.load())
+    , newestInputTick_(other.newestInputTick_)
+    , rollbackInterval_(other.rollbackInterval_)
+    , syncHook_(other.syncHook_)
+    , nextSyncTick_(other.nextSyncTick_)
+    , deferredRollbackTick_(other.deferredRollbackTick_)
+    , deferRollbacks_(other.deferRollbacks_)
 {
 }
 
-Match& Match::operator=(Match&& other) noexcept {
+template<typename Config>
+BasicMatch<Config>& BasicMatch<Config>::operator=(BasicMatch&& other) noexcept {
     if (this != &other) {
-        std::lock_guard<std::mutex> lock(mutex_);
         state_ = std::move(other.state_);
         snapshots_ = std::move(other.snapshots_);
         inputHistory_ = std::move(other.inputHistory_);
+        tickHashes_ = other.tickHashes_;
+        published_.store(other.published_.load());
         rollbackCount_.store(other.rollbackCount_.load());
-        lastSnapshotTick_ = other.lastSnapshotTick_;
+        lateInputCount_.store(other.lateInputCount_.load());
+        expiredInputCount_.store(other.expiredInputCount_.load());
+        requestedRollbackTick_.store(other.requestedRollbackTick_.load());
+        newestInputTick_ = other.newestInputTick_;
+        rollbackInterval_ = other.rollbackInterval_;
+        syncHook_ = other.syncHook_;
+        nextSyncTick_ = other.nextSyncTick_;
+        deferredRollbackTick_ = other.deferredRollbackTick_;
+        deferRollbacks_ = other.deferRollbacks_;
     }
     return *this;
 }
 
-void Match::start() {
-    std::lock_guard<std::mutex> lock(mutex_);
+template<typename Config>
+void BasicMatch<Config>::reset(int matchId) {
+    state_ = State(matchId);
+    snapshots_.clear();
+    inputHistory_.clear();
+    tickHashes_.clear();
+    published_.store(state_);
+    rollbackCount_.store(0, std::memory_order_relaxed);
+    lateInputCount_.store(0, std::memory_order_relaxed);
+    expiredInputCount_.store(0, std::memory_order_relaxed);
+    requestedRollbackTick_.store(NO_ROLLBACK_REQUEST, std::memory_order_relaxed);
+    newestInputTick_ = 0;
+    rollbackInterval_ = ROLLBACK_INTERVAL;
+    syncHook_ = nullptr;
+    nextSyncTick_ = SYNC_TICK_INTERVAL;
+    deferredRollbackTick_ = NO_ROLLBACK_REQUEST;
+    deferRollbacks_ = false;
+}
+
+template<typename Config>
+void BasicMatch<Config>::start() {
     state_.isRunning = true;
     state_.currentTick = 0;
+    tickHashes_.record(0, state_.syncHash);
     
-    // Save initial snapshot
+    // Save initial snapshot (keeps later snapshots aligned to the interval)
     saveSnapshot();
+    
+    publishState();
 }
 
-void Match::processInput(const Input& input) {
-    std::lock_guard<std::mutex> lock(mutex_);
-    
+template<typename Config>
+void BasicMatch<Config>::processInput(const Input& input) {
+    processInputAt(input.tickId, PackedInput::pack(input, input.matchId));
+}
+
+template<typename Config>
+void BasicMatch<Config>::processInput(PackedInput input) {
+    // Wire ticks wrap at 16 bits: resolve against the newest tick seen so far
+    processInputAt(PackedInput::unwrapTick(input.wrappedTick(), newestInputTick_), input);
+}
+
+template<typename Config>
+bool BasicMatch<Config>::forcesDeadline(PackedInput input) const {
+    int tick = PackedInput::unwrapTick(input.wrappedTick(), newestInputTick_);
+    return tick - state_.currentTick > INPUT_DEADLINE_TICKS;
+}
+
+template<typename Config>
+void BasicMatch<Config>::processInputAt(int tick, PackedInput input) {
     if (!state_.isRunning) return;
     
-    // Store input in history
-    inputHistory_.push_back(input);
+    // Not a seat in this mode (folds away when every player id is one)
+    if (input.playerId() >= Config::PLAYERS) return;
+    
+    // Too far ahead to be real traffic (a forged or corrupt wire tick
+    // unwraps up to 32767 ticks on): it would only grow the history
+    if (tick - state_.currentTick > MAX_INPUT_LEAD_TICKS) return;
+    
+    if (tick > newestInputTick_) {
+        newestInputTick_ = tick;
+    }
+    
+    // Store input in history (this is also the timeline of future ticks)
+    if (!inputHistory_.record(tick, input)) {
+        // Older than the oldest snapshot: no rollback can apply it any more
+        expiredInputCount_.store(expiredInputCount_.load(std::memory_order_relaxed) + 1,
+                                 std::memory_order_relaxed);
+        return;
+    }
     
     // Check if this is a late input (needs rollback)
-    if (input.tickId < state_.currentTick) {
-        // Late input - need to rollback
-        rollbackCount_.fetch_add(1, std::memory_order_relaxed);
-        
-        // Find snapshot and re-simulate
-        const Snapshot* snapshot = findSnapshotForTick(input.tickId);
-        if (snapshot) {
-            // Load snapshot state
-            state_ = snapshot->state.clone();
-            
-            // Re-apply all inputs from snapshot tick to current
-            for (const auto& histInput : inputHistory_) {
-                if (histInput.tickId >= snapshot->tickId) {
-                    applyInput(histInput);
-                }
-            }
-        }
-    } else {
-        // Normal input
-        applyInput(input);
+    if (tick < state_.currentTick) {
+        // Its tick was already simulated without it: truly late
+        lateInputCount_.store(lateInputCount_.load(std::memory_order_relaxed) + 1,
+                              std::memory_order_relaxed);
+        requestRollback(tick);
+        return;
+    }
+    
+    // Simulate every tick that is now complete or past its deadline
+    while (isTickReady(state_.currentTick)) {
+        simulateTick();
+    }
+}
+
+template<typename Config>
+void BasicMatch<Config>::advanceTo(int tick) {
+    if (!state_.isRunning) return;
+    
+    while (state_.currentTick < tick) {
+        simulateTick();
+    }
+}
+
+template<typename Config>
+bool BasicMatch<Config>::isTickReady(int tick) const {
+    if (inputHistory_.playerMaskAt(tick) == ALL_PLAYERS_MASK) return true;
+    
+    // Deadline: a player this far ahead means the missing input is late
+    return newestInputTick_ - tick > INPUT_DEADLINE_TICKS;
+}
+
+template<typename Config>
+void BasicMatch<Config>::simulateTick() {
+    if (deferredRollbackTick_ != NO_ROLLBACK_REQUEST &&
+        state_.currentTick - deferredRollbackTick_ >= DEFER_LIMIT_TICKS) {
+        resolveDeferredRollback();
     }
     
+    applyTickInputs(state_.currentTick);
+    
     // Advance tick
     advanceTick();
     
     // Save snapshot every ROLLBACK_INTERVAL ticks
-    if (state_.currentTick - lastSnapshotTick_ >= ROLLBACK_INTERVAL) {
+    if (state_.currentTick % ROLLBACK_INTERVAL == 0) {
         saveSnapshot();
-        lastSnapshotTick_ = state_.currentTick;
-        
-        // Force a demo rollback every 5 ticks as per spec
-        if (state_.currentTick > 0 && !inputHistory_.empty()) {
-            // Simulate a rollback by going back 2 ticks
-            int rollbackTick = std::max(0, state_.currentTick - 2);
-            rollbackCount_.fetch_add(1, std::memory_order_relaxed);
-            
-            const Snapshot* snap = findSnapshotForTick(rollbackTick);
-            if (snap) {
-                state_ = snap->state.clone();
-                // Re-simulate
-                for (const auto& histInput : inputHistory_) {
-                    if (histInput.tickId >= snap->tickId && histInput.tickId <= state_.currentTick) {
-                        applyInput(histInput);
-                    }
-                }
-            }
-        }
+    }
+    
+    // Force a demo rollback every rollbackInterval_ ticks (5 by default, as per spec)
+    // Simulate a rollback by going back 2 ticks
+    if (rollbackInterval_ > 0 && state_.currentTick % rollbackInterval_ == 0) {
+        performRollback(std::max(0, state_.currentTick - 2));
     }
 }
 
-void Match::applyInput(const Input& input) {
-    // Get the player (0 or 1)
-    int playerIdx = input.playerId % 2;
-    PlayerState& player = state_.players[playerIdx];
+template<typename Config>
+void BasicMatch<Config>::setRollbackInterval(int ticks) {
+    rollbackInterval_ = ticks > 0 ? ticks : 0;
+}
+
+template<typename Config>
+void BasicMatch<Config>::setSnapshotPolicy(SnapshotPolicy policy) {
+    snapshots_.setPolicy(policy);
+}
+
+template<typename Config>
+SnapshotPolicy BasicMatch<Config>::getSnapshotPolicy() const {
+    return snapshots_.policy();
+}
+
+template<typename Config>
+size_t BasicMatch<Config>::getSnapshotMemory() const {
+    return snapshots_.memoryBytes();
+}
+
+template<typename Config>
+void BasicMatch<Config>::setSyncHook(const SyncHook* hook) {
+    syncHook_ = hook;
+}
+
+template<typename Config>
+const TickHashHistory& BasicMatch<Config>::getTickHashes() const {
+    return tickHashes_;
+}
+
+template<typename Config>
+void BasicMatch<Config>::applyTickInputs(int tick) {
+    // A move only touches its own player, so the players' interleaving within
+    // a tick cannot change the result; each player's inputs keep their order
+    inputHistory_.forEachInRange(tick, tick, [this](PackedInput input) {
+        applyAction(input.playerId(), input.type());
+    });
+}
+
+template<typename Config>
+void BasicMatch<Config>::applyInput(const Input& input) {
+    // Get the player (a constant modulus: a mask for 2 or 4 players)
+    applyAction(input.playerId % Config::PLAYERS, input.type);
+}
+
+template<typename Config>
+void BasicMatch<Config>::applyAction(int playerIdx, ActionType action) {
+    // Apply movement, clamped to this mode's arena; updates the state hash
+    state_.movePlayer(playerIdx, action);
+}
+
+template<typename Config>
+void BasicMatch<Config>::saveSnapshot() {
+    // Overwrites the bucket that fell out of the SNAPSHOT_DEPTH window
+    snapshots_.save(state_.currentTick, state_);
     
-    // Apply movement
-    player.move(input.type);
+    // Every replay starts at a retained snapshot, so older inputs are dead
+    inputHistory_.discardBefore(snapshots_.oldestTick());
+    reportSyncTicks();
+}
+
+template<typename Config>
+void BasicMatch<Config>::reportSyncTicks() {
+    // No rollback restores further back than the oldest snapshot: ticks up
+    // to it are final, unless a deferred or requested rollback still has to
+    // re-simulate them
+    int finalTick = std::min({snapshots_.oldestTick(), deferredRollbackTick_,
+                              requestedRollbackTick_.load(std::memory_order_relaxed)});
+    while (nextSyncTick_ <= finalTick) {
+        if (syncHook_ && tickHashes_.contains(nextSyncTick_)) {
+            (*syncHook_)(SyncPoint{state_.matchId, nextSyncTick_, tickHashes_.at(nextSyncTick_), &tickHashes_});
+        }
+        nextSyncTick_ += SYNC_TICK_INTERVAL;
+    }
 }
 
-void Match::saveSnapshot() {
-    snapshots_.emplace_back(state_.currentTick, state_);
+template<typename Config>
+void BasicMatch<Config>::rollback(int toTick) {
+    // Queue the request; keep the earliest tick if several are pending
+    int current = requestedRollbackTick_.load(std::memory_order_relaxed);
+    while (toTick < current &&
+           !requestedRollbackTick_.compare_exchange_weak(current, toTick,
+                                                         std::memory_order_release,
+                                                         std::memory_order_relaxed)) {
+    }
+}
+
+template<typename Config>
+void BasicMatch<Config>::applyCommands() {
+    if (requestedRollbackTick_.load(std::memory_order_relaxed) == NO_ROLLBACK_REQUEST) return;
     
-    // Keep only last 10 snapshots to limit memory
-    if (snapshots_.size() > 10) {
-        snapshots_.erase(snapshots_.begin());
+    int toTick = requestedRollbackTick_.exchange(NO_ROLLBACK_REQUEST, std::memory_order_acquire);
+    if (toTick != NO_ROLLBACK_REQUEST) {
+        requestRollback(toTick);
+    }
+}
+
+template<typename Config>
+void BasicMatch<Config>::setDeferRollbacks(bool defer) {
+    deferRollbacks_ = defer;
+    if (!defer) {
+        resolveDeferredRollback();
     }
 }
 
-void Match::rollback(int toTick) {
-    std::lock_guard<std::mutex> lock(mutex_);
+template<typename Config>
+bool BasicMatch<Config>::hasDeferredRollback() const {
+    return deferredRollbackTick_ != NO_ROLLBACK_REQUEST;
+}
+
+template<typename Config>
+int BasicMatch<Config>::getDeferredReplayTicks() const {
+    if (deferredRollbackTick_ == NO_ROLLBACK_REQUEST) return 0;
+    int snapshotTick = snapshots_.findTick(deferredRollbackTick_);
+    return snapshotTick >= 0 ? state_.currentTick - snapshotTick : 0;
+}
+
+template<typename Config>
+void BasicMatch<Config>::resolveDeferredRollback() {
+    if (deferredRollbackTick_ == NO_ROLLBACK_REQUEST) return;
     
-    const Snapshot* snapshot = findSnapshotForTick(toTick);
-    if (!snapshot) return;
+    int toTick = deferredRollbackTick_;
+    deferredRollbackTick_ = NO_ROLLBACK_REQUEST;
+    performRollback(toTick);
+}
+
+template<typename Config>
+void BasicMatch<Config>::requestRollback(int toTick) {
+    if (!deferRollbacks_) {
+        performRollback(toTick);
+        return;
+    }
     
-    rollbackCount_.fetch_add(1, std::memory_order_relaxed);
+    // Replaying from the earliest tick covers every later request too
+    deferredRollbackTick_ = std::min(deferredRollbackTick_, toTick);
+}
+
+template<typename Config>
+void BasicMatch<Config>::performRollback(int toTick) {
+    // Load the latest snapshot at or before toTick
+    int targetTick = state_.currentTick;
+    uint64_t replayStart = metrics::sampledNow();
+    int snapshotTick = snapshots_.restore(toTick, state_);
+    if (snapshotTick < 0) return;
     
-    // Load snapshot
-    state_ = snapshot->state.clone();
+    // Counted only once a snapshot was actually restored
+    countRollback();
+    metrics::add(metrics::Counter::ROLLBACKS);
+    metrics::record(metrics::Histogram::ROLLBACK_REPLAY_TICKS,
+                    static_cast<uint64_t>(targetTick - snapshotTick));
     
     // Re-simulate from snapshot to current
-    int targetTick = state_.currentTick;
-    for (const auto& input : inputHistory_) {
-        if (input.tickId >= snapshot->tickId && input.tickId <= targetTick) {
-            applyInput(input);
-        }
-    }
+    resimulateTo(targetTick);
+    metrics::recordSince(metrics::Histogram::ROLLBACK_REPLAY_NS, replayStart);
 }
 
-const Snapshot* Match::findSnapshotForTick(int tick) const {
-    if (snapshots_.empty()) return nullptr;
-    
-    // Find the snapshot with tickId <= tick
-    const Snapshot* best = nullptr;
-    for (const auto& snap : snapshots_) {
-        if (snap.tickId <= tick) {
-            best = &snap;
-        } else {
-            break;
+template<typename Config>
+void BasicMatch<Config>::publishState() {
+    published_.store(state_);
+}
+
+template<typename Config>
+void BasicMatch<Config>::countRollback() {
+    // Single writer: a plain store avoids a locked RMW on the hot path
+    rollbackCount_.store(rollbackCount_.load(std::memory_order_relaxed) + 1,
+                         std::memory_order_relaxed);
+}
+
+template<typename Config>
+void BasicMatch<Config>::resimulateTo(int targetTick) {
+    while (state_.currentTick < targetTick) {
+        applyTickInputs(state_.currentTick);
+        advanceTick();
+        
+        // Later snapshots may predate a late input: refresh them
+        if (state_.currentTick % ROLLBACK_INTERVAL == 0) {
+            saveSnapshot();
         }
     }
-    
-    return best ? best : &snapshots_.front();
 }
 
-void Match::advanceTick() {
+template<typename Config>
+void BasicMatch<Config>::advanceTick() {
     state_.currentTick++;
+    
+    // Fold the finished tick into the chain (re-simulation rewrites it)
+    state_.syncHash = statehash::chain(state_.syncHash, state_.playerSum);
+    tickHashes_.record(state_.currentTick, state_.syncHash);
 }
 
-int Match::getCurrentTick() const {
-    return state_.currentTick;
+template<typename Config>
+int BasicMatch<Config>::getCurrentTick() const {
+    return published_.load().currentTick;
 }
 
-int Match::getRollbackCount() const {
+template<typename Config>
+int BasicMatch<Config>::getRollbackCount() const {
     return rollbackCount_.load(std::memory_order_relaxed);
 }
 
-int Match::getMatchId() const {
+template<typename Config>
+int BasicMatch<Config>::getLateInputCount() const {
+    return lateInputCount_.load(std::memory_order_relaxed);
+}
+
+template<typename Config>
+int BasicMatch<Config>::getExpiredInputCount() const {
+    return expiredInputCount_.load(std::memory_order_relaxed);
+}
+
+template<typename Config>
+int BasicMatch<Config>::getMatchId() const {
     return state_.matchId;
 }
 
-bool Match::isRunning() const {
-    return state_.isRunning;
+template<typename Config>
+bool BasicMatch<Config>::isRunning() const {
+    return published_.load().isRunning;
 }
 
-MatchState Match::getState() const {
-    std::lock_guard<std::mutex> lock(mutex_);
-    return state_.clone();
+template<typename Config>
+typename BasicMatch<Config>::State BasicMatch<Config>::getState() const {
+    return published_.load();
 }
 
+template<typename Config>
+size_t BasicMatch<Config>::getHistorySize() const {
+    return inputHistory_.size();
+}
+
+template class BasicMatch<DuelConfig>;
+template class BasicMatch<TeamConfig>;
+
 } // namespace para
\ No newline at end of file
@@ -3,61 +3,188 @@
 
 #include "../common/types.hpp"
 #include "../common/data_structures.hpp"
+#include "../common/seqlock.hpp"
+#include "../common/state_hash.hpp"
+#include "input_history.hpp"
+#include "snapshot_store.hpp"
 #include <vector>
-#include <mutex>
 #include <atomic>
 
 namespace para {
 
 /**
- * Match - Represents a single game match
+ * BasicMatch - Represents a single game match of one game mode
  * 
  * Handles:
  * - Processing player inputs
  * - Managing game state
  * - Snapshots for rollback
  * - Rollback and re-simulation
+ *
+ * Inputs are merged into a per-tick timeline: a tick is simulated once,
+ * when every player's input for it has arrived or when some player is
+ * more than INPUT_DEADLINE_TICKS ahead of it (the deadline). Only an input
+ * whose tick was already simulated is late and triggers a rollback, so the
+ * result does not depend on how the players' input streams interleave, as
+ * long as no input expires: one older than the oldest snapshot can no
+ * longer be rolled back in and is discarded (getExpiredInputCount()).
+ *
+ * Single-owner mode: a match is owned by one executor at a time (in the
+ * server, whichever task is currently draining its queue). Only the owner
+ * calls start(), processInput(), applyCommands() and publishState(); that
+ * path takes no locks. Other threads may only:
+ * - read getState() / getCurrentTick() / isRunning(), which return the
+ *   copy last published with publishState() through a seqlock
+ * - call rollback(), which queues a command the owner executes on its
+ *   next applyCommands()
+ *
+ * The state carries an incrementally updated hash (state_hash.hpp): every
+ * tick's value is kept for the recent ticks, and once a multiple of
+ * SYNC_TICK_INTERVAL leaves the rollback window the sync hook, if set,
+ * gets it to compare with the clients' and bisect a desync.
+ *
+ * Config (a GameConfig) fixes the arena and the number of players at
+ * compile time. The modes GameServer hosts are instantiated in match.cpp;
+ * AnyMatch holds a match of any of them.
  */
-class Match {
+template<typename Config>
+class BasicMatch {
 public:
-    explicit Match(int matchId);
+    using GameConfig = Config;
+    using State = BasicMatchState<Config>;
     
-    // Non-copyable (due to mutex)
-    Match(const Match&) = delete;
-    Match& operator=(const Match&) = delete;
+    explicit BasicMatch(int matchId);
     
-    // Movable for container use
-    Match(Match&& other) noexcept;
-    Match& operator=(Match&& other) noexcept;
+    // Non-copyable
+    BasicMatch(const BasicMatch&) = delete;
+    BasicMatch& operator=(const BasicMatch&) = delete;
+    
+    // Movable for container use (owner only, no concurrent readers)
+    BasicMatch(BasicMatch&& other) noexcept;
+    BasicMatch& operator=(BasicMatch&& other) noexcept;
+    
+    /**
+     * Make this a fresh, not yet started match with id matchId, keeping
+     * the snapshot policy and the snapshot and history buffers (for reuse
+     * from a pool). Only while no other thread uses the match
+     */
+    void reset(int matchId);
     
     /**
-     * Start the match
+     * Start the match (owner)
      */
     void start();
     
     /**
-     * Process an input from a client
-     * Will trigger rollback if input is late
+     * Process an input from a client (owner)
+     * Simulates the ticks it completes; rolls back if input is late.
+     * Ignores inputs more than MAX_INPUT_LEAD_TICKS past the current tick
      */
     void processInput(const Input& input);
     
     /**
-     * Apply input directly to state (internal)
+     * Same, for a packed input; its 16-bit tick is resolved against the
+     * newest input tick this match has seen
+     */
+    void processInput(PackedInput input);
+    
+    /**
+     * True if processing input now would run the match past the deadline
+     * of its current tick, i.e. simulate it without inputs still missing
+     * (owner)
+     */
+    bool forcesDeadline(PackedInput input) const;
+    
+    /**
+     * Simulate up to (not including) tick even if inputs are missing (owner)
+     * Real-time deadline: inputs for those ticks that arrive later are late
+     */
+    void advanceTo(int tick);
+    
+    /**
+     * Ticks between the periodic demo rollbacks (0 disables them)
+     * Snapshots are still taken every ROLLBACK_INTERVAL ticks. Owner, before start()
+     */
+    void setRollbackInterval(int ticks);
+    
+    /**
+     * How snapshots are stored (SnapshotPolicy::FULL by default)
+     * Every policy restores the same states. Owner, before start()
+     */
+    void setSnapshotPolicy(SnapshotPolicy policy);
+    
+    SnapshotPolicy getSnapshotPolicy() const;
+    
+    /**
+     * Bytes held by this match's snapshots (owner)
+     */
+    size_t getSnapshotMemory() const;
+    
+    /**
+     * Call *hook with every final SYNC_TICK (nullptr: none); it runs on the
+     * owner's thread and must outlive the match's use. Owner, before start()
+     */
+    void setSyncHook(const SyncHook* hook);
+    
+    /**
+     * State hashes of the recent ticks (owner; any thread can read the
+     * published state's syncHash)
+     */
+    const TickHashHistory& getTickHashes() const;
+    
+    /**
+     * Apply input directly to state (internal; player ids wrap to the mode's seats)
      */
     void applyInput(const Input& input);
     
     /**
-     * Save current state as snapshot
+     * Save current state as snapshot (owner)
      */
     void saveSnapshot();
     
     /**
-     * Rollback to a specific tick and re-simulate
+     * Request a rollback to a specific tick and re-simulation (any thread)
+     * Queued; the owner performs it in applyCommands(). If several requests
+     * arrive before then, the earliest tick wins
      */
     void rollback(int toTick);
     
     /**
-     * Get current tick
+     * Execute queued commands such as rollback requests (owner)
+     */
+    void applyCommands();
+    
+    /**
+     * Defer the rollbacks of late inputs and rollback requests (owner)
+     * Each then only lowers the tick to restore, and one
+     * resolveDeferredRollback() replays once for all of them. A deferred
+     * rollback still resolves itself before its snapshot would leave the
+     * rollback window. Turning deferral off resolves a pending one
+     */
+    void setDeferRollbacks(bool defer);
+    
+    /**
+     * A deferred rollback is waiting to be resolved (owner)
+     */
+    bool hasDeferredRollback() const;
+    
+    /**
+     * Ticks resolveDeferredRollback() would re-simulate, 0 if none (owner)
+     */
+    int getDeferredReplayTicks() const;
+    
+    /**
+     * Perform the deferred rollback, if any (owner)
+     */
+    void resolveDeferredRollback();
+    
+    /**
+     * Publish the current state for getState() readers (owner)
+     */
+    void publishState();
+    
+    /**
+     * Get current tick (as of the last publishState())
      */
     int getCurrentTick() const;
     
@@ -66,43 +193,124 @@ public:
      */
     int getRollbackCount() const;
     
+    /**
+     * Inputs that arrived after their tick was simulated, in time to be
+     * rolled back in (for statistics)
+     */
+    int getLateInputCount() const;
+    
+    /**
+     * Inputs that arrived after their tick left the snapshot window and
+     * were discarded (for statistics)
+     */
+    int getExpiredInputCount() const;
+    
     /**
      * Get match ID
      */
     int getMatchId() const;
     
     /**
-     * Check if match is running
+     * Check if match is running (as of the last publishState())
      */
     bool isRunning() const;
     
     /**
-     * Get current state (thread-safe copy)
+     * Get last published state (thread-safe copy, never blocks the owner)
      */
-    MatchState getState() const;
+    State getState() const;
+    
+    /**
+     * Number of inputs currently retained for re-simulation (owner)
+     */
+    size_t getHistorySize() const;
 
 private:
+    void processInputAt(int tick, PackedInput input);
+    
+    void applyAction(int playerIdx, ActionType action);
+    
     /**
-     * Find the best snapshot for rollback
+     * All players' inputs for tick are in, or its deadline has passed
      */
-    const Snapshot* findSnapshotForTick(int tick) const;
+    bool isTickReady(int tick) const;
+    
+    /**
+     * Simulate the current tick from the timeline, snapshot on interval
+     */
+    void simulateTick();
+    
+    /**
+     * Apply every recorded input for tick
+     */
+    void applyTickInputs(int tick);
+    
+    /**
+     * Re-simulate ticks from the restored state up to targetTick
+     */
+    void resimulateTo(int targetTick);
+    
+    /**
+     * Restore the snapshot for toTick and re-simulate (owner)
+     */
+    void performRollback(int toTick);
+    
+    /**
+     * Roll back to toTick now, or defer it when deferral is on
+     */
+    void requestRollback(int toTick);
     
     /**
      * Advance to next tick
      */
     void advanceTick();
+    
+    void countRollback();
+    
+    /**
+     * Hand every sync tick that can no longer be re-simulated to the hook
+     */
+    void reportSyncTicks();
 
 private:
-    MatchState state_;
-    std::vector<Snapshot> snapshots_;
-    std::vector<Input> inputHistory_;
+    static constexpr int NO_ROLLBACK_REQUEST = INT32_MAX;
+    static constexpr uint32_t ALL_PLAYERS_MASK = (1u << Config::PLAYERS) - 1;
+    
+    // A deferred rollback this far behind is resolved before simulating on
+    // (one more snapshot and it could no longer be restored exactly)
+    static constexpr int DEFER_LIMIT_TICKS = MAX_ROLLBACK_TICKS - ROLLBACK_INTERVAL;
     
-    mutable std::mutex mutex_;
+    State state_;
+    SnapshotStore<State> snapshots_;  // In place; only DELTA/PAGED buffers grow
+    InputHistory inputHistory_;  // Indexed by tick, trimmed to the snapshot window
+    TickHashHistory tickHashes_;
+    
+    // Written only by the owner; read by anyone
+    SeqLock<State> published_;
     std::atomic<int> rollbackCount_{0};
+    std::atomic<int> lateInputCount_{0};
+    std::atomic<int> expiredInputCount_{0};
+    
+    // Command queue from other threads: earliest requested rollback tick
+    std::atomic<int> requestedRollbackTick_{NO_ROLLBACK_REQUEST};
+    
+    int newestInputTick_ = 0;  // Reference for unwrapping packed ticks
+    int rollbackInterval_ = ROLLBACK_INTERVAL;
+    const SyncHook* syncHook_ = nullptr;
+    int nextSyncTick_ = SYNC_TICK_INTERVAL;  // Next sync tick to report
     
-    int lastSnapshotTick_ = -ROLLBACK_INTERVAL;
+    // Owner only: earliest tick of the deferred rollback
+    int deferredRollbackTick_ = NO_ROLLBACK_REQUEST;
+    bool deferRollbacks_ = false;
 };
 
+// The modes GameServer hosts (compiled once, in match.cpp)
+extern template class BasicMatch<DuelConfig>;
+extern template class BasicMatch<TeamConfig>;
+
+using Match = BasicMatch<DuelConfig>;
+using TeamMatch = BasicMatch<TeamConfig>;
+
 } // namespace para
 
-#endif // MATCH_HPP
\ No newline at end of file
+#endif // MATCH_HPP
@@ -0,0 +1,244 @@
+#include "match_state_soa.hpp"
+#include <algorithm>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#define PARA_SOA_AVX2 1
+#elif defined(__SSSE3__)
+#include <tmmintrin.h>
+#define PARA_SOA_SSSE3 1
+#elif defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#define PARA_SOA_SSE2 1
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+#include <arm_neon.h>
+#define PARA_SOA_NEON 1
+#endif
+
+namespace para {
+
+static_assert(ARENA_WIDTH <= 256 && ARENA_HEIGHT <= 256, "Positions are stored as bytes");
+static_assert(static_cast<int>(ActionType::MOVE_LEFT) == 0 &&
+              static_cast<int>(ActionType::MOVE_RIGHT) == 1 &&
+              static_cast<int>(ActionType::MOVE_UP) == 2 &&
+              static_cast<int>(ActionType::MOVE_DOWN) == 3,
+              "Delta tables are indexed by ActionType value");
+
+namespace {
+
+constexpr uint8_t MAX_X = ARENA_WIDTH - 1;
+constexpr uint8_t MAX_Y = ARENA_HEIGHT - 1;
+
+// Per-action deltas indexed by action code (LEFT, RIGHT, UP, DOWN, NO_ACTION).
+// 16 entries so a pshufb / tbl lookup reads them directly
+alignas(16) constexpr uint8_t DEC_X[16] = {1, 0, 0, 0, 0};
+alignas(16) constexpr uint8_t INC_X[16] = {0, 1, 0, 0, 0};
+alignas(16) constexpr uint8_t DEC_Y[16] = {0, 0, 1, 0, 0};
+alignas(16) constexpr uint8_t INC_Y[16] = {0, 0, 0, 1, 0};
+
+inline uint8_t stepAxis(uint8_t pos, uint8_t dec, uint8_t inc, uint8_t max) {
+    // max(0, pos - dec) then min(max, pos + inc), without branches
+    uint8_t down = static_cast<uint8_t>(pos - std::min(pos, dec));
+    return std::min(static_cast<uint8_t>(down + inc), max);
+}
+
+void applyScalar(uint8_t* x, uint8_t* y, const uint8_t* actions, size_t begin, size_t end) {
+    for (size_t i = begin; i < end; ++i) {
+        uint8_t a = actions[i] & 15;
+        x[i] = stepAxis(x[i], DEC_X[a], INC_X[a], MAX_X);
+        y[i] = stepAxis(y[i], DEC_Y[a], INC_Y[a], MAX_Y);
+    }
+}
+
+#if defined(PARA_SOA_AVX2)
+
+size_t applyVector(uint8_t* x, uint8_t* y, const uint8_t* actions, size_t count) {
+    // pshufb looks up within each 128-bit lane, so repeat the table in both
+    const __m256i decX = _mm256_broadcastsi128_si256(_mm_load_si128(reinterpret_cast<const __m128i*>(DEC_X)));
+    const __m256i incX = _mm256_broadcastsi128_si256(_mm_load_si128(reinterpret_cast<const __m128i*>(INC_X)));
+    const __m256i decY = _mm256_broadcastsi128_si256(_mm_load_si128(reinterpret_cast<const __m128i*>(DEC_Y)));
+    const __m256i incY = _mm256_broadcastsi128_si256(_mm_load_si128(reinterpret_cast<const __m128i*>(INC_Y)));
+    const __m256i lowNibble = _mm256_set1_epi8(15);
+    const __m256i maxX = _mm256_set1_epi8(static_cast<char>(MAX_X));
+    const __m256i maxY = _mm256_set1_epi8(static_cast<char>(MAX_Y));
+
+    size_t i = 0;
+    for (; i + 32 <= count; i += 32) {
+        __m256i a = _mm256_and_si256(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(actions + i)), lowNibble);
+        __m256i px = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(x + i));
+        __m256i py = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(y + i));
+
+        px = _mm256_subs_epu8(px, _mm256_shuffle_epi8(decX, a));
+        px = _mm256_min_epu8(_mm256_adds_epu8(px, _mm256_shuffle_epi8(incX, a)), maxX);
+        py = _mm256_subs_epu8(py, _mm256_shuffle_epi8(decY, a));
+        py = _mm256_min_epu8(_mm256_adds_epu8(py, _mm256_shuffle_epi8(incY, a)), maxY);
+
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(x + i), px);
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(y + i), py);
+    }
+    return i;
+}
+
+#elif defined(PARA_SOA_SSSE3)
+
+size_t applyVector(uint8_t* x, uint8_t* y, const uint8_t* actions, size_t count) {
+    const __m128i decX = _mm_load_si128(reinterpret_cast<const __m128i*>(DEC_X));
+    const __m128i incX = _mm_load_si128(reinterpret_cast<const __m128i*>(INC_X));
+    const __m128i decY = _mm_load_si128(reinterpret_cast<const __m128i*>(DEC_Y));
+    const __m128i incY = _mm_load_si128(reinterpret_cast<const __m128i*>(INC_Y));
+    const __m128i lowNibble = _mm_set1_epi8(15);
+    const __m128i maxX = _mm_set1_epi8(static_cast<char>(MAX_X));
+    const __m128i maxY = _mm_set1_epi8(static_cast<char>(MAX_Y));
+
+    size_t i = 0;
+    for (; i + 16 <= count; i += 16) {
+        __m128i a = _mm_and_si128(_mm_loadu_si128(reinterpret_cast<const __m128i*>(actions + i)), lowNibble);
+        __m128i px = _mm_loadu_si128(reinterpret_cast<const __m128i*>(x + i));
+        __m128i py = _mm_loadu_si128(reinterpret_cast<const __m128i*>(y + i));
+
+        px = _mm_subs_epu8(px, _mm_shuffle_epi8(decX, a));
+        px = _mm_min_epu8(_mm_adds_epu8(px, _mm_shuffle_epi8(incX, a)), maxX);
+        py = _mm_subs_epu8(py, _mm_shuffle_epi8(decY, a));
+        py = _mm_min_epu8(_mm_adds_epu8(py, _mm_shuffle_epi8(incY, a)), maxY);
+
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(x + i), px);
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(y + i), py);
+    }
+    return i;
+}
+
+#elif defined(PARA_SOA_SSE2)
+
+size_t applyVector(uint8_t* x, uint8_t* y, const uint8_t* actions, size_t count) {
+    // No pshufb before SSSE3: build the same deltas from compares (0xFF & 1)
+    const __m128i one = _mm_set1_epi8(1);
+    const __m128i lowNibble = _mm_set1_epi8(15);
+    const __m128i left = _mm_set1_epi8(static_cast<char>(ActionType::MOVE_LEFT));
+    const __m128i right = _mm_set1_epi8(static_cast<char>(ActionType::MOVE_RIGHT));
+    const __m128i up = _mm_set1_epi8(static_cast<char>(ActionType::MOVE_UP));
+    const __m128i down = _mm_set1_epi8(static_cast<char>(ActionType::MOVE_DOWN));
+    const __m128i maxX = _mm_set1_epi8(static_cast<char>(MAX_X));
+    const __m128i maxY = _mm_set1_epi8(static_cast<char>(MAX_Y));
+
+    size_t i = 0;
+    for (; i + 16 <= count; i += 16) {
+        __m128i a = _mm_and_si128(_mm_loadu_si128(reinterpret_cast<const __m128i*>(actions + i)), lowNibble);
+        __m128i px = _mm_loadu_si128(reinterpret_cast<const __m128i*>(x + i));
+        __m128i py = _mm_loadu_si128(reinterpret_cast<const __m128i*>(y + i));
+
+        px = _mm_subs_epu8(px, _mm_and_si128(_mm_cmpeq_epi8(a, left), one));
+        px = _mm_min_epu8(_mm_adds_epu8(px, _mm_and_si128(_mm_cmpeq_epi8(a, right), one)), maxX);
+        py = _mm_subs_epu8(py, _mm_and_si128(_mm_cmpeq_epi8(a, up), one));
+        py = _mm_min_epu8(_mm_adds_epu8(py, _mm_and_si128(_mm_cmpeq_epi8(a, down), one)), maxY);
+
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(x + i), px);
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(y + i), py);
+    }
+    return i;
+}
+
+#elif defined(PARA_SOA_NEON)
+
+size_t applyVector(uint8_t* x, uint8_t* y, const uint8_t* actions, size_t count) {
+    const uint8x16_t decX = vld1q_u8(DEC_X);
+    const uint8x16_t incX = vld1q_u8(INC_X);
+    const uint8x16_t decY = vld1q_u8(DEC_Y);
+    const uint8x16_t incY = vld1q_u8(INC_Y);
+    const uint8x16_t lowNibble = vdupq_n_u8(15);
+    const uint8x16_t maxX = vdupq_n_u8(MAX_X);
+    const uint8x16_t maxY = vdupq_n_u8(MAX_Y);
+
+    size_t i = 0;
+    for (; i + 16 <= count; i += 16) {
+        uint8x16_t a = vandq_u8(vld1q_u8(actions + i), lowNibble);
+        uint8x16_t px = vld1q_u8(x + i);
+        uint8x16_t py = vld1q_u8(y + i);
+
+        px = vqsubq_u8(px, vqtbl1q_u8(decX, a));
+        px = vminq_u8(vqaddq_u8(px, vqtbl1q_u8(incX, a)), maxX);
+        py = vqsubq_u8(py, vqtbl1q_u8(decY, a));
+        py = vminq_u8(vqaddq_u8(py, vqtbl1q_u8(incY, a)), maxY);
+
+        vst1q_u8(x + i, px);
+        vst1q_u8(y + i, py);
+    }
+    return i;
+}
+
+#else
+
+size_t applyVector(uint8_t*, uint8_t*, const uint8_t*, size_t) {
+    return 0;
+}
+
+#endif
+
+} // namespace
+
+MatchStateSoA::MatchStateSoA(size_t numMatches)
+    : numMatches_(numMatches)
+    , x_(numMatches * PLAYERS_PER_MATCH, ARENA_WIDTH / 2)
+    , y_(numMatches * PLAYERS_PER_MATCH, ARENA_HEIGHT / 2)
+    , ticks_(numMatches, 0)
+    , matchIds_(numMatches, 0)
+    , running_(numMatches, 0)
+{
+}
+
+void MatchStateSoA::load(size_t match, const MatchState& state) {
+    for (int p = 0; p < PLAYERS_PER_MATCH; ++p) {
+        size_t slot = match * PLAYERS_PER_MATCH + p;
+        x_[slot] = static_cast<uint8_t>(state.players[p].x);
+        y_[slot] = static_cast<uint8_t>(state.players[p].y);
+    }
+    ticks_[match] = state.currentTick;
+    matchIds_[match] = state.matchId;
+    running_[match] = state.isRunning ? 1 : 0;
+}
+
+MatchState MatchStateSoA::extract(size_t match) const {
+    MatchState state(matchIds_[match]);
+    for (int p = 0; p < PLAYERS_PER_MATCH; ++p) {
+        size_t slot = match * PLAYERS_PER_MATCH + p;
+        state.players[p].x = x_[slot];
+        state.players[p].y = y_[slot];
+    }
+    state.refreshPlayerSum();  // Positions set directly; the kernel keeps no tick chain
+    state.currentTick = ticks_[match];
+    state.isRunning = running_[match] != 0;
+    return state;
+}
+
+void MatchStateSoA::applyTick(const uint8_t* actions) {
+    size_t count = numPlayers();
+    size_t done = applyVector(x_.data(), y_.data(), actions, count);
+    applyScalar(x_.data(), y_.data(), actions, done, count);
+    advanceTicks();
+}
+
+void MatchStateSoA::applyTickScalar(const uint8_t* actions) {
+    applyScalar(x_.data(), y_.data(), actions, 0, numPlayers());
+    advanceTicks();
+}
+
+const char* MatchStateSoA::kernelName() {
+#if defined(PARA_SOA_AVX2)
+    return "AVX2";
+#elif defined(PARA_SOA_SSSE3)
+    return "SSSE3";
+#elif defined(PARA_SOA_SSE2)
+    return "SSE2";
+#elif defined(PARA_SOA_NEON)
+    return "NEON";
+#else
+    return "scalar";
+#endif
+}
+
+void MatchStateSoA::advanceTicks() {
+    for (auto& tick : ticks_) {
+        ++tick;
+    }
+}
+
+} // namespace para
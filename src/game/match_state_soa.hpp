@@ -0,0 +1,92 @@
+#ifndef MATCH_STATE_SOA_HPP
+#define MATCH_STATE_SOA_HPP
+
+#include "../common/types.hpp"
+#include "../common/data_structures.hpp"
+#include <vector>
+#include <cstddef>
+#include <cstdint>
+
+namespace para {
+
+/**
+ * MatchStateSoA - Structure-of-arrays state for many matches
+ *
+ * Player positions of every match live in two contiguous byte arrays,
+ * indexed by player slot = match * 2 + player. A tick applies one action
+ * per player slot across all matches with a branchless kernel: per-action
+ * delta tables, saturating add/subtract and a min clamp. The kernel is
+ * vectorized with AVX2, SSSE3, SSE2 or NEON depending on what the build
+ * targets (see kernelName()), with a scalar fallback that gives the same
+ * results as PlayerState::move / Match::applyInput bit for bit.
+ */
+class MatchStateSoA {
+public:
+    static constexpr int PLAYERS_PER_MATCH = para::PLAYERS_PER_MATCH;
+
+    /**
+     * Action code for a player slot that has no input this tick.
+     * Other codes are static_cast<uint8_t>(ActionType)
+     */
+    static constexpr uint8_t NO_ACTION = 4;
+
+    explicit MatchStateSoA(size_t numMatches);
+
+    /**
+     * Copy one match's state in / out of the store
+     */
+    void load(size_t match, const MatchState& state);
+    MatchState extract(size_t match) const;
+
+    /**
+     * Apply actions[slot] to every player slot (numPlayers() entries)
+     * and advance every match by one tick, using the best kernel built in
+     */
+    void applyTick(const uint8_t* actions);
+
+    /**
+     * Same as applyTick() without SIMD (reference / fallback)
+     */
+    void applyTickScalar(const uint8_t* actions);
+
+    static uint8_t actionCode(ActionType type) {
+        return static_cast<uint8_t>(type);
+    }
+
+    /**
+     * Name of the kernel applyTick() uses ("AVX2", "SSSE3", "SSE2", "NEON", "scalar")
+     */
+    static const char* kernelName();
+
+    size_t size() const { return numMatches_; }
+    size_t numPlayers() const { return numMatches_ * PLAYERS_PER_MATCH; }
+
+    /**
+     * Bytes of state kept per match
+     */
+    static constexpr size_t bytesPerMatch() {
+        return PLAYERS_PER_MATCH * 2 * sizeof(uint8_t) + 2 * sizeof(int32_t) + sizeof(uint8_t);
+    }
+
+    const uint8_t* xData() const { return x_.data(); }
+    const uint8_t* yData() const { return y_.data(); }
+
+private:
+    void advanceTicks();
+
+private:
+    size_t numMatches_;
+
+    // Per player slot
+    std::vector<uint8_t> x_;
+    std::vector<uint8_t> y_;
+
+    // Per match
+    std::vector<int32_t> ticks_;
+    std::vector<int32_t> matchIds_;
+    std::vector<uint8_t> running_;
+};
+
+} // namespace para
+
+#endif // MATCH_STATE_SOA_HPP
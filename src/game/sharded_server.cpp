@@ -0,0 +1,215 @@
+#include "sharded_server.hpp"
+#include <cstdint>
+#include <stdexcept>
+
+namespace para {
+
+ShardedServer::ShardedServer(int numMatches, size_t numShards, size_t threadsPerShard, bool pinToNodes,
+                             size_t queueCapacity)
+    : numMatches_(numMatches)
+{
+    std::vector<NumaNode> nodes = detectNumaNodes();
+    if (numShards == 0) {
+        numShards = nodes.size();
+    }
+    
+    for (size_t s = 0; s < numShards; ++s) {
+        shards_.push_back(std::make_unique<Shard>());
+    }
+    
+    // Local indices follow matchId order within each shard
+    shardOf_.resize(numMatches);
+    localOf_.resize(numMatches);
+    for (int m = 0; m < numMatches; ++m) {
+        size_t s = shardFor(m, numShards);
+        shardOf_[m] = s;
+        localOf_[m] = static_cast<int>(shards_[s]->globalIds.size());
+        shards_[s]->globalIds.push_back(m);
+    }
+    for (const auto& shard : shards_) {
+        if (shard->globalIds.size() > static_cast<size_t>(PackedInput::MAX_MATCHES)) {
+            throw std::invalid_argument("ShardedServer: too many matches per shard for PackedInput");
+        }
+    }
+    
+    for (size_t s = 0; s < numShards; ++s) {
+        Shard& shard = *shards_[s];
+        const NumaNode& node = nodes[s % nodes.size()];
+        shard.node = node.id;
+        shard.pool = std::make_unique<ThreadPool>(threadsPerShard, pinToNodes ? node.cpus : CpuSet{});
+    
+        // Built by one of the shard's (pinned) workers: first touch puts the
+        // matches, snapshots and queues in that node's memory
+        int localMatches = static_cast<int>(shard.globalIds.size());
+        shard.pool->submitTo(0, [&shard, localMatches, queueCapacity]() {
+            shard.server = std::make_unique<GameServer>(localMatches, queueCapacity);
+        });
+        shard.pool->waitAll();
+        shard.server->enableEventScheduling(*shard.pool);
+    }
+}
+
+size_t ShardedServer::shardFor(int matchId, size_t numShards) {
+    // 32-bit finalizer (murmur3 fmix32)
+    uint32_t h = static_cast<uint32_t>(matchId);
+    h ^= h >> 16;
+    h *= 0x85ebca6bu;
+    h ^= h >> 13;
+    h *= 0xc2b2ae35u;
+    h ^= h >> 16;
+    return static_cast<size_t>(h) % numShards;
+}
+
+void ShardedServer::start() {
+    for (auto& shard : shards_) {
+        shard->server->start();
+    }
+}
+
+void ShardedServer::setRollbackInterval(int ticks) {
+    for (auto& shard : shards_) {
+        shard->server->setRollbackInterval(ticks);
+    }
+}
+
+void ShardedServer::setSnapshotPolicy(SnapshotPolicy policy) {
+    for (auto& shard : shards_) {
+        shard->server->setSnapshotPolicy(policy);
+    }
+}
+
+void ShardedServer::setSyncHook(const SyncHook& hook) {
+    for (auto& shard : shards_) {
+        if (!hook) {
+            shard->server->setSyncHook(SyncHook());
+            continue;
+        }
+        const std::vector<int>* globalIds = &shard->globalIds;
+        shard->server->setSyncHook([hook, globalIds](const SyncPoint& point) {
+            SyncPoint global = point;
+            global.matchId = (*globalIds)[point.matchId];
+            hook(global);
+        });
+    }
+}
+
+void ShardedServer::enableAdaptiveDrain(const BatchTargets& targets) {
+    for (auto& shard : shards_) {
+        shard->server->enableAdaptiveDrain(targets);
+    }
+}
+
+std::vector<std::vector<PackedInput>>& ShardedServer::routingBuckets() {
+    thread_local std::vector<std::vector<PackedInput>> buckets;
+    if (buckets.size() < shards_.size()) {
+        buckets.resize(shards_.size());
+    }
+    return buckets;
+}
+
+void ShardedServer::handOff(std::vector<std::vector<PackedInput>>& buckets) {
+    for (size_t s = 0; s < shards_.size(); ++s) {
+        if (buckets[s].empty()) continue;
+        shards_[s]->server->receiveInputs(buckets[s].data(), buckets[s].size());
+        buckets[s].clear();
+    }
+}
+
+void ShardedServer::receiveInput(const Input& input) {
+    receiveInputs(&input, 1);
+}
+
+void ShardedServer::receiveInputs(const Input* inputs, size_t count) {
+    std::vector<std::vector<PackedInput>>& buckets = routingBuckets();
+    for (size_t i = 0; i < count; ++i) {
+        int matchId = inputs[i].matchId;
+        if (matchId < 0 || matchId >= numMatches_) continue;
+        buckets[shardOf_[matchId]].push_back(
+            PackedInput(localOf_[matchId], inputs[i].playerId, inputs[i].tickId, inputs[i].type));
+    }
+    handOff(buckets);
+}
+
+void ShardedServer::receiveInputs(const PackedInput* inputs, size_t count) {
+    std::vector<std::vector<PackedInput>>& buckets = routingBuckets();
+    for (size_t i = 0; i < count; ++i) {
+        int matchId = inputs[i].localMatch();
+        if (matchId >= numMatches_) continue;
+        buckets[shardOf_[matchId]].push_back(inputs[i].withLocalMatch(localOf_[matchId]));
+    }
+    handOff(buckets);
+}
+
+void ShardedServer::waitAll() {
+    for (auto& shard : shards_) {
+        shard->pool->waitAll();
+    }
+}
+
+size_t ShardedServer::getProcessedCount() const {
+    size_t total = 0;
+    for (const auto& shard : shards_) {
+        total += shard->server->getProcessedCount();
+    }
+    return total;
+}
+
+int ShardedServer::getTotalRollbackCount() const {
+    int total = 0;
+    for (const auto& shard : shards_) {
+        total += shard->server->getTotalRollbackCount();
+    }
+    return total;
+}
+
+int ShardedServer::getTotalLateInputCount() const {
+    int total = 0;
+    for (const auto& shard : shards_) {
+        total += shard->server->getTotalLateInputCount();
+    }
+    return total;
+}
+
+int ShardedServer::getTotalExpiredInputCount() const {
+    int total = 0;
+    for (const auto& shard : shards_) {
+        total += shard->server->getTotalExpiredInputCount();
+    }
+    return total;
+}
+
+size_t ShardedServer::getDroppedCount() const {
+    size_t total = 0;
+    for (const auto& shard : shards_) {
+        total += shard->server->getDroppedCount();
+    }
+    return total;
+}
+
+size_t ShardedServer::getScheduledTaskCount() const {
+    size_t total = 0;
+    for (const auto& shard : shards_) {
+        total += shard->server->getScheduledTaskCount();
+    }
+    return total;
+}
+
+BatchControlStats ShardedServer::getDrainControlStats() const {
+    BatchControlStats total;
+    for (const auto& shard : shards_) {
+        total.merge(shard->server->getDrainControlStats());
+    }
+    return total;
+}
+
+int ShardedServer::getMatchTick(int matchId) const {
+    if (matchId < 0 || matchId >= numMatches_) return 0;
+    return shards_[shardOf_[matchId]]->server->getMatchTick(localOf_[matchId]);
+}
+
+size_t ShardedServer::getQueueDepth(int matchId) const {
+    if (matchId < 0 || matchId >= numMatches_) return 0;
+    return shards_[shardOf_[matchId]]->server->getQueueDepth(localOf_[matchId]);
+}
+
+} // namespace para
@@ -0,0 +1,125 @@
+#ifndef SHARDED_SERVER_HPP
+#define SHARDED_SERVER_HPP
+
+#include "game_server.hpp"
+#include "../common/types.hpp"
+#include "../common/data_structures.hpp"
+#include "../common/cpu_topology.hpp"
+#include "../scheduler/thread_pool.hpp"
+#include <cstddef>
+#include <memory>
+#include <vector>
+
+namespace para {
+
+/**
+ * ShardedServer - Matches partitioned across independent GameServers
+ *
+ * Each matchId hashes to one of N shards. A shard is a whole GameServer
+ * (its matches, snapshots and input queues) plus its own ThreadPool with
+ * event scheduling, so shards share no queues, counters or workers.
+ *
+ * With pinning on, shards are dealt round-robin to the NUMA nodes found by
+ * detectNumaNodes() and a shard's workers keep to its node's CPUs. Each
+ * GameServer is built on one of its own workers: with the default
+ * first-touch policy its memory, and everything the workers allocate
+ * later, lands on that node (no libnuma needed).
+ *
+ * Inputs use global match ids. receiveInput(s) buckets a batch by shard,
+ * readdresses each input to its shard-local match, and hands each shard
+ * its bucket in one receiveInputs() call: one cross-node handoff per shard
+ * per batch, not per input. Any thread may send.
+ */
+class ShardedServer {
+public:
+    /**
+     * numShards 0: one per NUMA node. Throws std::invalid_argument if a
+     * shard would get more matches than PackedInput can address
+     */
+    ShardedServer(int numMatches, size_t numShards, size_t threadsPerShard, bool pinToNodes = true,
+                  size_t queueCapacity = MATCH_QUEUE_CAPACITY);
+    ~ShardedServer() = default;
+    
+    ShardedServer(const ShardedServer&) = delete;
+    ShardedServer& operator=(const ShardedServer&) = delete;
+    
+    void start();
+    
+    // Ticks between every match's demo rollbacks (0: none). Before start()
+    void setRollbackInterval(int ticks);
+    
+    // GameServer::setSnapshotPolicy() on every shard. Before start()
+    void setSnapshotPolicy(SnapshotPolicy policy);
+    
+    // GameServer::setSyncHook() on every shard; SyncPoint::matchId is the
+    // global matchId. Before start()
+    void setSyncHook(const SyncHook& hook);
+    
+    // GameServer::enableAdaptiveDrain() on every shard
+    void enableAdaptiveDrain(const BatchTargets& targets = BatchTargets());
+    
+    // Route inputs addressed by global matchId; unknown matches are ignored
+    void receiveInput(const Input& input);
+    void receiveInputs(const Input* inputs, size_t count);
+    
+    // Same, for packed inputs whose match field holds the global matchId
+    // (so only matches below PackedInput::MAX_MATCHES can be sent this way)
+    void receiveInputs(const PackedInput* inputs, size_t count);
+    
+    // Wait until every shard's pool has run dry
+    void waitAll();
+    
+    size_t getProcessedCount() const;
+    int getTotalRollbackCount() const;
+    int getTotalLateInputCount() const;
+    int getTotalExpiredInputCount() const;
+    size_t getDroppedCount() const;
+    size_t getScheduledTaskCount() const;
+    BatchControlStats getDrainControlStats() const;
+    
+    // Last published simulated tick of a match (any thread)
+    int getMatchTick(int matchId) const;
+    
+    // Inputs queued for a match in its shard (approximate, any thread)
+    size_t getQueueDepth(int matchId) const;
+    
+    int getNumMatches() const { return numMatches_; }
+    size_t getNumShards() const { return shards_.size(); }
+    
+    // Shard a match lives in, and its index inside that shard's server
+    size_t getShardOf(int matchId) const { return shardOf_[matchId]; }
+    int getLocalMatch(int matchId) const { return localOf_[matchId]; }
+    
+    // Per-shard access (statistics, or submitting work next to a shard's matches)
+    GameServer& getShardServer(size_t shard) { return *shards_[shard]->server; }
+    ThreadPool& getShardPool(size_t shard) { return *shards_[shard]->pool; }
+    const ThreadPool& getShardPool(size_t shard) const { return *shards_[shard]->pool; }
+    int getShardNode(size_t shard) const { return shards_[shard]->node; }
+    size_t getShardMatchCount(size_t shard) const { return shards_[shard]->globalIds.size(); }
+    
+    // Shard for a matchId: mixed first, so consecutive ids spread out
+    static size_t shardFor(int matchId, size_t numShards);
+
+private:
+    struct Shard {
+        int node = 0;
+        std::vector<int> globalIds;           // Local match index -> matchId
+        std::unique_ptr<GameServer> server;   // Destroyed after the pool has stopped
+        std::unique_ptr<ThreadPool> pool;
+    };
+    
+    // Per-thread routing buckets, one per shard (left empty between calls)
+    std::vector<std::vector<PackedInput>>& routingBuckets();
+    
+    // Give every non-empty bucket to its shard in one call, then clear it
+    void handOff(std::vector<std::vector<PackedInput>>& buckets);
+    
+    std::vector<std::unique_ptr<Shard>> shards_;
+    std::vector<size_t> shardOf_;
+    std::vector<int> localOf_;
+    int numMatches_;
+};
+
+} // namespace para
+
+#endif // SHARDED_SERVER_HPP
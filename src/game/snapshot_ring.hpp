@@ -0,0 +1,208 @@
+#ifndef SNAPSHOT_RING_HPP
+#define SNAPSHOT_RING_HPP
+
+#include "../common/types.hpp"
+#include "../common/data_structures.hpp"
+#include <array>
+#include <cstddef>
+
+namespace para {
+
+/**
+ * SnapshotIndex - Which tick each slot of a snapshot ring holds
+ *
+ * Snapshots are bucketed by tick / Interval into Depth slots, so a match
+ * keeps the last Depth * Interval ticks of history. A Match saves at most
+ * one snapshot per interval (consecutive snapshot ticks are at least
+ * Interval apart), so each bucket holds at most one snapshot and lookup is
+ * a direct index in the common case.
+ *
+ * Only the bookkeeping: the snapshot stores keep their payload (full
+ * copies, deltas or pages) in arrays indexed by the same slot numbers.
+ */
+template<int Interval, size_t Depth>
+class SnapshotIndex {
+    static_assert(Interval > 0, "Snapshot interval must be positive");
+    static_assert(Depth > 0, "Snapshot ring needs at least one slot");
+
+public:
+    static constexpr int NONE = -1;
+
+    /**
+     * Take the slot for tick's bucket (overwriting the oldest bucket);
+     * returns the slot index
+     */
+    size_t claim(int tick) {
+        int bucket = bucketOf(tick);
+        size_t index = slotIndex(bucket);
+        slots_[index].bucket = bucket;
+        slots_[index].tick = tick;
+
+        if (bucket > newestBucket_) {
+            newestBucket_ = bucket;
+        }
+        if (count_ < Depth) {
+            ++count_;
+        }
+        return index;
+    }
+
+    /**
+     * Slot of the latest retained snapshot with tick <= tick, or of the
+     * oldest retained snapshot if none qualifies (NONE if empty)
+     */
+    int find(int tick) const {
+        if (count_ == 0) return NONE;
+
+        int bucket = bucketOf(tick);
+        if (bucket > newestBucket_) {
+            bucket = newestBucket_;
+        }
+        for (; bucket >= oldestBucket() && bucket >= 0; --bucket) {
+            size_t index = slotIndex(bucket);
+            if (slots_[index].bucket == bucket && slots_[index].tick <= tick) {
+                return static_cast<int>(index);
+            }
+        }
+        return oldest();
+    }
+
+    /**
+     * Slot of the oldest retained snapshot (NONE if empty)
+     */
+    int oldest() const {
+        if (count_ == 0) return NONE;
+
+        int bucket = oldestBucket() < 0 ? 0 : oldestBucket();
+        for (; bucket <= newestBucket_; ++bucket) {
+            size_t index = slotIndex(bucket);
+            if (slots_[index].bucket == bucket) {
+                return static_cast<int>(index);
+            }
+        }
+        return NONE;
+    }
+
+    /**
+     * Slot holding exactly bucket, if it is retained (NONE otherwise)
+     */
+    int slotOfBucket(int bucket) const {
+        if (count_ == 0 || bucket < 0 || bucket < oldestBucket() || bucket > newestBucket_) return NONE;
+        size_t index = slotIndex(bucket);
+        return slots_[index].bucket == bucket ? static_cast<int>(index) : NONE;
+    }
+
+    /**
+     * Forget a slot's snapshot (its payload is no longer valid)
+     */
+    void invalidate(size_t index) {
+        slots_[index].bucket = -1;
+    }
+
+    int tickAt(size_t index) const { return slots_[index].tick; }
+    int bucketAt(size_t index) const { return slots_[index].bucket; }
+    int newestBucket() const { return newestBucket_; }
+
+    bool empty() const { return count_ == 0; }
+
+    void clear() {
+        for (auto& slot : slots_) {
+            slot.bucket = -1;
+        }
+        newestBucket_ = -1;
+        count_ = 0;
+    }
+
+    static int bucketOf(int tick) {
+        return tick / Interval;
+    }
+
+    static size_t slotIndex(int bucket) {
+        return static_cast<size_t>(bucket) % Depth;
+    }
+
+private:
+    struct Slot {
+        int bucket = -1;   // tick / Interval of the stored snapshot, -1 if unused
+        int tick = 0;
+    };
+
+    int oldestBucket() const {
+        return newestBucket_ - static_cast<int>(Depth) + 1;
+    }
+
+    std::array<Slot, Depth> slots_;
+    int newestBucket_ = -1;
+    size_t count_ = 0;
+};
+
+/**
+ * SnapshotRing - Fixed-capacity, in-place full snapshots
+ *
+ * Every snapshot is a complete copy of the state, so saving and restoring
+ * are one copy each and nothing is ever allocated. The baseline snapshot
+ * policy (SnapshotPolicy::FULL); see snapshot_store.hpp for the others.
+ */
+template<int Interval, size_t Depth, typename State = MatchState>
+class SnapshotRing {
+public:
+    static constexpr int INTERVAL = Interval;
+    static constexpr size_t DEPTH = Depth;
+
+    /**
+     * Store a snapshot of state at tick, overwriting the oldest bucket
+     */
+    void save(int tick, const State& state) {
+        states_[index_.claim(tick)] = state;
+    }
+
+    /**
+     * Tick of the snapshot restore(tick) would load: the latest retained
+     * one at or before tick, else the oldest retained one (-1 if empty)
+     */
+    int findTick(int tick) const {
+        int slot = index_.find(tick);
+        return slot == Index::NONE ? -1 : index_.tickAt(slot);
+    }
+
+    /**
+     * Load that snapshot into out; returns its tick (-1 if empty)
+     */
+    int restore(int tick, State& out) const {
+        int slot = index_.find(tick);
+        if (slot == Index::NONE) return -1;
+        out = states_[slot];
+        return index_.tickAt(slot);
+    }
+
+    /**
+     * Tick of the oldest retained snapshot (-1 if empty)
+     */
+    int oldestTick() const {
+        int slot = index_.oldest();
+        return slot == Index::NONE ? -1 : index_.tickAt(slot);
+    }
+
+    bool empty() const { return index_.empty(); }
+
+    void clear() {
+        index_.clear();
+    }
+
+    /**
+     * Bytes this ring occupies
+     */
+    size_t memoryBytes() const {
+        return sizeof(*this);
+    }
+
+private:
+    using Index = SnapshotIndex<Interval, Depth>;
+
+    Index index_;
+    std::array<State, Depth> states_;
+};
+
+} // namespace para
+
+#endif // SNAPSHOT_RING_HPP
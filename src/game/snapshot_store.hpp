@@ -0,0 +1,480 @@
+#ifndef SNAPSHOT_STORE_HPP
+#define SNAPSHOT_STORE_HPP
+
+#include "snapshot_ring.hpp"
+#include "../common/types.hpp"
+#include "../common/data_structures.hpp"
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <type_traits>
+#include <variant>
+#include <vector>
+
+namespace para {
+
+// ============================================
+// Snapshot policies
+// ============================================
+// Every store keeps the same window of snapshots (SnapshotIndex) and
+// restores the same states; they differ in what a snapshot costs to save,
+// to restore and to keep:
+// - FULL:  a complete copy per snapshot (SnapshotRing)
+// - DELTA: a complete keyframe every KeyframeEvery snapshots, the ones in
+//          between as the words that differ from it (DeltaSnapshotRing)
+// - PAGED: the state cut into pages shared between snapshots until they
+//          change (PagedSnapshotRing)
+enum class SnapshotPolicy : uint8_t {
+    FULL,
+    DELTA,
+    PAGED
+};
+
+inline const char* snapshotPolicyName(SnapshotPolicy policy) {
+    switch (policy) {
+        case SnapshotPolicy::FULL:  return "full";
+        case SnapshotPolicy::DELTA: return "delta";
+        case SnapshotPolicy::PAGED: return "paged";
+        default: return "unknown";
+    }
+}
+
+// ============================================
+// DeltaSnapshotRing - Keyframes plus XOR deltas
+// ============================================
+/**
+ * Snapshots are grouped by bucket / KeyframeEvery. The first snapshot
+ * saved in a group is its keyframe, a complete copy; every later one in
+ * the group stores only the 32-bit words in which it differs from the
+ * keyframe (index, XOR). Restoring copies the keyframe and applies one
+ * delta, however far into the group the snapshot is.
+ *
+ * Saving a group's keyframe again (a rollback re-simulating through it)
+ * drops the group's later snapshots, whose deltas it invalidates; the
+ * re-simulation saves them again on its way back.
+ *
+ * Keyframes live in their own ring, sized for every group the snapshot
+ * window can reach, so a retained delta always has its keyframe. Delta
+ * buffers keep their capacity: saving allocates only while the largest
+ * delta seen so far grows.
+ */
+template<int Interval, size_t Depth, int KeyframeEvery, typename State = MatchState>
+class DeltaSnapshotRing {
+    static_assert(std::is_trivially_copyable<State>::value, "Delta snapshots copy the state as raw words");
+    static_assert(KeyframeEvery > 0, "Keyframe spacing must be positive");
+
+public:
+    // Groups a window of Depth consecutive buckets can touch
+    static constexpr size_t KEYFRAMES = Depth / KeyframeEvery + 2;
+    static constexpr size_t WORDS = (sizeof(State) + 3) / 4;
+    static constexpr size_t FULL_WORDS = sizeof(State) / 4;
+    static constexpr size_t BLOCK_WORDS = 16;   // Compared at once before looking at single words
+
+    void save(int tick, const State& state) {
+        int bucket = Index::bucketOf(tick);
+        int group = bucket / KeyframeEvery;
+        Keyframe& key = keyframes_[static_cast<size_t>(group) % KEYFRAMES];
+        Delta& delta = deltas_[index_.claim(tick)];
+        delta.entries.clear();
+
+        if (key.group != group || bucket <= key.bucket) {
+            if (key.group == group) {
+                dropLaterInGroup(bucket, group);
+            }
+            key.group = group;
+            key.bucket = bucket;
+            key.state = state;
+            return;
+        }
+
+        const unsigned char* current = bytesOf(state);
+        const unsigned char* base = bytesOf(key.state);
+        for (size_t block = 0; block < FULL_WORDS; block += BLOCK_WORDS) {
+            size_t end = std::min(block + BLOCK_WORDS, FULL_WORDS);
+            uint32_t changed = 0;
+            for (size_t word = block; word < end; ++word) {
+                changed |= loadWord(current, word) ^ loadWord(base, word);
+            }
+            if (changed == 0) continue;
+            for (size_t word = block; word < end; ++word) {
+                uint32_t bits = loadWord(current, word) ^ loadWord(base, word);
+                if (bits != 0) {
+                    delta.entries.push_back(Entry{static_cast<uint32_t>(word), bits});
+                }
+            }
+        }
+        if (WORDS > FULL_WORDS) {
+            uint32_t bits = tailWord(current) ^ tailWord(base);
+            if (bits != 0) {
+                delta.entries.push_back(Entry{static_cast<uint32_t>(FULL_WORDS), bits});
+            }
+        }
+    }
+
+    int findTick(int tick) const {
+        int slot = index_.find(tick);
+        return slot == Index::NONE ? -1 : index_.tickAt(slot);
+    }
+
+    int restore(int tick, State& out) const {
+        int slot = index_.find(tick);
+        if (slot == Index::NONE) return -1;
+
+        int bucket = index_.bucketAt(slot);
+        int group = bucket / KeyframeEvery;
+        const Keyframe& key = keyframes_[static_cast<size_t>(group) % KEYFRAMES];
+        if (key.group != group || key.bucket > bucket) return -1;
+
+        out = key.state;
+        if (bucket != key.bucket) {
+            unsigned char* bytes = reinterpret_cast<unsigned char*>(&out);
+            for (const Entry& entry : deltas_[slot].entries) {
+                if (entry.word < FULL_WORDS) {
+                    storeWord(bytes, entry.word, loadWord(bytes, entry.word) ^ entry.bits);
+                } else {
+                    storeTailWord(bytes, tailWord(bytes) ^ entry.bits);
+                }
+            }
+        }
+        return index_.tickAt(slot);
+    }
+
+    int oldestTick() const {
+        int slot = index_.oldest();
+        return slot == Index::NONE ? -1 : index_.tickAt(slot);
+    }
+
+    bool empty() const { return index_.empty(); }
+
+    void clear() {
+        index_.clear();
+        for (auto& key : keyframes_) {
+            key.group = -1;
+        }
+    }
+
+    /**
+     * Bytes this ring occupies, delta buffers included
+     */
+    size_t memoryBytes() const {
+        size_t bytes = sizeof(*this);
+        for (const auto& delta : deltas_) {
+            bytes += delta.entries.capacity() * sizeof(Entry);
+        }
+        return bytes;
+    }
+
+    /**
+     * Words stored across the retained deltas (for statistics)
+     */
+    size_t deltaWords() const {
+        size_t words = 0;
+        for (const auto& delta : deltas_) {
+            words += delta.entries.size();
+        }
+        return words;
+    }
+
+private:
+    using Index = SnapshotIndex<Interval, Depth>;
+
+    struct Entry {
+        uint32_t word;
+        uint32_t bits;   // XOR against the keyframe's word
+    };
+
+    struct Keyframe {
+        int group = -1;
+        int bucket = -1;
+        State state;
+    };
+
+    struct Delta {
+        std::vector<Entry> entries;   // Empty for the keyframe's own bucket
+    };
+
+    static const unsigned char* bytesOf(const State& state) {
+        return reinterpret_cast<const unsigned char*>(&state);
+    }
+
+    static uint32_t loadWord(const unsigned char* bytes, size_t word) {
+        uint32_t value;
+        std::memcpy(&value, bytes + word * 4, 4);
+        return value;
+    }
+
+    static void storeWord(unsigned char* bytes, size_t word, uint32_t value) {
+        std::memcpy(bytes + word * 4, &value, 4);
+    }
+
+    // The last word is partial when sizeof(State) is not a multiple of 4
+    static uint32_t tailWord(const unsigned char* bytes) {
+        uint32_t value = 0;
+        std::memcpy(&value, bytes + FULL_WORDS * 4, sizeof(State) - FULL_WORDS * 4);
+        return value;
+    }
+
+    static void storeTailWord(unsigned char* bytes, uint32_t value) {
+        std::memcpy(bytes + FULL_WORDS * 4, &value, sizeof(State) - FULL_WORDS * 4);
+    }
+
+    void dropLaterInGroup(int bucket, int group) {
+        int groupEnd = (group + 1) * KeyframeEvery;
+        for (int later = bucket + 1; later < groupEnd && later <= index_.newestBucket(); ++later) {
+            int slot = index_.slotOfBucket(later);
+            if (slot != Index::NONE) {
+                index_.invalidate(static_cast<size_t>(slot));
+            }
+        }
+    }
+
+    Index index_;
+    std::array<Keyframe, KEYFRAMES> keyframes_;
+    std::array<Delta, Depth> deltas_;
+};
+
+// ============================================
+// PagedSnapshotRing - Copy-on-write pages
+// ============================================
+/**
+ * The state is cut into PageBytes pages. A snapshot is a table of page
+ * ids; pages are reference counted and shared between snapshots. Saving
+ * compares each page with the snapshot it replaces (a re-simulation
+ * saving the same bucket again, often unchanged) and then with the
+ * previous save, and copies only the pages that match neither, so a
+ * snapshot costs one page per page the state dirtied. Restoring copies
+ * every page back.
+ *
+ * Dirty pages are found by comparison rather than marked by the writer:
+ * the state stays a plain struct and its code needs no write barriers.
+ * Pages are allocated in chunks up to the high-water mark of live pages
+ * and then recycled through a free list.
+ */
+template<int Interval, size_t Depth, size_t PageBytes, typename State = MatchState>
+class PagedSnapshotRing {
+    static_assert(std::is_trivially_copyable<State>::value, "Paged snapshots copy the state as raw bytes");
+    static_assert(PageBytes > 0, "Pages must hold at least one byte");
+
+public:
+    static constexpr size_t PAGES = (sizeof(State) + PageBytes - 1) / PageBytes;
+    static constexpr size_t PAGES_PER_CHUNK = PageBytes >= 4096 ? 1 : 4096 / PageBytes;
+
+    void save(int tick, const State& state) {
+        int bucket = Index::bucketOf(tick);
+        size_t slot = Index::slotIndex(bucket);
+        const Table* replaced = tables_[slot].live && index_.bucketAt(slot) == bucket ? &tables_[slot] : nullptr;
+        const Table* previous = lastSlot_ != Index::NONE && tables_[lastSlot_].live ? &tables_[lastSlot_] : nullptr;
+        const unsigned char* bytes = reinterpret_cast<const unsigned char*>(&state);
+
+        Table next;
+        for (size_t page = 0; page < PAGES; ++page) {
+            const unsigned char* source = bytes + page * PageBytes;
+            PageId id;
+            if (replaced && samePage(pageData(replaced->pages[page]), source, page)) {
+                id = replaced->pages[page];
+                ++refs_[id];
+            } else if (previous && samePage(pageData(previous->pages[page]), source, page)) {
+                id = previous->pages[page];
+                ++refs_[id];
+            } else {
+                id = allocatePage();
+                copyPage(pageData(id), source, page);
+            }
+            next.pages[page] = id;
+        }
+        next.live = true;
+
+        // After sharing: the slot being replaced may be the previous snapshot
+        release(tables_[slot]);
+        tables_[slot] = next;
+        index_.claim(tick);
+        lastSlot_ = static_cast<int>(slot);
+    }
+
+    int findTick(int tick) const {
+        int slot = index_.find(tick);
+        return slot == Index::NONE ? -1 : index_.tickAt(slot);
+    }
+
+    int restore(int tick, State& out) const {
+        int slot = index_.find(tick);
+        if (slot == Index::NONE) return -1;
+
+        unsigned char* bytes = reinterpret_cast<unsigned char*>(&out);
+        const Table& table = tables_[slot];
+        for (size_t page = 0; page < PAGES; ++page) {
+            copyPage(bytes + page * PageBytes, pageData(table.pages[page]), page);
+        }
+        return index_.tickAt(slot);
+    }
+
+    int oldestTick() const {
+        int slot = index_.oldest();
+        return slot == Index::NONE ? -1 : index_.tickAt(slot);
+    }
+
+    bool empty() const { return index_.empty(); }
+
+    void clear() {
+        index_.clear();
+        for (auto& table : tables_) {
+            release(table);
+        }
+        lastSlot_ = Index::NONE;
+    }
+
+    /**
+     * Bytes this ring occupies, page storage included
+     */
+    size_t memoryBytes() const {
+        return sizeof(*this) + chunks_.size() * PAGES_PER_CHUNK * PageBytes +
+               chunks_.capacity() * sizeof(chunks_[0]) + refs_.capacity() * sizeof(uint32_t) +
+               freePages_.capacity() * sizeof(PageId);
+    }
+
+    /**
+     * Pages currently referenced by some snapshot (for statistics)
+     */
+    size_t livePages() const {
+        return refs_.size() - freePages_.size();
+    }
+
+private:
+    using Index = SnapshotIndex<Interval, Depth>;
+    using PageId = uint32_t;
+
+    struct Table {
+        std::array<PageId, PAGES> pages{};
+        bool live = false;   // Holds references to its pages
+    };
+
+    static constexpr size_t FULL_PAGES = sizeof(State) / PageBytes;
+    static constexpr size_t TAIL_BYTES = sizeof(State) - FULL_PAGES * PageBytes;
+
+    // Fixed-size copies and compares for every page but a partial last one
+    static void copyPage(unsigned char* to, const unsigned char* from, size_t page) {
+        if (page < FULL_PAGES) {
+            std::memcpy(to, from, PageBytes);
+        } else {
+            std::memcpy(to, from, TAIL_BYTES);
+        }
+    }
+
+    static bool samePage(const unsigned char* a, const unsigned char* b, size_t page) {
+        return page < FULL_PAGES ? std::memcmp(a, b, PageBytes) == 0 : std::memcmp(a, b, TAIL_BYTES) == 0;
+    }
+
+    unsigned char* pageData(PageId id) {
+        return chunks_[id / PAGES_PER_CHUNK].get() + (id % PAGES_PER_CHUNK) * PageBytes;
+    }
+
+    const unsigned char* pageData(PageId id) const {
+        return chunks_[id / PAGES_PER_CHUNK].get() + (id % PAGES_PER_CHUNK) * PageBytes;
+    }
+
+    PageId allocatePage() {
+        PageId id;
+        if (!freePages_.empty()) {
+            id = freePages_.back();
+            freePages_.pop_back();
+        } else {
+            id = static_cast<PageId>(refs_.size());
+            refs_.push_back(0);
+            if (id % PAGES_PER_CHUNK == 0) {
+                chunks_.push_back(std::unique_ptr<unsigned char[]>(new unsigned char[PAGES_PER_CHUNK * PageBytes]));
+            }
+        }
+        refs_[id] = 1;
+        return id;
+    }
+
+    void release(Table& table) {
+        if (!table.live) return;
+        for (PageId id : table.pages) {
+            if (--refs_[id] == 0) {
+                freePages_.push_back(id);
+            }
+        }
+        table.live = false;
+    }
+
+    Index index_;
+    std::array<Table, Depth> tables_;
+    int lastSlot_ = Index::NONE;   // Most recent save: the pages to share from
+    std::vector<std::unique_ptr<unsigned char[]>> chunks_;
+    std::vector<uint32_t> refs_;
+    std::vector<PageId> freePages_;
+};
+
+// ============================================
+// SnapshotStore - A Match's snapshots under a runtime policy
+// ============================================
+/**
+ * Holds one of the three stores for State (in place, no virtual calls)
+ * and forwards to it. Switching policy drops every snapshot.
+ */
+template<typename State = MatchState>
+class SnapshotStore {
+public:
+    static constexpr int KEYFRAME_EVERY = 4;     // DELTA: snapshots per keyframe
+    static constexpr size_t PAGE_BYTES = 64;     // PAGED: one cache line per page
+
+    using Full = SnapshotRing<ROLLBACK_INTERVAL, SNAPSHOT_DEPTH, State>;
+    using Delta = DeltaSnapshotRing<ROLLBACK_INTERVAL, SNAPSHOT_DEPTH, KEYFRAME_EVERY, State>;
+    using Paged = PagedSnapshotRing<ROLLBACK_INTERVAL, SNAPSHOT_DEPTH, PAGE_BYTES, State>;
+
+    SnapshotPolicy policy() const {
+        return static_cast<SnapshotPolicy>(store_.index());
+    }
+
+    void setPolicy(SnapshotPolicy policy) {
+        if (policy == this->policy()) {
+            clear();
+            return;
+        }
+        switch (policy) {
+            case SnapshotPolicy::FULL:  store_.template emplace<Full>(); break;
+            case SnapshotPolicy::DELTA: store_.template emplace<Delta>(); break;
+            case SnapshotPolicy::PAGED: store_.template emplace<Paged>(); break;
+        }
+    }
+
+    void save(int tick, const State& state) {
+        std::visit([tick, &state](auto& store) { store.save(tick, state); }, store_);
+    }
+
+    int findTick(int tick) const {
+        return std::visit([tick](const auto& store) { return store.findTick(tick); }, store_);
+    }
+
+    int restore(int tick, State& out) const {
+        return std::visit([tick, &out](const auto& store) { return store.restore(tick, out); }, store_);
+    }
+
+    int oldestTick() const {
+        return std::visit([](const auto& store) { return store.oldestTick(); }, store_);
+    }
+
+    bool empty() const {
+        return std::visit([](const auto& store) { return store.empty(); }, store_);
+    }
+
+    void clear() {
+        std::visit([](auto& store) { store.clear(); }, store_);
+    }
+
+    size_t memoryBytes() const {
+        return std::visit([](const auto& store) { return store.memoryBytes(); }, store_);
+    }
+
+private:
+    // Alternatives in SnapshotPolicy order
+    std::variant<Full, Delta, Paged> store_;
+};
+
+} // namespace para
+
+#endif // SNAPSHOT_STORE_HPP
@@ -3,174 +3,69 @@
 #include "scheduler/thread_pool.hpp"
 #include "game/game_server.hpp"
 #include "client/client.hpp"
+#include "common/metrics.hpp"
+#include "benchmark/benchmark.hpp"
+#include "benchmark/traffic.hpp"
 
 #include <iostream>
 #include <chrono>
 #include <iomanip>
 #include <atomic>
+#include <algorithm>
 
 using namespace para;
 using namespace std::chrono;
 
-/**
- * Benchmark result structure
- */
-struct BenchmarkResult {
-    double timeMs;
-    size_t processedInputs;
-    int rollbackCount;
-    size_t workSteals;
-};
-
-/**
- * Run sequential benchmark
- * Generates all inputs first, then processes them sequentially
- */
-BenchmarkResult runSequentialBenchmark() {
-    BenchmarkResult result = {};
-    
-    std::cout << "  [Sequential] Generating inputs..." << std::endl;
-    
-    // 1. Generate all inputs first (to match original behavior)
-    ClientManager clientManager(NUM_CLIENTS, NUM_MATCHES, INPUTS_PER_CLIENT);
-    std::vector<Input> allInputs;
-    allInputs.reserve(NUM_CLIENTS * INPUTS_PER_CLIENT);
-    
-    // Generate batches until finished
-    // Generate batches in round-robin fashion to simulate interleaved arrival 
-    // This provides a fairer comparison by ordering inputs roughly by time
-    bool anyActive = true;
-    while (anyActive) {
-        anyActive = false;
-        for (int i = 0; i < NUM_CLIENTS; ++i) {
-            Client* client = clientManager.getClient(i);
-            if (!client->isFinished()) {
-                // Use smaller batch size (same as parallel) to interleave inputs finely
-                auto batch = client->generateBatch(50);
-                allInputs.insert(allInputs.end(), batch.begin(), batch.end());
-                
-                if (!client->isFinished()) {
-                    anyActive = true;
-                }
-            }
-        }
-    }
-    
-    std::cout << "  [Sequential] Processing " << allInputs.size() << " inputs..." << std::endl;
-
-    // 2. Process
-    GameServer server(NUM_MATCHES);
-    server.start();
-    server.receiveInputs(allInputs);
-    
-    auto start = high_resolution_clock::now();
-    server.processAllSequential();
-    auto end = high_resolution_clock::now();
-    
-    result.timeMs = duration_cast<microseconds>(end - start).count() / 1000.0;
-    result.processedInputs = server.getProcessedCount();
-    result.rollbackCount = server.getTotalRollbackCount();
-    result.workSteals = 0;
-    
-    return result;
+void printSeparator() {
+    std::cout << std::string(50, '=') << std::endl;
 }
 
-/**
- * Run task-based concurrent benchmark
- * Pipeline: Client Task (Gen) -> Server (Queue) -> Match Task (Process)
- */
-BenchmarkResult runConcurrentBenchmark(size_t numThreads) {
-    BenchmarkResult result = {};
-    
-    GameServer server(NUM_MATCHES);
-    ThreadPool pool(numThreads);
-    server.start();
-    
-    ClientManager clientManager(NUM_CLIENTS, NUM_MATCHES, INPUTS_PER_CLIENT);
-    
-    std::atomic<int> clientsFinished{0};
-    
-    auto start = high_resolution_clock::now();
-    
-    // 1. Submit initial Client Tasks
-    for (int i = 0; i < NUM_CLIENTS; ++i) {
-        pool.submit([&clientManager, &server, &pool, &clientsFinished, i]() {
-            // Self-replicating Client Task
-            struct ClientTask {
-                Client* client;
-                GameServer* server;
-                ThreadPool* pool;
-                std::atomic<int>* clientsFinished;
-                
-                void operator()() {
-                    // Generate small batch to simulate continuous input
-                    // Batch size small enough to cause frequent task switching but large enough for efficiency
-                    auto batch = client->generateBatch(50); 
-                    
-                    if (!batch.empty()) {
-                        server->receiveInputs(batch);
-                    }
-                    
-                    if (!client->isFinished()) {
-                        // Re-submit self
-                        pool->submit(*this);
-                    } else {
-                        clientsFinished->fetch_add(1, std::memory_order_relaxed);
-                    }
-                }
-            };
-            
-            ClientTask{clientManager.getClient(i), &server, &pool, &clientsFinished}();
-        });
-    }
-    
-    // 2. Submit Match Processing Tasks
-    // These run continuously until all clients are done AND queues are empty
-    for (int i = 0; i < NUM_MATCHES; ++i) {
-        pool.submit([&server, &pool, &clientsFinished, i]() {
-            // Self-replicating Match Task
-            struct MatchTask {
-                int matchId;
-                GameServer* server;
-                ThreadPool* pool;
-                std::atomic<int>* clientsFinished;
-                
-                void operator()() {
-                    // Process what's available
-                    server->processPending(matchId);
-                    
-                    // Check termination condition
-                    bool allClientsDone = clientsFinished->load(std::memory_order_relaxed) == NUM_CLIENTS;
-                    bool queueEmpty = server->getPendingCount() == 0; // Optimization: Could check specific queue
-                    
-                    if (!allClientsDone || !queueEmpty) {
-                        // Keep running
-                        // Yield to let other tasks run if we didn't find work? 
-                        // ThreadPool handles scheduling, so just resubmit.
-                        pool->submit(*this);
-                    }
-                }
-            };
-            
-            MatchTask{i, &server, &pool, &clientsFinished}();
-        });
+void printMetrics(const metrics::MetricsSnapshot& snapshot) {
+    using metrics::Histogram;
+    
+    auto printHistogram = [&snapshot](const char* label, Histogram h, double scale, const char* unit) {
+        const metrics::HistogramSnapshot& hist = snapshot[h];
+        std::cout << "  " << label << "p50 " << hist.percentile(0.50) / scale
+                  << " / p99 " << hist.percentile(0.99) / scale
+                  << " / p999 " << hist.percentile(0.999) / scale
+                  << " / max " << hist.max() / scale << " " << unit
+                  << " (n=" << hist.count() << ")" << std::endl;
+    };
+    printHistogram("Enq->Proc:   ", Histogram::ENQUEUE_TO_PROCESS_NS, 1000.0, "us");
+    printHistogram("Queue Wait:  ", Histogram::TASK_QUEUE_WAIT_NS, 1000.0, "us");
+    printHistogram("Drain Batch: ", Histogram::DRAIN_BATCH_SIZE, 1.0, "inputs");
+    printHistogram("Client Send: ", Histogram::PRODUCER_BATCH_SIZE, 1.0, "inputs");
+    printHistogram("Replay:      ", Histogram::ROLLBACK_REPLAY_TICKS, 1.0, "ticks");
+    printHistogram("Replay Cost: ", Histogram::ROLLBACK_REPLAY_NS, 1000.0, "us");
+    
+    std::cout << "  Tasks/Thread:";
+    for (const auto& row : snapshot.perThread) {
+        uint64_t tasks = row[static_cast<size_t>(metrics::Counter::TASKS_RUN)];
+        if (tasks > 0) std::cout << " " << tasks;
     }
-    
-    // Wait for everything to drain
-    pool.waitAll();
-    
-    auto end = high_resolution_clock::now();
-    
-    result.timeMs = duration_cast<microseconds>(end - start).count() / 1000.0;
-    result.processedInputs = server.getProcessedCount();
-    result.rollbackCount = server.getTotalRollbackCount();
-    result.workSteals = pool.getStealCount();
-    
-    return result;
+    std::cout << std::endl;
 }
 
-void printSeparator() {
-    std::cout << std::string(50, '=') << std::endl;
+void printParallelResult(const BenchmarkResult& result, double sequentialTimeMs) {
+    double speedup = sequentialTimeMs / result.timeMs;
+    
+    std::cout << "  Time:        " << result.timeMs << " ms" << std::endl;
+    std::cout << "  Processed:   " << result.processedInputs << " inputs" << std::endl;
+    std::cout << "  Rollbacks:   " << result.rollbackCount << std::endl;
+    std::cout << "  Late Inputs: " << result.lateInputs << " (" << result.expiredInputs << " expired)" << std::endl;
+    std::cout << "  Work Steals: " << result.workSteals << std::endl;
+    std::cout << "  Task Allocs: " << result.taskHeapAllocs << " heap / "
+              << result.taskRecycled << " recycled" << std::endl;
+    std::cout << "  Parks:       " << result.workerParks << std::endl;
+    std::cout << "  Affinity:    " << result.affineHomeRuns << " home / "
+              << result.affineAwayRuns << " away" << std::endl;
+    std::cout << "  Match Tasks: " << result.matchTasks << std::endl;
+    std::cout << "  Throughput:  " << (result.processedInputs / result.timeMs * 1000) 
+              << " inputs/sec" << std::endl;
+    std::cout << "  Speedup:     " << speedup << "x" << std::endl;
+    if (metrics::ENABLED) {
+        printMetrics(result.metrics);
+    }
 }
 
 int main() {
@@ -189,18 +84,33 @@ int main() {
     std::cout << "  Rollback Every:   " << ROLLBACK_INTERVAL << " ticks" << std::endl;
     std::cout << "  Hardware Threads: " << std::thread::hardware_concurrency() << std::endl;
     
+    // Every mode replays the same traffic, generated once up front
+    BenchmarkConfig config;
+    size_t generatorThreads = std::max<size_t>(std::thread::hardware_concurrency(), 1);
+    PregeneratedTraffic traffic = [&]() {
+        ThreadPool generatorPool(generatorThreads);
+        return PregeneratedTraffic::generate(config, generatorPool);
+    }();
+    std::cout << "  Generation:       " << traffic.generationMs() << " ms ("
+              << traffic.totalInputs() << " inputs, " << generatorThreads << " threads)" << std::endl;
+    
     // Sequential Benchmark
     printSeparator();
     std::cout << "  SEQUENTIAL MODE (Baseline)" << std::endl;
     printSeparator();
     
-    BenchmarkResult seqResult = runSequentialBenchmark();
+    std::cout << "  [Sequential] Processing " << traffic.totalInputs() << " inputs..." << std::endl;
+    BenchmarkResult seqResult = runSequentialBenchmark(config, traffic);
     
     std::cout << "  Time:        " << seqResult.timeMs << " ms" << std::endl;
     std::cout << "  Processed:   " << seqResult.processedInputs << " inputs" << std::endl;
     std::cout << "  Rollbacks:   " << seqResult.rollbackCount << std::endl;
+    std::cout << "  Late Inputs: " << seqResult.lateInputs << " (" << seqResult.expiredInputs << " expired)" << std::endl;
     std::cout << "  Throughput:  " << (seqResult.processedInputs / seqResult.timeMs * 1000) 
               << " inputs/sec" << std::endl;
+    if (metrics::ENABLED) {
+        printMetrics(seqResult.metrics);
+    }
     
     // Parallel Benchmarks with different thread counts
     std::vector<size_t> threadCounts = {2, 3, 4, 5, 6, 7, 8};
@@ -216,20 +126,38 @@ int main() {
         std::cout << "  PARALLEL PIPELINE TASK MODE (" << numThreads << " threads)" << std::endl;
         printSeparator();
         
-        BenchmarkResult parResult = runConcurrentBenchmark(numThreads);
+        BenchmarkResult parResult = runConcurrentBenchmark(config, traffic, numThreads, false);
         parallelResults.push_back(parResult);
+        printParallelResult(parResult, seqResult.timeMs);
+    }
+    
+    // Same pipeline, clients writing straight into per-player SPSC rings
+    std::vector<BenchmarkResult> directResults;
+    
+    for (size_t numThreads : threadCounts) {
+        printSeparator();
+        std::cout << "  PARALLEL DIRECT INPUT MODE (" << numThreads << " threads)" << std::endl;
+        printSeparator();
         
-        double speedup = seqResult.timeMs / parResult.timeMs;
-        
-        std::cout << "  Time:        " << parResult.timeMs << " ms" << std::endl;
-        std::cout << "  Processed:   " << parResult.processedInputs << " inputs" << std::endl;
-        std::cout << "  Rollbacks:   " << parResult.rollbackCount << std::endl;
-        std::cout << "  Work Steals: " << parResult.workSteals << std::endl;
-        std::cout << "  Throughput:  " << (parResult.processedInputs / parResult.timeMs * 1000) 
-                  << " inputs/sec" << std::endl;
-        std::cout << "  Speedup:     " << speedup << "x" << std::endl;
+        BenchmarkResult directResult = runConcurrentBenchmark(config, traffic, numThreads, true);
+        directResults.push_back(directResult);
+        printParallelResult(directResult, seqResult.timeMs);
     }
     
+    // Matches split across independent servers, one per NUMA node
+    constexpr size_t SHARDED_THREADS = 8;
+    std::vector<NumaNode> nodes = detectNumaNodes();
+    
+    printSeparator();
+    std::cout << "  SHARDED MODE (" << nodes.size() << " shards, " << SHARDED_THREADS << " threads)" << std::endl;
+    printSeparator();
+    for (const NumaNode& node : nodes) {
+        std::cout << "  Node " << node.id << ":      " << node.cpus.size() << " CPUs" << std::endl;
+    }
+    
+    BenchmarkResult shardedResult = runShardedBenchmark(config, traffic, SHARDED_THREADS);
+    printParallelResult(shardedResult, seqResult.timeMs);
+    
     // Summary
     printSeparator();
     std::cout << "  SUMMARY" << std::endl;
@@ -248,6 +176,61 @@ int main() {
                   << std::setw(6) << parallelResults[i].workSteals << std::endl;
     }
     
+    for (size_t i = 0; i < threadCounts.size(); ++i) {
+        double speedup = seqResult.timeMs / directResults[i].timeMs;
+        std::cout << "  Direct   (" << std::setw(2) << threadCounts[i] << "T)  | " 
+                  << std::setw(9) << directResults[i].timeMs 
+                  << " | " << std::setw(6) << speedup << "x | " 
+                  << std::setw(6) << directResults[i].workSteals << std::endl;
+    }
+    
+    std::cout << "  Sharded  (" << std::setw(2) << SHARDED_THREADS << "T)  | "
+              << std::setw(9) << shardedResult.timeMs
+              << " | " << std::setw(6) << seqResult.timeMs / shardedResult.timeMs << "x | "
+              << std::setw(6) << shardedResult.workSteals << std::endl;
+    
+    // Real-time: fixed tick rate instead of draining as fast as possible
+    constexpr size_t TICK_LOOP_THREADS = 4;
+    const int tickRates[] = {60, 128};
+    
+    for (int hz : tickRates) {
+        printSeparator();
+        std::cout << "  REAL-TIME TICK LOOP (" << hz << " Hz, " << TICK_LOOP_THREADS << " threads)" << std::endl;
+        printSeparator();
+        
+        TickLoopStats tickStats = runTickLoopBenchmark(config, TICK_LOOP_THREADS, hz, milliseconds(1000));
+        
+        std::cout << "  Ticks:       " << tickStats.ticks << " (budget "
+                  << 1000.0 / hz << " ms)" << std::endl;
+        std::cout << "  Latency:     p50 " << tickStats.p50Ms << " / p99 " << tickStats.p99Ms
+                  << " / p999 " << tickStats.p999Ms << " / max " << tickStats.maxMs << " ms" << std::endl;
+        std::cout << "  Missed:      " << tickStats.missedDeadlines << " ticks" << std::endl;
+        std::cout << "  Overruns:    " << tickStats.matchOverruns << " match tasks" << std::endl;
+    }
+    
+    // Network hiccups: every client goes quiet, then all their inputs arrive late at once
+    BenchmarkConfig hiccupConfig = config;
+    hiccupConfig.hiccupEvery = 30;
+    hiccupConfig.hiccupTicks = 8;
+    
+    for (bool storms : {false, true}) {
+        printSeparator();
+        std::cout << "  ROLLBACK STORM (60 Hz, hiccup every " << hiccupConfig.hiccupEvery << " ticks, "
+                  << (storms ? "storm passes" : "inline replays") << ")" << std::endl;
+        printSeparator();
+        
+        hiccupConfig.rollbackStorms = storms;
+        TickLoopStats tickStats = runTickLoopBenchmark(hiccupConfig, TICK_LOOP_THREADS, 60, milliseconds(1000));
+        
+        std::cout << "  Ticks:       " << tickStats.ticks << std::endl;
+        std::cout << "  Latency:     p50 " << tickStats.p50Ms << " / p99 " << tickStats.p99Ms
+                  << " / max " << tickStats.maxMs << " ms" << std::endl;
+        std::cout << "  Rollbacks:   " << tickStats.rollbacks << std::endl;
+        std::cout << "  Storms:      " << tickStats.stormTicks << " ticks, "
+                  << tickStats.stormReplays << " replays" << std::endl;
+        std::cout << "  Missed:      " << tickStats.missedDeadlines << " ticks" << std::endl;
+    }
+    
     std::cout << "\n";
     printSeparator();
     std::cout << "  DEMO COMPLETE" << std::endl;
@@ -0,0 +1,69 @@
+#ifndef DATAGRAM_HPP
+#define DATAGRAM_HPP
+
+#include "../common/data_structures.hpp"
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+namespace para {
+
+// ============================================
+// Input datagrams - Client -> UdpIngest wire format
+// ============================================
+// One UDP datagram carries one client batch:
+//
+//   DatagramHeader (16 bytes) | count x PackedInput (4 bytes each)
+//
+// The inputs are PackedInput words exactly as GameServer::receiveInputs()
+// takes them, so a receiver scatters the payload straight into its input
+// buffer and routes it without decoding. Fields are in host byte order:
+// the format is meant for loopback and same-architecture clusters.
+constexpr uint32_t DATAGRAM_MAGIC = 0x50524131;  // "PRA1"
+constexpr uint16_t DATAGRAM_VERSION = 1;
+
+// Largest batch per datagram (1 KiB of inputs, well under a 1500-byte MTU)
+constexpr size_t MAX_DATAGRAM_INPUTS = 256;
+
+struct DatagramHeader {
+    uint32_t magic;
+    uint16_t version;
+    uint16_t count;    // Inputs in the payload
+    uint64_t sentNs;   // datagramClockNs() when sent, for latency
+};
+
+static_assert(sizeof(DatagramHeader) == 16, "DatagramHeader must stay 16 bytes");
+
+constexpr size_t MAX_DATAGRAM_BYTES = sizeof(DatagramHeader) + MAX_DATAGRAM_INPUTS * sizeof(PackedInput);
+
+// Sender and receiver clock (same host: steady_clock)
+inline uint64_t datagramClockNs() {
+    return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count());
+}
+
+/**
+ * Write the datagram for count (<= MAX_DATAGRAM_INPUTS) inputs into out
+ * (MAX_DATAGRAM_BYTES); returns its size in bytes
+ */
+inline size_t encodeDatagram(unsigned char* out, const PackedInput* inputs, size_t count, uint64_t sentNs) {
+    DatagramHeader header{DATAGRAM_MAGIC, DATAGRAM_VERSION, static_cast<uint16_t>(count), sentNs};
+    std::memcpy(out, &header, sizeof(header));
+    std::memcpy(out + sizeof(header), inputs, count * sizeof(PackedInput));
+    return sizeof(header) + count * sizeof(PackedInput);
+}
+
+/**
+ * A received datagram of bytes bytes is well formed: known magic and
+ * version, and exactly header.count inputs after the header
+ */
+inline bool validDatagram(const DatagramHeader& header, size_t bytes) {
+    return bytes >= sizeof(DatagramHeader) && header.magic == DATAGRAM_MAGIC &&
+           header.version == DATAGRAM_VERSION && header.count <= MAX_DATAGRAM_INPUTS &&
+           bytes == sizeof(DatagramHeader) + header.count * sizeof(PackedInput);
+}
+
+} // namespace para
+
+#endif // DATAGRAM_HPP
@@ -0,0 +1,301 @@
+#include "udp_ingest.hpp"
+#include "../game/game_server.hpp"
+#include "../game/sharded_server.hpp"
+#include <array>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+
+#ifdef __linux__
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#include <cerrno>
+#endif
+
+namespace para {
+
+#ifdef __linux__
+
+namespace {
+
+// Single-writer counter bump (no locked RMW; readers load relaxed)
+void bump(std::atomic<uint64_t>& counter, uint64_t amount) {
+    counter.store(counter.load(std::memory_order_relaxed) + amount, std::memory_order_relaxed);
+}
+
+} // namespace
+
+// ============================================
+// IoThread - One receiving thread's socket, epoll set and buffers
+// ============================================
+struct UdpIngest::IoThread {
+    int socketFd = -1;
+    int epollFd = -1;
+    
+    // recvmmsg targets: datagram k's header goes to headers[k], its payload
+    // to inputs[k * MAX_DATAGRAM_INPUTS]
+    std::vector<PackedInput> inputs = std::vector<PackedInput>(RECV_BATCH * MAX_DATAGRAM_INPUTS);
+    std::array<DatagramHeader, RECV_BATCH> headers{};
+    std::array<iovec, 2 * RECV_BATCH> iov{};
+    std::array<mmsghdr, RECV_BATCH> messages{};
+    
+    // Written by the thread only
+    std::atomic<uint64_t> datagrams{0};
+    std::atomic<uint64_t> inputCount{0};
+    std::atomic<uint64_t> rejected{0};
+    std::atomic<uint64_t> receiveCalls{0};
+    metrics::LatencyHistogram latencyNs;
+    
+    IoThread() {
+        for (int k = 0; k < RECV_BATCH; ++k) {
+            iov[2 * k] = {&headers[k], sizeof(DatagramHeader)};
+            iov[2 * k + 1] = {&inputs[static_cast<size_t>(k) * MAX_DATAGRAM_INPUTS],
+                              MAX_DATAGRAM_INPUTS * sizeof(PackedInput)};
+            messages[k].msg_hdr.msg_iov = &iov[2 * k];
+            messages[k].msg_hdr.msg_iovlen = 2;
+        }
+    }
+    
+    ~IoThread() {
+        if (epollFd >= 0) ::close(epollFd);
+        if (socketFd >= 0) ::close(socketFd);
+    }
+};
+
+bool UdpIngest::isSupported() {
+    return true;
+}
+
+UdpIngest::UdpIngest(void* server, Sink sink, const UdpIngestConfig& config)
+    : server_(server)
+    , sink_(sink)
+{
+    if (config.ioThreads <= 0) {
+        throw std::invalid_argument("UdpIngest: ioThreads must be positive");
+    }
+    
+    stopFd_ = ::eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (stopFd_ < 0) {
+        throw std::runtime_error("UdpIngest: cannot create the stop eventfd");
+    }
+    
+    // io_ owns every socket made so far, so a throw below closes them
+    port_ = config.port;
+    for (int i = 0; i < config.ioThreads; ++i) {
+        io_.push_back(std::make_unique<IoThread>());
+        IoThread& io = *io_.back();
+        
+        io.socketFd = ::socket(AF_INET, SOCK_DGRAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+        if (io.socketFd < 0) {
+            ::close(stopFd_);
+            throw std::runtime_error("UdpIngest: cannot create a UDP socket");
+        }
+        int on = 1;
+        ::setsockopt(io.socketFd, SOL_SOCKET, SO_REUSEPORT, &on, sizeof(on));
+        
+        // SO_RCVBUFFORCE passes rmem_max when privileged; SO_RCVBUF is capped by it
+        int bufferBytes = config.socketBufferBytes;
+        if (bufferBytes > 0 &&
+            ::setsockopt(io.socketFd, SOL_SOCKET, SO_RCVBUFFORCE, &bufferBytes, sizeof(bufferBytes)) != 0) {
+            ::setsockopt(io.socketFd, SOL_SOCKET, SO_RCVBUF, &bufferBytes, sizeof(bufferBytes));
+        }
+        
+        sockaddr_in address{};
+        address.sin_family = AF_INET;
+        address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        address.sin_port = htons(port_);
+        if (::bind(io.socketFd, reinterpret_cast<const sockaddr*>(&address), sizeof(address)) != 0) {
+            ::close(stopFd_);
+            throw std::runtime_error("UdpIngest: cannot bind 127.0.0.1:" + std::to_string(port_));
+        }
+        
+        // The first socket picks the port when asked for any; the rest share it
+        if (port_ == 0) {
+            socklen_t length = sizeof(address);
+            ::getsockname(io.socketFd, reinterpret_cast<sockaddr*>(&address), &length);
+            port_ = ntohs(address.sin_port);
+        }
+        
+        io.epollFd = ::epoll_create1(EPOLL_CLOEXEC);
+        epoll_event readable{};
+        readable.events = EPOLLIN;
+        readable.data.fd = io.socketFd;
+        epoll_event stopping{};
+        stopping.events = EPOLLIN;
+        stopping.data.fd = stopFd_;
+        if (io.epollFd < 0 ||
+            ::epoll_ctl(io.epollFd, EPOLL_CTL_ADD, io.socketFd, &readable) != 0 ||
+            ::epoll_ctl(io.epollFd, EPOLL_CTL_ADD, stopFd_, &stopping) != 0) {
+            ::close(stopFd_);
+            throw std::runtime_error("UdpIngest: cannot set up epoll");
+        }
+    }
+}
+
+UdpIngest::~UdpIngest() {
+    stop();
+    io_.clear();
+    if (stopFd_ >= 0) ::close(stopFd_);
+}
+
+void UdpIngest::start() {
+    if (running_.exchange(true)) return;
+    
+    // Clear a previous stop()
+    uint64_t pending;
+    while (::read(stopFd_, &pending, sizeof(pending)) > 0) {
+    }
+    for (auto& io : io_) {
+        IoThread* thread = io.get();
+        threads_.emplace_back([this, thread]() { run(*thread); });
+    }
+}
+
+void UdpIngest::stop() {
+    if (!running_.exchange(false)) return;
+    
+    // Level-triggered: the eventfd stays readable, so every thread sees it
+    uint64_t one = 1;
+    while (::write(stopFd_, &one, sizeof(one)) < 0 && errno == EINTR) {
+    }
+    for (std::thread& thread : threads_) {
+        thread.join();
+    }
+    threads_.clear();
+}
+
+void UdpIngest::run(IoThread& io) {
+    std::array<epoll_event, 2> events;
+    while (true) {
+        int ready = ::epoll_wait(io.epollFd, events.data(), static_cast<int>(events.size()), -1);
+        if (ready < 0) {
+            if (errno == EINTR) continue;
+            return;
+        }
+        
+        bool readable = false;
+        for (int e = 0; e < ready; ++e) {
+            if (events[e].data.fd == stopFd_) return;
+            readable = true;
+        }
+        if (!readable) continue;
+        
+        // A full batch means more may be queued: keep taking until short
+        int received;
+        do {
+            received = ::recvmmsg(io.socketFd, io.messages.data(), RECV_BATCH, MSG_DONTWAIT, nullptr);
+            if (received <= 0) break;
+            route(io, received);
+        } while (received == RECV_BATCH);
+    }
+}
+
+size_t UdpIngest::route(IoThread& io, int received) {
+    std::array<uint64_t, RECV_BATCH> sentNs;
+    int valid = 0;
+    size_t packed = 0;
+    
+    // Close the gaps between payloads in place (each moves left, never over
+    // a payload still to come)
+    for (int k = 0; k < received; ++k) {
+        const DatagramHeader& header = io.headers[k];
+        const mmsghdr& message = io.messages[k];
+        if ((message.msg_hdr.msg_flags & MSG_TRUNC) || !validDatagram(header, message.msg_len)) {
+            bump(io.rejected, 1);
+            continue;
+        }
+        
+        size_t slot = static_cast<size_t>(k) * MAX_DATAGRAM_INPUTS;
+        if (packed != slot) {
+            std::memmove(&io.inputs[packed], &io.inputs[slot], header.count * sizeof(PackedInput));
+        }
+        packed += header.count;
+        sentNs[valid++] = header.sentNs;
+    }
+    
+    if (packed > 0) {
+        sink_(server_, io.inputs.data(), packed);
+    }
+    
+    uint64_t routedNs = datagramClockNs();
+    for (int k = 0; k < valid; ++k) {
+        io.latencyNs.record(routedNs > sentNs[k] ? routedNs - sentNs[k] : 0);
+    }
+    bump(io.datagrams, static_cast<uint64_t>(valid));
+    bump(io.inputCount, packed);
+    bump(io.receiveCalls, 1);
+    return packed;
+}
+
+UdpIngestStats UdpIngest::getStats() const {
+    UdpIngestStats stats{};
+    for (const auto& io : io_) {
+        stats.datagrams += io->datagrams.load(std::memory_order_relaxed);
+        stats.inputs += io->inputCount.load(std::memory_order_relaxed);
+        stats.rejected += io->rejected.load(std::memory_order_relaxed);
+        stats.receiveCalls += io->receiveCalls.load(std::memory_order_relaxed);
+        stats.latencyNs.merge(io->latencyNs);
+    }
+    return stats;
+}
+
+#else
+
+// ============================================
+// Other platforms: no epoll / recvmmsg
+// ============================================
+struct UdpIngest::IoThread {
+};
+
+bool UdpIngest::isSupported() {
+    return false;
+}
+
+UdpIngest::UdpIngest(void* server, Sink sink, const UdpIngestConfig&)
+    : server_(server)
+    , sink_(sink)
+{
+    throw std::runtime_error("UdpIngest: needs Linux (epoll, recvmmsg)");
+}
+
+UdpIngest::~UdpIngest() = default;
+
+void UdpIngest::start() {}
+
+void UdpIngest::stop() {}
+
+void UdpIngest::run(IoThread&) {}
+
+size_t UdpIngest::route(IoThread&, int) {
+    return 0;
+}
+
+UdpIngestStats UdpIngest::getStats() const {
+    return UdpIngestStats{};
+}
+
+#endif
+
+UdpIngest::UdpIngest(GameServer& server, const UdpIngestConfig& config)
+    : UdpIngest(&server, [](void* target, const PackedInput* inputs, size_t count) {
+          static_cast<GameServer*>(target)->receiveInputs(inputs, count);
+      }, config)
+{
+}
+
+UdpIngest::UdpIngest(ShardedServer& server, const UdpIngestConfig& config)
+    : UdpIngest(&server, [](void* target, const PackedInput* inputs, size_t count) {
+          static_cast<ShardedServer*>(target)->receiveInputs(inputs, count);
+      }, config)
+{
+}
+
+uint16_t UdpIngest::port() const {
+    return port_;
+}
+
+} // namespace para
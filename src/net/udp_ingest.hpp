@@ -0,0 +1,104 @@
+#ifndef UDP_INGEST_HPP
+#define UDP_INGEST_HPP
+
+#include "datagram.hpp"
+#include "../common/data_structures.hpp"
+#include "../common/metrics.hpp"
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <thread>
+#include <vector>
+
+namespace para {
+
+class GameServer;
+class ShardedServer;
+
+struct UdpIngestConfig {
+    uint16_t port = 0;                     // 0: any free port (see UdpIngest::port())
+    int ioThreads = 1;                     // Receiving threads, one socket each
+    int socketBufferBytes = 8 << 20;       // SO_RCVBUF per socket (the kernel may cap it)
+};
+
+struct UdpIngestStats {
+    uint64_t datagrams;                    // Well-formed datagrams routed
+    uint64_t inputs;                       // Inputs in them
+    uint64_t rejected;                     // Malformed or truncated datagrams dropped
+    uint64_t receiveCalls;                 // recvmmsg calls that returned datagrams
+    metrics::HistogramSnapshot latencyNs;  // Per datagram: sentNs -> routed into the server
+};
+
+/**
+ * UdpIngest - UDP front end feeding a server's batch input path
+ *
+ * Runs ioThreads dedicated threads (not ThreadPool workers: simulation
+ * never waits behind a socket). Each owns an epoll set and a UDP socket
+ * bound to the same 127.0.0.1 port with SO_REUSEPORT, so the kernel
+ * spreads senders across the threads and every sender's datagrams stay in
+ * order on one of them.
+ *
+ * When the socket is readable a thread takes up to RECV_BATCH datagrams
+ * per recvmmsg call: each datagram's header lands in a header slot and its
+ * payload, already in PackedInput form, straight in the thread's input
+ * buffer. Payloads are packed together in place and the whole buffer goes
+ * to receiveInputs() in one call, which copies it into the match rings:
+ * the only copy between the socket and the rings.
+ *
+ * Linux only (epoll, recvmmsg); elsewhere isSupported() is false and the
+ * constructor throws std::runtime_error, as it does if a socket cannot be
+ * bound.
+ */
+class UdpIngest {
+public:
+    static constexpr int RECV_BATCH = 64;  // Datagrams per recvmmsg call
+    
+    static bool isSupported();
+    
+    // Bind the sockets (threads start with start())
+    UdpIngest(GameServer& server, const UdpIngestConfig& config = UdpIngestConfig());
+    
+    // Same, for inputs addressed by global match id
+    UdpIngest(ShardedServer& server, const UdpIngestConfig& config = UdpIngestConfig());
+    
+    ~UdpIngest();
+    
+    UdpIngest(const UdpIngest&) = delete;
+    UdpIngest& operator=(const UdpIngest&) = delete;
+    
+    void start();
+    
+    // Wake and join the threads; what the sockets still hold is dropped
+    void stop();
+    
+    // The bound port (the one chosen when config.port was 0)
+    uint16_t port() const;
+    
+    // Totals so far (any thread)
+    UdpIngestStats getStats() const;
+
+private:
+    using Sink = void (*)(void* server, const PackedInput* inputs, size_t count);
+    
+    struct IoThread;
+    
+    UdpIngest(void* server, Sink sink, const UdpIngestConfig& config);
+    
+    void run(IoThread& io);
+    
+    // Route one recvmmsg batch of received datagrams; returns inputs routed
+    size_t route(IoThread& io, int received);
+    
+    void* server_;
+    Sink sink_;
+    uint16_t port_ = 0;
+    int stopFd_ = -1;                      // eventfd: readable once stop() is called
+    std::vector<std::unique_ptr<IoThread>> io_;
+    std::vector<std::thread> threads_;
+    std::atomic<bool> running_{false};
+};
+
+} // namespace para
+
+#endif // UDP_INGEST_HPP
@@ -0,0 +1,172 @@
+#ifndef EVENT_COUNT_HPP
+#define EVENT_COUNT_HPP
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace para {
+
+/**
+ * EventCount - Lets idle workers park without losing wakeups
+ *
+ * Waiter protocol (waiterId identifies a per-waiter parking slot):
+ *   prepareWait(id);
+ *   if (work is visible) cancelWait(id); else commitWait(id);
+ *
+ * Notifier protocol: publish the work, then notifyOne(). When nobody is
+ * waiting, notifyOne() is a fence plus one atomic load: no lock, no syscall.
+ *
+ * The seq_cst fences in prepareWait() and notifyOne() form a Dekker pair:
+ * either the waiter sees the published work during its re-check, or the
+ * notifier sees the waiter registered and unparks it.
+ */
+class EventCount {
+public:
+    explicit EventCount(size_t numWaiters)
+        : parkers_(new Parker[numWaiters])
+    {
+        idle_.reserve(numWaiters);
+    }
+
+    EventCount(const EventCount&) = delete;
+    EventCount& operator=(const EventCount&) = delete;
+
+    /**
+     * Register as idle. Caller must re-check for work before commitWait()
+     */
+    void prepareWait(size_t waiterId) {
+        {
+            std::lock_guard<std::mutex> lock(idleMutex_);
+            idle_.push_back(waiterId);
+            waiters_.fetch_add(1, std::memory_order_relaxed);
+        }
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+    }
+
+    /**
+     * Work appeared after prepareWait(): leave the idle set
+     */
+    void cancelWait(size_t waiterId) {
+        std::lock_guard<std::mutex> lock(idleMutex_);
+        for (size_t i = 0; i < idle_.size(); ++i) {
+            if (idle_[i] == waiterId) {
+                idle_[i] = idle_.back();
+                idle_.pop_back();
+                waiters_.fetch_sub(1, std::memory_order_relaxed);
+                return;
+            }
+        }
+        // Already claimed by a notifier: its signal makes the next
+        // commitWait() return immediately, which is a harmless spurious wake
+    }
+
+    /**
+     * Park until a notifier claims this waiter
+     */
+    void commitWait(size_t waiterId) {
+        Parker& parker = parkers_[waiterId];
+        std::unique_lock<std::mutex> lock(parker.mutex);
+        if (!parker.signaled) {
+            parkCount_.fetch_add(1, std::memory_order_relaxed);
+            parker.cv.wait(lock, [&parker]() { return parker.signaled; });
+        }
+        parker.signaled = false;
+    }
+
+    /**
+     * Wake one parked waiter, if any. Returns true if one was woken
+     */
+    bool notifyOne() {
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if (waiters_.load(std::memory_order_relaxed) == 0) {
+            return false;
+        }
+
+        size_t waiterId;
+        {
+            std::lock_guard<std::mutex> lock(idleMutex_);
+            if (idle_.empty()) {
+                return false;
+            }
+            waiterId = idle_.back();
+            idle_.pop_back();
+            waiters_.fetch_sub(1, std::memory_order_relaxed);
+        }
+        signal(waiterId);
+        return true;
+    }
+
+    /**
+     * Wake every parked waiter (shutdown)
+     */
+    void notifyAll() {
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        std::vector<size_t> woken;
+        {
+            std::lock_guard<std::mutex> lock(idleMutex_);
+            woken.swap(idle_);
+            idle_.reserve(woken.capacity());
+            waiters_.store(0, std::memory_order_relaxed);
+        }
+        for (size_t waiterId : woken) {
+            signal(waiterId);
+        }
+    }
+
+    /**
+     * Number of waiters currently registered as idle (approximate)
+     */
+    size_t numWaiters() const {
+        return waiters_.load(std::memory_order_relaxed);
+    }
+
+    /**
+     * Number of times a waiter actually blocked (for statistics)
+     */
+    size_t getParkCount() const {
+        return parkCount_.load(std::memory_order_relaxed);
+    }
+
+    /**
+     * Number of wakeups delivered to parked waiters (for statistics)
+     */
+    size_t getWakeCount() const {
+        return wakeCount_.load(std::memory_order_relaxed);
+    }
+
+private:
+    // One parking slot per waiter, padded so workers don't share lines
+    struct alignas(64) Parker {
+        std::mutex mutex;
+        std::condition_variable cv;
+        bool signaled = false;
+    };
+
+    void signal(size_t waiterId) {
+        Parker& parker = parkers_[waiterId];
+        {
+            std::lock_guard<std::mutex> lock(parker.mutex);
+            parker.signaled = true;
+        }
+        parker.cv.notify_one();
+        wakeCount_.fetch_add(1, std::memory_order_relaxed);
+    }
+
+private:
+    std::unique_ptr<Parker[]> parkers_;
+
+    std::mutex idleMutex_;
+    std::vector<size_t> idle_;
+    std::atomic<size_t> waiters_{0};
+
+    std::atomic<size_t> parkCount_{0};
+    std::atomic<size_t> wakeCount_{0};
+};
+
+} // namespace para
+
+#endif // EVENT_COUNT_HPP
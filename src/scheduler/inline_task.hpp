@@ -0,0 +1,128 @@
+#ifndef INLINE_TASK_HPP
+#define INLINE_TASK_HPP
+
+#include <cstddef>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+namespace para {
+
+/**
+ * Inline Task - move-only, allocation-free replacement for std::function<void()>
+ *
+ * The callable is stored in a fixed inline buffer. Callables that do not
+ * fit are rejected at compile time instead of silently falling back to the
+ * heap, so every task submitted to the ThreadPool is allocation-free.
+ */
+template<size_t Capacity>
+class BasicInlineTask {
+public:
+    static constexpr size_t CAPACITY = Capacity;
+
+    /**
+     * True if F can be stored inline (size, alignment and noexcept move)
+     * Use in static_assert next to hot-path task types
+     */
+    template<typename F>
+    static constexpr bool fits() {
+        return sizeof(F) <= Capacity
+            && alignof(F) <= alignof(std::max_align_t)
+            && std::is_nothrow_move_constructible<F>::value;
+    }
+
+    BasicInlineTask() noexcept = default;
+
+    template<typename F,
+             typename Fn = std::decay_t<F>,
+             typename = std::enable_if_t<!std::is_same<Fn, BasicInlineTask>::value>>
+    BasicInlineTask(F&& f) {
+        static_assert(fits<Fn>(), "Callable does not fit in the inline task buffer");
+        ::new (static_cast<void*>(&storage_)) Fn(std::forward<F>(f));
+        ops_ = &opsFor<Fn>;
+    }
+
+    BasicInlineTask(BasicInlineTask&& other) noexcept {
+        moveFrom(other);
+    }
+
+    BasicInlineTask& operator=(BasicInlineTask&& other) noexcept {
+        if (this != &other) {
+            reset();
+            moveFrom(other);
+        }
+        return *this;
+    }
+
+    BasicInlineTask(const BasicInlineTask&) = delete;
+    BasicInlineTask& operator=(const BasicInlineTask&) = delete;
+
+    ~BasicInlineTask() {
+        reset();
+    }
+
+    void operator()() {
+        ops_->invoke(&storage_);
+    }
+
+    explicit operator bool() const noexcept {
+        return ops_ != nullptr;
+    }
+
+    /**
+     * Destroy the stored callable (if any)
+     */
+    void reset() noexcept {
+        if (ops_) {
+            ops_->destroy(&storage_);
+            ops_ = nullptr;
+        }
+    }
+
+private:
+    struct Ops {
+        void (*invoke)(void* self);
+        void (*move)(void* dst, void* src) noexcept;
+        void (*destroy)(void* self) noexcept;
+    };
+
+    template<typename Fn>
+    static void invokeImpl(void* self) {
+        (*static_cast<Fn*>(self))();
+    }
+
+    template<typename Fn>
+    static void moveImpl(void* dst, void* src) noexcept {
+        ::new (dst) Fn(std::move(*static_cast<Fn*>(src)));
+        static_cast<Fn*>(src)->~Fn();
+    }
+
+    template<typename Fn>
+    static void destroyImpl(void* self) noexcept {
+        static_cast<Fn*>(self)->~Fn();
+    }
+
+    template<typename Fn>
+    static constexpr Ops opsFor = { &invokeImpl<Fn>, &moveImpl<Fn>, &destroyImpl<Fn> };
+
+    void moveFrom(BasicInlineTask& other) noexcept {
+        if (other.ops_) {
+            other.ops_->move(&storage_, &other.storage_);
+            ops_ = other.ops_;
+            other.ops_ = nullptr;
+        }
+    }
+
+private:
+    alignas(std::max_align_t) unsigned char storage_[Capacity];
+    const Ops* ops_ = nullptr;
+};
+
+// Room for six pointers of captures (the benchmark's task functors use four)
+constexpr size_t TASK_INLINE_CAPACITY = 48;
+
+using InlineTask = BasicInlineTask<TASK_INLINE_CAPACITY>;
+
+} // namespace para
+
+#endif // INLINE_TASK_HPP
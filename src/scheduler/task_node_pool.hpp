@@ -0,0 +1,193 @@
+#ifndef TASK_NODE_POOL_HPP
+#define TASK_NODE_POOL_HPP
+
+#include "inline_task.hpp"
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace para {
+
+class TaskGroup;
+
+/**
+ * TaskNode - Heap cell holding one queued task
+ *
+ * Deques store TaskNode pointers (their slots must be trivially copyable);
+ * `next` links nodes in free lists and worker inboxes.
+ */
+struct TaskNode {
+    static constexpr size_t NO_HOME = static_cast<size_t>(-1);
+    
+    InlineTask task;
+    TaskNode* next = nullptr;
+    size_t homeWorker = NO_HOME;  // Set by ThreadPool::submitAffine
+    TaskGroup* group = nullptr;   // Set by TaskGroup::run (not counted by waitAll)
+#ifdef PARA_ENABLE_METRICS
+    uint64_t submitNs = 0;        // metrics::sampledNow() at submission
+#endif
+};
+
+/**
+ * Allocation statistics for task nodes
+ */
+struct TaskAllocationStats {
+    size_t heapAllocations;  // Nodes obtained with operator new
+    size_t recycled;         // Nodes reused from a free list
+};
+
+/**
+ * TaskNodePool - Recycles task nodes so steady-state submission never allocates
+ *
+ * Each worker owns a private free list (no synchronization). Lists that grow
+ * past LOCAL_CACHE_LIMIT spill half of their nodes into a shared, locked
+ * list; empty lists refill from it in batches. Threads that are not pool
+ * workers use the shared list directly.
+ */
+class TaskNodePool {
+public:
+    static constexpr size_t NO_WORKER = static_cast<size_t>(-1);
+    static constexpr size_t LOCAL_CACHE_LIMIT = 256;
+    static constexpr size_t REFILL_BATCH = 32;
+
+    explicit TaskNodePool(size_t numWorkers)
+        : caches_(numWorkers)
+    {
+    }
+
+    ~TaskNodePool() {
+        for (auto& cache : caches_) {
+            freeList(cache.head);
+        }
+        freeList(sharedHead_);
+    }
+
+    TaskNodePool(const TaskNodePool&) = delete;
+    TaskNodePool& operator=(const TaskNodePool&) = delete;
+
+    /**
+     * Get an empty node; workerId is the calling worker or NO_WORKER
+     */
+    TaskNode* acquire(size_t workerId) {
+        if (workerId != NO_WORKER) {
+            LocalCache& cache = caches_[workerId];
+            if (!cache.head) {
+                refill(cache);
+            }
+            if (cache.head) {
+                TaskNode* node = pop(cache.head);
+                --cache.count;
+                cache.recycled.store(cache.recycled.load(std::memory_order_relaxed) + 1,
+                                     std::memory_order_relaxed);
+                return node;
+            }
+        } else {
+            std::lock_guard<std::mutex> lock(sharedMutex_);
+            if (sharedHead_) {
+                --sharedCount_;
+                sharedRecycled_++;
+                return pop(sharedHead_);
+            }
+        }
+
+        heapAllocations_.fetch_add(1, std::memory_order_relaxed);
+        return new TaskNode();
+    }
+
+    /**
+     * Return a node whose task has already been reset
+     */
+    void release(TaskNode* node, size_t workerId) {
+        if (workerId != NO_WORKER) {
+            LocalCache& cache = caches_[workerId];
+            push(cache.head, node);
+            if (++cache.count > LOCAL_CACHE_LIMIT) {
+                spill(cache);
+            }
+        } else {
+            std::lock_guard<std::mutex> lock(sharedMutex_);
+            push(sharedHead_, node);
+            ++sharedCount_;
+        }
+    }
+
+    /**
+     * Get allocation statistics (approximate while workers are running)
+     */
+    TaskAllocationStats getStats() const {
+        TaskAllocationStats stats;
+        stats.heapAllocations = heapAllocations_.load(std::memory_order_relaxed);
+        stats.recycled = 0;
+        for (const auto& cache : caches_) {
+            stats.recycled += cache.recycled.load(std::memory_order_relaxed);
+        }
+        {
+            std::lock_guard<std::mutex> lock(sharedMutex_);
+            stats.recycled += sharedRecycled_;
+        }
+        return stats;
+    }
+
+private:
+    // Owned by one worker; padded to avoid false sharing between workers
+    struct alignas(64) LocalCache {
+        TaskNode* head = nullptr;
+        size_t count = 0;
+        std::atomic<size_t> recycled{0};  // Written by owner, read by getStats()
+    };
+
+    static TaskNode* pop(TaskNode*& head) {
+        TaskNode* node = head;
+        head = node->next;
+        node->next = nullptr;
+        return node;
+    }
+
+    static void push(TaskNode*& head, TaskNode* node) {
+        node->next = head;
+        head = node;
+    }
+
+    static void freeList(TaskNode* head) {
+        while (head) {
+            TaskNode* next = head->next;
+            delete head;
+            head = next;
+        }
+    }
+
+    void refill(LocalCache& cache) {
+        std::lock_guard<std::mutex> lock(sharedMutex_);
+        for (size_t i = 0; i < REFILL_BATCH && sharedHead_; ++i) {
+            push(cache.head, pop(sharedHead_));
+            --sharedCount_;
+            ++cache.count;
+        }
+    }
+
+    void spill(LocalCache& cache) {
+        std::lock_guard<std::mutex> lock(sharedMutex_);
+        while (cache.count > LOCAL_CACHE_LIMIT / 2) {
+            push(sharedHead_, pop(cache.head));
+            --cache.count;
+            ++sharedCount_;
+        }
+    }
+
+private:
+    std::vector<LocalCache> caches_;
+
+    mutable std::mutex sharedMutex_;
+    TaskNode* sharedHead_ = nullptr;
+    size_t sharedCount_ = 0;
+    size_t sharedRecycled_ = 0;
+
+    std::atomic<size_t> heapAllocations_{0};
+};
+
+} // namespace para
+
+#endif // TASK_NODE_POOL_HPP
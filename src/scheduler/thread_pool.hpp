@@ -2,40 +2,151 @@
 #define THREAD_POOL_HPP
 
 #include "work_stealing_queue.hpp"
+#include "inline_task.hpp"
+#include "task_node_pool.hpp"
+#include "event_count.hpp"
+#include "../common/metrics.hpp"
+#include "../common/cpu_topology.hpp"
 #include <vector>
 #include <thread>
-#include <functional>
+#include <algorithm>
 #include <atomic>
 #include <random>
 #include <condition_variable>
 #include <memory>
+#include <mutex>
+#include <type_traits>
 
 namespace para {
 
+class ThreadPool;
+
+/**
+ * TaskGroup - A set of pool tasks that can be waited on by itself
+ *
+ * run() and runAffine() submit like ThreadPool::submit() and submitAffine(),
+ * but the tasks are counted by the group instead of the pool: waitAll()
+ * does not see them, and wait() only waits for this group's tasks.
+ *
+ * wait() executes queued tasks (the caller's own, then stolen ones) until
+ * the group is done, so a pool task may run a group of children and wait
+ * for them without giving up its worker. A thread outside the pool helps
+ * for a few rounds, then sleeps until the last task finishes. Any queued
+ * task may run inside wait(), so tasks must not block on something the
+ * waiting thread only does after wait() returns.
+ *
+ * Tasks may add more tasks to their own group. The destructor waits.
+ */
+class TaskGroup {
+public:
+    explicit TaskGroup(ThreadPool& pool)
+        : pool_(pool)
+    {
+    }
+    
+    ~TaskGroup() {
+        wait();
+    }
+    
+    TaskGroup(const TaskGroup&) = delete;
+    TaskGroup& operator=(const TaskGroup&) = delete;
+    
+    void run(InlineTask task);
+    
+    // On the home worker of `key`, like ThreadPool::submitAffine()
+    void runAffine(size_t key, InlineTask task);
+    
+    void wait();
+    
+    /**
+     * Tasks submitted and not finished yet (approximate)
+     */
+    size_t pending() const {
+        return pending_.load(std::memory_order_relaxed);
+    }
+
+private:
+    friend class ThreadPool;
+    
+    void submit(InlineTask&& task, size_t home);
+    
+    // Called once per task, after it ran (or was dropped at shutdown)
+    void finishOne() {
+        size_t left = pending_.load(std::memory_order_relaxed);
+        while (left > 1) {
+            if (pending_.compare_exchange_weak(left, left - 1, std::memory_order_acq_rel,
+                                               std::memory_order_relaxed)) {
+                return;
+            }
+        }
+        
+        // Possibly the last one: when wait() sees zero it takes the lock, so
+        // this task is done with the group before the group can go away
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (pending_.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+            done_.notify_all();
+        }
+    }
+    
+    ThreadPool& pool_;
+    alignas(64) std::atomic<size_t> pending_{0};
+    std::mutex mutex_;
+    std::condition_variable done_;
+};
+
 /**
  * Thread Pool with Work-Stealing Scheduler
  *
  * Each worker has its own local queue.
  * When a worker's queue is empty, it tries to steal from other workers.
+ *
+ * Local queues are lock-free Chase-Lev deques, which only the owning
+ * worker may push to. Submissions from any other thread go to the target
+ * worker's inbox, which the owner drains into its deque when it runs dry.
+ *
+ * Tasks are InlineTasks stored in recycled TaskNodes, so submitting and
+ * running tasks performs no heap allocation once the node pool is warm.
+ *
+ * Idle workers spin through a few steal rounds, then park on their own
+ * slot in an EventCount. Submitters only pay for a wakeup when a worker is
+ * actually parked.
+ *
+ * Each worker knows its own index through a thread-local, so tasks that
+ * resubmit themselves stay on the submitting worker's deque. submitAffine()
+ * pins a key (e.g. a matchId) to a home worker.
+ *
+ * A pool is one worker group: given a CPU affinity mask, every worker
+ * restricts itself to those CPUs (e.g. one NUMA node's) before running
+ * any task, so memory the workers first touch is allocated on that node.
+ *
+ * TaskGroup is the fork-join primitive: its tasks are counted apart from
+ * waitAll()'s, and waiting on a group runs queued tasks instead of
+ * blocking. parallelFor() is a loop built on one, with the caller taking
+ * part.
  */
 class ThreadPool {
 public:
-    using Task = std::function<void()>;
+    using Task = InlineTask;
+    
+    // Steal rounds (each yielding the CPU) before an idle worker parks
+    static constexpr size_t IDLE_SPIN_ROUNDS = 32;
+    
+    // Every N local pops the owner takes its oldest task and drains its inbox,
+    // so a task that keeps resubmitting itself cannot starve the rest
+    static constexpr size_t FAIRNESS_INTERVAL = 32;
     
-    explicit ThreadPool(size_t numThreads = std::thread::hardware_concurrency())
-        : running_(true)
+    explicit ThreadPool(size_t numThreads = std::thread::hardware_concurrency(), CpuSet affinity = {})
+        : numWorkers_(numThreads == 0 ? 1 : numThreads)
+        , affinity_(std::move(affinity))
+        , nodePool_(numWorkers_)
+        , parking_(numWorkers_)
+        , running_(true)
         , pendingTasks_(0)
         , stealCount_(0)
     {
-        if (numThreads == 0) {
-            numThreads = 1;
-        }
-        
-        numWorkers_ = numThreads;
-        
         // Create queues using unique_ptr (WorkStealingQueue is not movable)
         for (size_t i = 0; i < numWorkers_; ++i) {
-            localQueues_.push_back(std::make_unique<WorkStealingQueue<Task>>());
+            localQueues_.push_back(std::make_unique<WorkerQueue>());
         }
         
         // Start worker threads
@@ -54,19 +165,23 @@ public:
     
     /**
      * Submit a task to the pool
-     * Uses round-robin to distribute to worker queues
+     * From a worker: pushed to that worker's own deque (cache locality)
+     * From any other thread: round-robin across worker queues
      */
     void submit(Task task) {
         if (!running_) return;
         
         pendingTasks_.fetch_add(1, std::memory_order_relaxed);
         
-        // Round-robin distribution
-        size_t idx = nextQueue_.fetch_add(1, std::memory_order_relaxed) % numWorkers_;
-        localQueues_[idx]->pushBack(std::move(task));
+        size_t idx = callerIndex();
+        if (idx == TaskNodePool::NO_WORKER) {
+            // Round-robin distribution
+            idx = nextQueue_.fetch_add(1, std::memory_order_relaxed) % numWorkers_;
+        }
+        pushTask(idx, makeNode(std::move(task)));
         
-        // Wake up a worker
-        cv_.notify_one();
+        // Wake up a worker (no-op unless one is parked)
+        parking_.notifyOne();
     }
     
     /**
@@ -76,17 +191,95 @@ public:
         if (!running_ || workerId >= numWorkers_) return;
         
         pendingTasks_.fetch_add(1, std::memory_order_relaxed);
-        localQueues_[workerId]->pushBack(std::move(task));
-        cv_.notify_one();
+        pushTask(workerId, makeNode(std::move(task)));
+        parking_.notifyOne();
+    }
+    
+    /**
+     * Submit a task to the home worker of `key` (key % numWorkers)
+     * Affine tasks always go through the home worker's FIFO inbox, even when
+     * submitted by the home worker itself, so a task that re-pins itself
+     * yields to queued work instead of being popped straight back (LIFO).
+     * The task may still be stolen; getAffinityStats() reports how often
+     * affine tasks ran on their home worker
+     */
+    void submitAffine(size_t key, Task task) {
+        if (!running_) return;
+        
+        size_t home = homeWorkerFor(key);
+        pendingTasks_.fetch_add(1, std::memory_order_relaxed);
+        TaskNode* node = makeNode(std::move(task));
+        node->homeWorker = home;
+        pushToInbox(*localQueues_[home], node);
+        parking_.notifyOne();
+    }
+    
+    /**
+     * Home worker used by submitAffine() for a key
+     */
+    size_t homeWorkerFor(size_t key) const {
+        return key % numWorkers_;
+    }
+    
+    /**
+     * Index of the calling thread in this pool, or -1 if not a pool worker
+     */
+    int currentWorkerIndex() const {
+        size_t idx = callerIndex();
+        return idx == TaskNodePool::NO_WORKER ? -1 : static_cast<int>(idx);
+    }
+    
+    /**
+     * Run fn(i) for every i in [begin, end) in chunks of grain indices, on
+     * the pool and the calling thread; returns once every call is done
+     * Chunks are claimed in index order, so put the longest items first.
+     * The helpers form a TaskGroup, so the caller waits as TaskGroup::wait()
+     * does and this may be called from a pool task, nested or not.
+     * fn must not throw
+     */
+    template<typename Fn>
+    void parallelFor(size_t begin, size_t end, size_t grain, Fn&& fn) {
+        if (begin >= end) return;
+        
+        using Body = typename std::remove_reference<Fn>::type;
+        ForkJoinLoop loop;
+        loop.begin = begin;
+        loop.end = end;
+        loop.grain = std::max<size_t>(grain, 1);
+        loop.chunks = (end - begin + loop.grain - 1) / loop.grain;
+        loop.body = const_cast<void*>(static_cast<const void*>(&fn));
+        loop.invoke = [](void* body, size_t first, size_t last) {
+            Body& call = *static_cast<Body*>(body);
+            for (size_t i = first; i < last; ++i) {
+                call(i);
+            }
+        };
+        
+        // The caller is one of the participants
+        bool callerIsWorker = callerIndex() != TaskNodePool::NO_WORKER;
+        size_t helpers = std::min(loop.chunks - 1, callerIsWorker ? numWorkers_ - 1 : numWorkers_);
+        TaskGroup group(*this);
+        for (size_t h = 0; h < helpers; ++h) {
+            ForkJoinLoop* shared = &loop;
+            group.run([shared]() {
+                shared->runChunks();
+            });
+        }
+        
+        loop.runChunks();
+        
+        // Helpers hold a pointer to loop until they are done with it
+        group.wait();
     }
     
     /**
-     * Wait for all submitted tasks to complete
+     * Wait for all submitted tasks to complete (TaskGroup tasks excluded)
+     * Returns once shutdown() has discarded the tasks that never ran
      */
     void waitAll() {
-        std::unique_lock<std::mutex> lock(waitMutex_);
-        waitCv_.wait(lock, [this]() {
-            return pendingTasks_.load(std::memory_order_relaxed) == 0;
+        std::unique_lock<std::mutex> lock(completionMutex_);
+        completionCv_.wait(lock, [this]() {
+            return pendingTasks_.load(std::memory_order_acquire) == 0 || stopped_;
         });
     }
     
@@ -96,13 +289,31 @@ public:
     void shutdown() {
         if (!running_.exchange(false)) return;
         
-        cv_.notify_all();
+        parking_.notifyAll();
         
         for (auto& worker : workers_) {
             if (worker.joinable()) {
                 worker.join();
             }
         }
+        
+        // Destroy tasks that were still queued at shutdown
+        for (auto& queue : localQueues_) {
+            while (auto opt = queue->deque.tryPopBack()) {
+                discardNode(*opt);
+            }
+            while (TaskNode* node = queue->inboxHead) {
+                queue->inboxHead = node->next;
+                discardNode(node);
+            }
+            queue->inboxTail = nullptr;
+        }
+        
+        // A task submitted while stopping may miss the loop above: release
+        // every waiter regardless
+        std::lock_guard<std::mutex> lock(completionMutex_);
+        stopped_ = true;
+        completionCv_.notify_all();
     }
     
     /**
@@ -116,71 +327,463 @@ public:
     size_t getStealCount() const { 
         return stealCount_.load(std::memory_order_relaxed); 
     }
+    
+    /**
+     * Get task node allocation statistics (heap vs recycled)
+     */
+    TaskAllocationStats getTaskAllocationStats() const {
+        return nodePool_.getStats();
+    }
+    
+    /**
+     * Get number of times an idle worker parked (for statistics)
+     */
+    size_t getParkCount() const {
+        return parking_.getParkCount();
+    }
+    
+    /**
+     * Get number of wakeups delivered to parked workers (for statistics)
+     */
+    size_t getWakeCount() const {
+        return parking_.getWakeCount();
+    }
+    
+    /**
+     * Where affine tasks actually ran (for statistics)
+     */
+    struct AffinityStats {
+        size_t homeRuns;   // Ran on the home worker
+        size_t awayRuns;   // Stolen and run elsewhere
+    };
+    
+    AffinityStats getAffinityStats() const {
+        AffinityStats stats = {0, 0};
+        for (const auto& queue : localQueues_) {
+            stats.homeRuns += queue->homeRuns.load(std::memory_order_relaxed);
+            stats.awayRuns += queue->awayRuns.load(std::memory_order_relaxed);
+        }
+        return stats;
+    }
+    
+    /**
+     * CPU mask the workers were asked to keep to (empty: none)
+     */
+    const CpuSet& getAffinity() const {
+        return affinity_;
+    }
+    
+    /**
+     * Workers that restricted themselves to the mask (the rest failed or
+     * have not started yet)
+     */
+    size_t getPinnedWorkerCount() const {
+        return pinnedWorkers_.load(std::memory_order_relaxed);
+    }
 
 private:
+    friend class TaskGroup;
+    
+    /**
+     * Per-worker queues: lock-free deque for the owner plus a locked inbox
+     * for pushes coming from other threads
+     */
+    struct WorkerQueue {
+        WorkStealingQueue<TaskNode*> deque;
+        
+        // Intrusive FIFO through TaskNode::next (no allocation)
+        std::mutex inboxMutex;
+        TaskNode* inboxHead = nullptr;
+        TaskNode* inboxTail = nullptr;
+        std::atomic<size_t> inboxSize{0};
+        
+        // Affinity counters, written only by the owning worker
+        alignas(64) std::atomic<size_t> homeRuns{0};
+        std::atomic<size_t> awayRuns{0};
+    };
+    
+    /**
+     * Shared state of one parallelFor() (lives on the caller's stack)
+     */
+    struct ForkJoinLoop {
+        size_t begin = 0;
+        size_t end = 0;
+        size_t grain = 1;
+        size_t chunks = 0;
+        void* body = nullptr;
+        void (*invoke)(void*, size_t, size_t) = nullptr;
+        
+        alignas(64) std::atomic<size_t> nextChunk{0};
+        
+        // Claim and run chunks until none are left
+        void runChunks() {
+            for (;;) {
+                size_t chunk = nextChunk.fetch_add(1, std::memory_order_relaxed);
+                if (chunk >= chunks) return;
+                size_t first = begin + chunk * grain;
+                invoke(body, first, std::min(first + grain, end));
+            }
+        }
+    };
+    
+    /**
+     * Identity of the pool worker running on this thread (if any)
+     */
+    struct WorkerContext {
+        const ThreadPool* pool = nullptr;
+        size_t index = 0;
+    };
+    
+    static WorkerContext& currentWorker() {
+        static thread_local WorkerContext context;
+        return context;
+    }
+    
+    /**
+     * Index of the calling worker in this pool, or NO_WORKER
+     */
+    size_t callerIndex() const {
+        const WorkerContext& self = currentWorker();
+        return self.pool == this ? self.index : TaskNodePool::NO_WORKER;
+    }
+    
+    TaskNode* makeNode(Task&& task) {
+        TaskNode* node = nodePool_.acquire(callerIndex());
+        node->task = std::move(task);
+#ifdef PARA_ENABLE_METRICS
+        node->submitNs = metrics::sampledNow();
+#endif
+        return node;
+    }
+    
+    void recycleNode(TaskNode* node, size_t workerId) {
+        node->task.reset();
+        node->homeWorker = TaskNode::NO_HOME;
+        node->group = nullptr;
+        nodePool_.release(node, workerId);
+    }
+    
+    // A task that will never run still counts as finished (group or waitAll())
+    void discardNode(TaskNode* node) {
+        TaskGroup* group = node->group;
+        recycleNode(node, TaskNodePool::NO_WORKER);
+        if (group) {
+            group->finishOne();
+        } else {
+            finishPending();
+        }
+    }
+    
+    // Decrement pending count and signal waitAll() on completion
+    void finishPending() {
+        if (pendingTasks_.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+            std::lock_guard<std::mutex> lock(completionMutex_);
+            completionCv_.notify_all();
+        }
+    }
+    
+    /**
+     * Queue a TaskGroup task: like submit() or, with a home worker, like
+     * submitAffine(), but left out of pendingTasks_. False if stopped
+     */
+    bool submitGrouped(TaskGroup* group, Task&& task, size_t home) {
+        if (!running_) return false;
+        
+        TaskNode* node = makeNode(std::move(task));
+        node->group = group;
+        if (home != TaskNode::NO_HOME) {
+            node->homeWorker = home;
+            pushToInbox(*localQueues_[home], node);
+        } else {
+            size_t idx = callerIndex();
+            if (idx == TaskNodePool::NO_WORKER) {
+                idx = nextQueue_.fetch_add(1, std::memory_order_relaxed) % numWorkers_;
+            }
+            pushTask(idx, node);
+        }
+        parking_.notifyOne();
+        return true;
+    }
+    
+    void pushTask(size_t workerId, TaskNode* node) {
+        WorkerQueue& queue = *localQueues_[workerId];
+        
+        if (callerIndex() == workerId) {
+            // Owner fast path: lock-free
+            queue.deque.pushBack(node);
+        } else {
+            pushToInbox(queue, node);
+        }
+    }
+    
+    void pushToInbox(WorkerQueue& queue, TaskNode* node) {
+        std::lock_guard<std::mutex> lock(queue.inboxMutex);
+        node->next = nullptr;
+        if (queue.inboxTail) {
+            queue.inboxTail->next = node;
+        } else {
+            queue.inboxHead = node;
+        }
+        queue.inboxTail = node;
+        queue.inboxSize.fetch_add(1, std::memory_order_release);
+    }
+    
+    /**
+     * Move everything from the worker's inbox into its own deque (owner only)
+     */
+    void drainInbox(size_t workerId) {
+        WorkerQueue& queue = *localQueues_[workerId];
+        if (queue.inboxSize.load(std::memory_order_acquire) == 0) return;
+        
+        std::lock_guard<std::mutex> lock(queue.inboxMutex);
+        while (TaskNode* node = queue.inboxHead) {
+            queue.inboxHead = node->next;
+            node->next = nullptr;
+            queue.deque.pushBack(node);
+        }
+        queue.inboxTail = nullptr;
+        queue.inboxSize.store(0, std::memory_order_relaxed);
+    }
+    
+    /**
+     * Steal one task from a victim: deque first, then its inbox
+     */
+    TaskNode* trySteal(size_t victim) {
+        WorkerQueue& queue = *localQueues_[victim];
+        if (auto opt = queue.deque.tryPopFront()) {
+            return *opt;
+        }
+        if (queue.inboxSize.load(std::memory_order_acquire) > 0) {
+            std::lock_guard<std::mutex> lock(queue.inboxMutex);
+            if (TaskNode* node = queue.inboxHead) {
+                queue.inboxHead = node->next;
+                if (!queue.inboxHead) {
+                    queue.inboxTail = nullptr;
+                }
+                node->next = nullptr;
+                queue.inboxSize.fetch_sub(1, std::memory_order_relaxed);
+                return node;
+            }
+        }
+        return nullptr;
+    }
+    
+    void recordAffinity(size_t workerId, bool onHome) {
+        WorkerQueue& queue = *localQueues_[workerId];
+        std::atomic<size_t>& counter = onHome ? queue.homeRuns : queue.awayRuns;
+        counter.store(counter.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+    }
+    
+    /**
+     * True if any queue or inbox holds a task (approximate)
+     */
+    bool hasQueuedWork() const {
+        for (const auto& queue : localQueues_) {
+            if (!queue->deque.empty() || queue->inboxSize.load(std::memory_order_relaxed) > 0) {
+                return true;
+            }
+        }
+        return false;
+    }
+    
+    /**
+     * Run one queued task on the calling thread (a worker or not), if any:
+     * a worker's own deque and inbox first, then one pass over the others.
+     * Returns false if nothing was found
+     */
+    bool helpOnce() {
+        size_t self = callerIndex();
+        TaskNode* task = nullptr;
+        if (self != TaskNodePool::NO_WORKER) {
+            if (auto opt = localQueues_[self]->deque.tryPopBack()) {
+                task = *opt;
+            } else {
+                drainInbox(self);
+                if (auto refill = localQueues_[self]->deque.tryPopBack()) {
+                    task = *refill;
+                }
+            }
+        }
+        
+        size_t start = nextQueue_.fetch_add(1, std::memory_order_relaxed);
+        for (size_t i = 0; !task && i < numWorkers_; ++i) {
+            size_t victim = (start + i) % numWorkers_;
+            if (victim == self) continue;
+            task = trySteal(victim);
+            if (task) {
+                stealCount_.fetch_add(1, std::memory_order_relaxed);
+            }
+        }
+        if (!task) return false;
+        
+        runTask(task, self);
+        return true;
+    }
+    
+    /**
+     * Execute a task taken from a queue, recycle its node and signal
+     * waitAll() (or the task's group) if it was the last one
+     * (workerId may be NO_WORKER)
+     */
+    void runTask(TaskNode* task, size_t workerId) {
+        if (workerId != TaskNodePool::NO_WORKER && task->homeWorker != TaskNode::NO_HOME) {
+            recordAffinity(workerId, task->homeWorker == workerId);
+        }
+#ifdef PARA_ENABLE_METRICS
+        metrics::recordSince(metrics::Histogram::TASK_QUEUE_WAIT_NS, task->submitNs);
+        metrics::add(metrics::Counter::TASKS_RUN);
+#endif
+        TaskGroup* group = task->group;
+        task->task();
+        recycleNode(task, workerId);
+        if (group) {
+            group->finishOne();
+            return;
+        }
+        
+        finishPending();
+    }
+    
+    /**
+     * One scheduling round: local deque, own inbox, then random steals
+     */
+    TaskNode* findTask(size_t workerId, size_t& localPops, std::mt19937& rng,
+                       std::uniform_int_distribution<size_t>& dist) {
+        // 0. Periodic fairness: oldest local task first, inbox behind it
+        if (++localPops % FAIRNESS_INTERVAL == 0) {
+            drainInbox(workerId);
+            if (auto oldest = localQueues_[workerId]->deque.tryPopFront()) {
+                return *oldest;
+            }
+        }
+        
+        // 1. Try to get task from local queue (refilled from the inbox)
+        if (auto opt = localQueues_[workerId]->deque.tryPopBack()) {
+            return *opt;
+        }
+        drainInbox(workerId);
+        if (auto refill = localQueues_[workerId]->deque.tryPopBack()) {
+            return *refill;
+        }
+        
+        // 2. Try to steal from other workers
+        for (size_t attempts = 0; attempts < numWorkers_ * 2; ++attempts) {
+            size_t victim = dist(rng);
+            if (victim != workerId) {
+                if (TaskNode* task = trySteal(victim)) {
+                    stealCount_.fetch_add(1, std::memory_order_relaxed);
+                    return task;
+                }
+            }
+        }
+        return nullptr;
+    }
+    
     void workerFunction(size_t workerId) {
+        currentWorker() = WorkerContext{this, workerId};
+        if (!affinity_.empty() && pinCurrentThread(affinity_)) {
+            pinnedWorkers_.fetch_add(1, std::memory_order_relaxed);
+        }
+        
         // Random generator for victim selection
         std::mt19937 rng(static_cast<unsigned int>(workerId));
         std::uniform_int_distribution<size_t> dist(0, numWorkers_ - 1);
         
+        size_t idleRounds = 0;
+        size_t localPops = 0;
+        
         while (running_) {
-            Task task;
-            bool found = false;
-            
-            // 1. Try to get task from local queue
-            if (auto opt = localQueues_[workerId]->tryPopBack()) {
-                task = std::move(*opt);
-                found = true;
+            // Execute task if found
+            if (TaskNode* task = findTask(workerId, localPops, rng, dist)) {
+                idleRounds = 0;
+                runTask(task, workerId);
+                continue;
             }
             
-            // 2. Try to steal from other workers
-            if (!found) {
-                for (size_t attempts = 0; attempts < numWorkers_ * 2; ++attempts) {
-                    size_t victim = dist(rng);
-                    if (victim != workerId) {
-                        if (auto opt = localQueues_[victim]->tryPopFront()) {
-                            task = std::move(*opt);
-                            found = true;
-                            stealCount_.fetch_add(1, std::memory_order_relaxed);
-                            break;
-                        }
-                    }
-                }
+            // No work: spin briefly before parking
+            if (++idleRounds < IDLE_SPIN_ROUNDS) {
+                std::this_thread::yield();
+                continue;
             }
+            idleRounds = 0;
             
-            // 3. Execute task if found
-            if (found) {
-                task();
-                
-                // Decrement pending count and notify waiters
-                if (pendingTasks_.fetch_sub(1, std::memory_order_relaxed) == 1) {
-                    waitCv_.notify_all();
-                }
-            } else {
-                // 4. No work found, wait for new tasks
-                std::unique_lock<std::mutex> lock(waitMutex_);
-                cv_.wait_for(lock, std::chrono::microseconds(100), [this]() {
-                    return !running_ || pendingTasks_.load(std::memory_order_relaxed) > 0;
-                });
+            // Park: register, re-check for work, then sleep until notified
+            parking_.prepareWait(workerId);
+            if (!running_ || hasQueuedWork()) {
+                parking_.cancelWait(workerId);
+                continue;
             }
+            parking_.commitWait(workerId);
         }
+        
+        currentWorker() = WorkerContext{};
     }
 
 private:
     size_t numWorkers_;
+    CpuSet affinity_;        // Empty: workers may run anywhere
+    std::atomic<size_t> pinnedWorkers_{0};
+    TaskNodePool nodePool_;  // Declared before the queues: outlives every node
+    EventCount parking_;
     std::vector<std::thread> workers_;
-    std::vector<std::unique_ptr<WorkStealingQueue<Task>>> localQueues_;
+    std::vector<std::unique_ptr<WorkerQueue>> localQueues_;
     
     std::atomic<bool> running_;
     std::atomic<size_t> nextQueue_{0};
     std::atomic<size_t> pendingTasks_;
     std::atomic<size_t> stealCount_;
     
-    std::mutex waitMutex_;
-    std::condition_variable cv_;
-    std::condition_variable waitCv_;
+    // waitAll() completion signal (separate from worker parking)
+    std::mutex completionMutex_;
+    std::condition_variable completionCv_;
+    bool stopped_ = false;  // shutdown() is done (guarded by completionMutex_)
 };
 
+// ============================================
+// TaskGroup members that need the full ThreadPool
+// ============================================
+
+inline void TaskGroup::run(InlineTask task) {
+    submit(std::move(task), TaskNode::NO_HOME);
+}
+
+inline void TaskGroup::runAffine(size_t key, InlineTask task) {
+    submit(std::move(task), pool_.homeWorkerFor(key));
+}
+
+inline void TaskGroup::submit(InlineTask&& task, size_t home) {
+    // Counted first: the task may finish before submitGrouped() returns
+    pending_.fetch_add(1, std::memory_order_relaxed);
+    if (!pool_.submitGrouped(this, std::move(task), home)) {
+        finishOne();
+    }
+}
+
+inline void TaskGroup::wait() {
+    size_t idleRounds = 0;
+    while (pending_.load(std::memory_order_acquire) != 0) {
+        if (pool_.helpOnce()) {
+            idleRounds = 0;
+            continue;
+        }
+        
+        // A worker keeps looking (its own deque may refill); any other
+        // thread has nothing to give up, so it sleeps
+        if (++idleRounds < ThreadPool::IDLE_SPIN_ROUNDS || pool_.callerIndex() != TaskNodePool::NO_WORKER) {
+            std::this_thread::yield();
+            continue;
+        }
+        std::unique_lock<std::mutex> lock(mutex_);
+        done_.wait(lock, [this]() {
+            return pending_.load(std::memory_order_acquire) == 0;
+        });
+        return;
+    }
+    
+    // The last task dropped the count under the lock: wait for it to let go
+    std::lock_guard<std::mutex> lock(mutex_);
+}
+
 } // namespace para
 
 #endif // THREAD_POOL_HPP
\ No newline at end of file
@@ -1,93 +1,196 @@
 #ifndef WORK_STEALING_QUEUE_HPP
 #define WORK_STEALING_QUEUE_HPP
 
-#include <deque>
-#include <mutex>
 #include <atomic>
+#include <cstdint>
+#include <memory>
 #include <optional>
+#include <type_traits>
+#include <vector>
 
 namespace para {
 
 /**
- * Work-Stealing Queue
- * 
- * Thread-safe deque that supports:
- * - pushBack / popBack: Used by owner thread (LIFO for better cache locality)
- * - popFront (steal): Used by other threads to steal work (FIFO)
- * 
- * The owner pushes and pops from the back (like a stack)
- * Thieves steal from the front (oldest tasks first)
+ * Work-Stealing Queue (lock-free Chase-Lev deque)
+ *
+ * Growable circular deque following Chase & Lev (SPAA'05) with the
+ * memory orderings of Le et al. (PPoPP'13):
+ * - pushBack / tryPopBack: Owner thread only (LIFO for better cache locality)
+ * - tryPopFront (steal): Any thread (FIFO, oldest tasks first)
+ *
+ * The owner never performs an atomic read-modify-write except when it
+ * races a thief for the last element. Thieves claim items with a single CAS
+ * on top_.
+ *
+ * T must be trivially copyable (pointers, indices, handles) because a thief
+ * may read a slot that is concurrently being recycled; the read is only
+ * kept if its CAS wins.
  */
 template<typename T>
 class WorkStealingQueue {
+    static_assert(std::is_trivially_copyable<T>::value,
+                  "WorkStealingQueue stores items in atomic slots; use pointers or handles");
+
 public:
-    WorkStealingQueue() = default;
-    
-    // Non-copyable, non-movable (due to mutex)
+    explicit WorkStealingQueue(size_t initialCapacity = 256)
+        : buffer_(new Buffer(roundUpToPowerOfTwo(initialCapacity)))
+    {
+    }
+
+    ~WorkStealingQueue() {
+        delete buffer_.load(std::memory_order_relaxed);
+    }
+
+    // Non-copyable, non-movable (thieves hold raw pointers to it)
     WorkStealingQueue(const WorkStealingQueue&) = delete;
     WorkStealingQueue& operator=(const WorkStealingQueue&) = delete;
     WorkStealingQueue(WorkStealingQueue&&) = delete;
     WorkStealingQueue& operator=(WorkStealingQueue&&) = delete;
-    
+
     /**
-     * Push a task to the back of the queue (owner only)
+     * Push an item to the back of the queue (owner only)
+     * Grows the buffer when full; never blocks
      */
     void pushBack(T item) {
-        std::lock_guard<std::mutex> lock(mutex_);
-        deque_.push_back(std::move(item));
-        size_.fetch_add(1, std::memory_order_relaxed);
+        int64_t b = bottom_.load(std::memory_order_relaxed);
+        int64_t t = top_.load(std::memory_order_acquire);
+        Buffer* buf = buffer_.load(std::memory_order_relaxed);
+
+        if (b - t > buf->capacity - 1) {
+            buf = grow(buf, t, b);
+        }
+
+        buf->store(b, item);
+        std::atomic_thread_fence(std::memory_order_release);
+        bottom_.store(b + 1, std::memory_order_relaxed);
     }
-    
+
     /**
-     * Try to pop a task from the back (owner only)
-     * Returns nullopt if queue is empty
+     * Try to pop an item from the back (owner only)
+     * Returns nullopt if queue is empty or a thief won the last item
      */
     std::optional<T> tryPopBack() {
-        std::lock_guard<std::mutex> lock(mutex_);
-        if (deque_.empty()) {
+        int64_t b = bottom_.load(std::memory_order_relaxed) - 1;
+        Buffer* buf = buffer_.load(std::memory_order_relaxed);
+        bottom_.store(b, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        int64_t t = top_.load(std::memory_order_relaxed);
+
+        if (t > b) {
+            // Empty: restore bottom
+            bottom_.store(b + 1, std::memory_order_relaxed);
             return std::nullopt;
         }
-        T item = std::move(deque_.back());
-        deque_.pop_back();
-        size_.fetch_sub(1, std::memory_order_relaxed);
+
+        T item = buf->load(b);
+        if (t == b) {
+            // Last element: race against thieves
+            bool won = top_.compare_exchange_strong(t, t + 1,
+                                                    std::memory_order_seq_cst,
+                                                    std::memory_order_relaxed);
+            bottom_.store(b + 1, std::memory_order_relaxed);
+            if (!won) {
+                return std::nullopt;
+            }
+        }
         return item;
     }
-    
+
     /**
-     * Try to steal a task from the front (thieves)
-     * Returns nullopt if queue is empty
+     * Try to steal an item from the front (thieves)
+     * Returns nullopt if queue is empty or the CAS lost to another thread
      */
     std::optional<T> tryPopFront() {
-        std::lock_guard<std::mutex> lock(mutex_);
-        if (deque_.empty()) {
+        int64_t t = top_.load(std::memory_order_acquire);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        int64_t b = bottom_.load(std::memory_order_acquire);
+
+        if (t >= b) {
+            return std::nullopt;
+        }
+
+        Buffer* buf = buffer_.load(std::memory_order_acquire);
+        T item = buf->load(t);
+        if (!top_.compare_exchange_strong(t, t + 1,
+                                          std::memory_order_seq_cst,
+                                          std::memory_order_relaxed)) {
             return std::nullopt;
         }
-        T item = std::move(deque_.front());
-        deque_.pop_front();
-        size_.fetch_sub(1, std::memory_order_relaxed);
         return item;
     }
-    
+
     /**
      * Check if queue is empty (approximate)
      */
     bool empty() const {
-        return size_.load(std::memory_order_relaxed) == 0;
+        return size() == 0;
     }
-    
+
     /**
      * Get approximate size
      */
     size_t size() const {
-        return size_.load(std::memory_order_relaxed);
+        int64_t b = bottom_.load(std::memory_order_relaxed);
+        int64_t t = top_.load(std::memory_order_relaxed);
+        return b > t ? static_cast<size_t>(b - t) : 0;
+    }
+
+    /**
+     * Current buffer capacity (owner only, for statistics)
+     */
+    size_t capacity() const {
+        return static_cast<size_t>(buffer_.load(std::memory_order_relaxed)->capacity);
+    }
+
+private:
+    struct Buffer {
+        explicit Buffer(int64_t cap)
+            : capacity(cap)
+            , mask(cap - 1)
+            , slots(new std::atomic<T>[static_cast<size_t>(cap)])
+        {
+        }
+
+        T load(int64_t index) const {
+            return slots[index & mask].load(std::memory_order_relaxed);
+        }
+
+        void store(int64_t index, T item) {
+            slots[index & mask].store(item, std::memory_order_relaxed);
+        }
+
+        int64_t capacity;
+        int64_t mask;
+        std::unique_ptr<std::atomic<T>[]> slots;
+    };
+
+    Buffer* grow(Buffer* old, int64_t top, int64_t bottom) {
+        Buffer* bigger = new Buffer(old->capacity * 2);
+        for (int64_t i = top; i < bottom; ++i) {
+            bigger->store(i, old->load(i));
+        }
+        // Thieves may still be reading the old buffer: retire it instead of freeing
+        retired_.emplace_back(old);
+        buffer_.store(bigger, std::memory_order_release);
+        return bigger;
+    }
+
+    static int64_t roundUpToPowerOfTwo(size_t n) {
+        int64_t cap = 2;
+        while (cap < static_cast<int64_t>(n)) {
+            cap <<= 1;
+        }
+        return cap;
     }
 
 private:
-    std::deque<T> deque_;
-    mutable std::mutex mutex_;
-    std::atomic<size_t> size_{0};
+    // top_ and bottom_ on separate cache lines: thieves hammer top_, owner bottom_
+    alignas(64) std::atomic<int64_t> top_{0};
+    alignas(64) std::atomic<int64_t> bottom_{0};
+    alignas(64) std::atomic<Buffer*> buffer_;
+    std::vector<std::unique_ptr<Buffer>> retired_;  // Owner only
 };
 
 } // namespace para
 
-#endif // WORK_STEALING_QUEUE_HPP
\ No newline at end of file
+#endif // WORK_STEALING_QUEUE_HPP